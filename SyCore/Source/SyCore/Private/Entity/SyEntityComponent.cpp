@@ -222,13 +222,13 @@ void USyEntityComponent::BindComponentDelegates()
     if (StateComponent)
     {
         // 先移除旧的绑定（如果有的话），防止重复绑定
-        StateComponent->OnEffectiveStateChanged.RemoveAll(this);
+        StateComponent->OnEffectiveStateTagsChanged.RemoveAll(this);
         // 添加新的绑定 - EntityComponent 也需要监听状态变化
-        StateComponent->OnEffectiveStateChanged.AddUObject(this, &USyEntityComponent::HandleLocalStateDataChanged);
+        StateComponent->OnEffectiveStateTagsChanged.AddUObject(this, &USyEntityComponent::HandleLocalStateDataChanged);
     }
 }
 
-void USyEntityComponent::HandleLocalStateDataChanged()
+void USyEntityComponent::HandleLocalStateDataChanged(const FSyEffectiveStateChange& Change)
 {
     // 广播实体状态已更新事件
     OnEntityStateUpdated.Broadcast();
@@ -3,9 +3,13 @@
 #include "State/Types/StateContainerTypes.h"
 #include "State/Types/StateParameterTypes.h"
 #include "State/Types/StateMetadataTypes.h"
-#include "DS_TagMetadata.h"
+#include "State/StateTagSchema.h"
+#include "State/StateMetadataPool.h"
+#include "State/StateSharedLayer.h"
 #include "Logging/LogMacros.h"
 #include "UObject/Package.h"
+#include "UObject/UnrealType.h"
+#include "Serialization/StructuredArchiveAdapters.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogSyStateCategories, Log, All);
 
@@ -46,7 +50,7 @@ static USyStateMetadataBase* FindOrAddLocalMetadataInstance(FSyStateMetadatas& L
 
 void FSyStateCategories::ApplyInitData(const FSyStateParameterSet& InitData)
 {
-    Empty(); // Clear existing data first
+    ReleaseAllMetadata(); // Clear existing data first
 
     // Iterate through InitData map {Tag -> Array<FInstancedStruct>}
     for (const auto& Pair : InitData.GetParametersAsMap())
@@ -54,28 +58,26 @@ void FSyStateCategories::ApplyInitData(const FSyStateParameterSet& InitData)
         const FGameplayTag& StateTag = Pair.Key;
         const TArray<FInstancedStruct>& InitParamsForTag = Pair.Value;
 
-        // Get the TEMPLATE metadata objects defined for this tag (defines expected TYPES)
-        TArray<UO_TagMetadata*> TemplateInstances = UDS_TagMetadata::GetTagMetadata(StateTag); // Assuming this returns correct templates
+        // Get the cached schema for this tag (expected metadata classes and value TYPES)
+        const TSharedRef<const FSyStateTagSchema> Schema = FSyStateTagSchemaCache::Get().FindOrBuild(StateTag);
 
         FSyStateMetadatas& CurrentMetadatas = StateData.FindOrAdd(StateTag);
         CurrentMetadatas.MetadataArray.Empty(); // Start fresh for this tag
 
-        // Iterate through the TEMPLATE types expected for this tag
-        for (UO_TagMetadata* TemplateInstance : TemplateInstances)
+        // Iterate through the types expected for this tag
+        for (const FSyStateTagSchema::FSlot& Slot : Schema->Slots)
         {
-            USyStateMetadataBase* TemplateMetadata = Cast<USyStateMetadataBase>(TemplateInstance);
-            if (!TemplateMetadata) continue;
+            UClass* ExpectedMetadataClass = Slot.MetadataClass;
+            const UScriptStruct* ExpectedValueType = Slot.ValueType;
 
-            UClass* ExpectedMetadataClass = TemplateMetadata->GetClass();
-            UScriptStruct* ExpectedValueType = TemplateMetadata->GetValueDataType();
-
-            // Create a NEW instance of the correct metadata CLASS for this tag
-            USyStateMetadataBase* NewMetadataInstance = NewObject<USyStateMetadataBase>(GetTransientPackage(), ExpectedMetadataClass); // Need Outer?
+            // Take an instance of the correct metadata CLASS for this tag from the pool
+            USyStateMetadataBase* NewMetadataInstance = AcquireMetadata(ExpectedMetadataClass);
             if (!NewMetadataInstance)
             {
                 UE_LOG(LogSyStateCategories, Error, TEXT("ApplyInitData: Failed to create metadata object of class %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
                 continue;
             }
+            NewMetadataInstance->SetStateTag(StateTag);
 
             // Find the corresponding initialization parameter from the input data
             const FInstancedStruct* FoundInitParam = InitParamsForTag.FindByPredicate(
@@ -114,83 +116,137 @@ void FSyStateCategories::UpdateFromParameterMap(const TMap<FGameplayTag, TArray<
     }
     for (const FGameplayTag& Tag : TagsToRemove)
     {
-        StateData.Remove(Tag);
+        ReleaseStateMetadata(Tag);
         UE_LOG(LogSyStateCategories, Verbose, TEXT("UpdateFromParameterMap: Removing state tag %s."), *Tag.ToString());
     }
 
     // 2. Iterate through the aggregated map to update existing tags or add new ones
     for (const auto& AggregatedPair : AggregatedParamsMap)
     {
-        const FGameplayTag& StateTag = AggregatedPair.Key;
-        const TArray<FInstancedStruct>& NewParamsForTag = AggregatedPair.Value;
-
-        // Get the TEMPLATE metadata objects defined for this tag (defines expected TYPES)
-        TArray<UO_TagMetadata*> TemplateInstances = UDS_TagMetadata::GetTagMetadata(StateTag); // Assuming this returns correct templates
+        AddOrUpdateMetadataParam(AggregatedPair.Key, AggregatedPair.Value);
+    }
+}
 
-        FSyStateMetadatas& CurrentMetadatas = StateData.FindOrAdd(StateTag);
-        TArray<TObjectPtr<UO_TagMetadata>> OldMetadataObjects = CurrentMetadatas.MetadataArray; // Keep track of old objects
-        TArray<TObjectPtr<UO_TagMetadata>> NewMetadataArray; // Build the new list for this tag
-        TSet<int32> UsedOldIndices; // Track which old objects were updated/reused
+void FSyStateCategories::AddOrUpdateMetadataParam(const FGameplayTag& StateTag, const TArray<FInstancedStruct>& NewParamsForTag)
+{
+    // Get the cached schema for this tag (expected metadata classes and value TYPES)
+    const TSharedRef<const FSyStateTagSchema> Schema = FSyStateTagSchemaCache::Get().FindOrBuild(StateTag);
 
-        // Iterate through the TEMPLATE types expected for this tag
-        for (UO_TagMetadata* TemplateInstance : TemplateInstances)
-        {
-            USyStateMetadataBase* TemplateMetadata = Cast<USyStateMetadataBase>(TemplateInstance);
-            if (!TemplateMetadata) continue;
+    FSyStateMetadatas& CurrentMetadatas = StateData.FindOrAdd(StateTag);
+    TArray<TObjectPtr<UO_TagMetadata>> OldMetadataObjects = CurrentMetadatas.MetadataArray; // Keep track of old objects
+    TArray<TObjectPtr<UO_TagMetadata>> NewMetadataArray; // Build the new list for this tag
+    TSet<int32> UsedOldIndices; // Track which old objects were updated/reused
 
-            UClass* ExpectedMetadataClass = TemplateMetadata->GetClass();
-            UScriptStruct* ExpectedValueType = TemplateMetadata->GetValueDataType();
+    // Iterate through the types expected for this tag
+    for (const FSyStateTagSchema::FSlot& Slot : Schema->Slots)
+    {
+        UClass* ExpectedMetadataClass = Slot.MetadataClass;
+        const UScriptStruct* ExpectedValueType = Slot.ValueType;
 
-            // Find the corresponding aggregated parameter from the input map for this specific type
-            const FInstancedStruct* FoundAggregatedParam = NewParamsForTag.FindByPredicate(
-                [&ExpectedValueType](const FInstancedStruct& Param) {
-                    return Param.IsValid() && Param.GetScriptStruct() == ExpectedValueType;
-                });
+        // Find the corresponding aggregated parameter from the input map for this specific type
+        const FInstancedStruct* FoundAggregatedParam = NewParamsForTag.FindByPredicate(
+            [&ExpectedValueType](const FInstancedStruct& Param) {
+                return Param.IsValid() && Param.GetScriptStruct() == ExpectedValueType;
+            });
 
-            if (FoundAggregatedParam) // A value for this type exists in the aggregated state
+        if (FoundAggregatedParam) // A value for this type exists in the aggregated state
+        {
+            // Try to find an existing local instance of the correct class
+            UO_TagMetadata* ExistingInstanceToUpdate = nullptr;
+            int32 FoundOldIndex = INDEX_NONE;
+            for(int32 i = 0; i < OldMetadataObjects.Num(); ++i)
             {
-                // Try to find an existing local instance of the correct class
-                UO_TagMetadata* ExistingInstanceToUpdate = nullptr;
-                int32 FoundOldIndex = INDEX_NONE;
-                for(int32 i = 0; i < OldMetadataObjects.Num(); ++i)
+                // Check if the index hasn't been used and the object is valid and of the correct CLASS
+                if (!UsedOldIndices.Contains(i) && OldMetadataObjects[i] && OldMetadataObjects[i]->IsA(ExpectedMetadataClass))
                 {
-                    // Check if the index hasn't been used and the object is valid and of the correct CLASS
-                    if (!UsedOldIndices.Contains(i) && OldMetadataObjects[i] && OldMetadataObjects[i]->IsA(ExpectedMetadataClass))
-                    {
-                        ExistingInstanceToUpdate = OldMetadataObjects[i];
-                        FoundOldIndex = i;
-                        break;
-                    }
+                    ExistingInstanceToUpdate = OldMetadataObjects[i];
+                    FoundOldIndex = i;
+                    break;
                 }
+            }
 
-                if (ExistingInstanceToUpdate) // Reuse existing instance
-                {
-                    Cast<USyStateMetadataBase>(ExistingInstanceToUpdate)->SetValueStruct(*FoundAggregatedParam);
-                    NewMetadataArray.Add(ExistingInstanceToUpdate); // Add the updated instance to the new list
-                    UsedOldIndices.Add(FoundOldIndex); // Mark index as used
-                    UE_LOG(LogSyStateCategories, Verbose, TEXT("UpdateFromParameterMap: Updated existing metadata %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
-                }
-                else // Create new instance
-                {
-                    USyStateMetadataBase* NewMetadataInstance = NewObject<USyStateMetadataBase>(GetTransientPackage(), ExpectedMetadataClass); // Need Outer?
-                    if (NewMetadataInstance)
-                    {
-                        NewMetadataInstance->SetValueStruct(*FoundAggregatedParam);
-                        NewMetadataArray.Add(NewMetadataInstance); // Add the new instance to the new list
-                        UE_LOG(LogSyStateCategories, Verbose, TEXT("UpdateFromParameterMap: Created new metadata %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
-                    }
-                    else { UE_LOG(LogSyStateCategories, Error, TEXT("UpdateFromParameterMap: Failed to create metadata %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString()); }
-                }
+            if (ExistingInstanceToUpdate) // Reuse existing instance
+            {
+                Cast<USyStateMetadataBase>(ExistingInstanceToUpdate)->SetValueStruct(*FoundAggregatedParam);
+                NewMetadataArray.Add(ExistingInstanceToUpdate); // Add the updated instance to the new list
+                UsedOldIndices.Add(FoundOldIndex); // Mark index as used
+                UE_LOG(LogSyStateCategories, Verbose, TEXT("AddOrUpdateMetadataParam: Updated existing metadata %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
             }
-            else // No aggregated value for this type exists (e.g., due to unloading).
+            else // Take a new instance from the pool
             {
-                 // Simply don't add any instance of this ExpectedMetadataClass to NewMetadataArray.
-                 // Any existing instance in OldMetadataObjects of this class that isn't reused will be GC'd.
-                 UE_LOG(LogSyStateCategories, Verbose, TEXT("UpdateFromParameterMap: No aggregated value for metadata type %s for tag %s. Instance (if any) removed/reset."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
+                USyStateMetadataBase* NewMetadataInstance = AcquireMetadata(ExpectedMetadataClass);
+                if (NewMetadataInstance)
+                {
+                    NewMetadataInstance->SetStateTag(StateTag);
+                    NewMetadataInstance->SetValueStruct(*FoundAggregatedParam);
+                    NewMetadataArray.Add(NewMetadataInstance); // Add the new instance to the new list
+                    UE_LOG(LogSyStateCategories, Verbose, TEXT("AddOrUpdateMetadataParam: Created new metadata %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
+                }
+                else { UE_LOG(LogSyStateCategories, Error, TEXT("AddOrUpdateMetadataParam: Failed to create metadata %s for tag %s."), *ExpectedMetadataClass->GetName(), *StateTag.ToString()); }
             }
         }
-        // Replace the old metadata array for this tag with the newly constructed one
-        CurrentMetadatas.MetadataArray = NewMetadataArray;
+        else // No aggregated value for this type exists (e.g., due to unloading).
+        {
+             // Simply don't add any instance of this ExpectedMetadataClass to NewMetadataArray.
+             // Any existing instance in OldMetadataObjects of this class that isn't reused is returned to the pool below.
+             UE_LOG(LogSyStateCategories, Verbose, TEXT("AddOrUpdateMetadataParam: No aggregated value for metadata type %s for tag %s. Instance (if any) removed/reset."), *ExpectedMetadataClass->GetName(), *StateTag.ToString());
+        }
+    }
+    // Replace the old metadata array for this tag with the newly constructed one
+    CurrentMetadatas.MetadataArray = NewMetadataArray;
+
+    // Return instances whose type disappeared (e.g. an unloaded buff) to the pool
+    for (int32 i = 0; i < OldMetadataObjects.Num(); ++i)
+    {
+        if (!UsedOldIndices.Contains(i))
+        {
+            ReleaseMetadata(OldMetadataObjects[i]);
+        }
+    }
+}
+
+void FSyStateCategories::ReleaseStateMetadata(const FGameplayTag& StateTag)
+{
+    FSyStateMetadatas RemovedMetadatas;
+    if (StateData.RemoveAndCopyValue(StateTag, RemovedMetadatas))
+    {
+        for (const TObjectPtr<UO_TagMetadata>& Metadata : RemovedMetadatas.MetadataArray)
+        {
+            ReleaseMetadata(Metadata);
+        }
+    }
+}
+
+void FSyStateCategories::ReleaseAllMetadata()
+{
+    for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : StateData)
+    {
+        for (const TObjectPtr<UO_TagMetadata>& Metadata : Pair.Value.MetadataArray)
+        {
+            ReleaseMetadata(Metadata);
+        }
+    }
+    StateData.Empty();
+    AcquiredMetadata.Reset();
+    bMetadataHandedOut = false;
+}
+
+USyStateMetadataBase* FSyStateCategories::AcquireMetadata(UClass* MetadataClass)
+{
+    USyStateMetadataBase* Metadata = FSyStateMetadataPool::Get().Acquire(MetadataClass);
+    if (Metadata)
+    {
+        AcquiredMetadata.Add(Metadata);
+    }
+    return Metadata;
+}
+
+void FSyStateCategories::ReleaseMetadata(UO_TagMetadata* Metadata)
+{
+    // 已交给外部的对象可能仍被持有，复用后会读到其它实体的状态：交给 GC
+    if (Metadata && AcquiredMetadata.Remove(Metadata) > 0 && !bMetadataHandedOut)
+    {
+        FSyStateMetadataPool::Get().Release(Metadata);
     }
 }
 
@@ -206,43 +262,444 @@ void FSyStateCategories::MergeWith(const FSyStateCategories& Other)
     }
 }
 
-bool FSyStateCategories::Serialize(FArchive& Ar)
+namespace SyStateCategoriesFormat
 {
-	// 标记我们正在处理自定义序列化
-	if (Ar.IsLoading())
+	/** 旧格式以非负的条目数开头，紧凑格式以该标记开头 */
+	static constexpr int32 CompactMarker = -1;
+
+	static constexpr uint8 InitialVersion = 1;
+	/** 值类型表带属性结构，载荷按属性分段：布局变化后按属性名读取仍匹配的字段 */
+	static constexpr uint8 PropertySchemaVersion = 2;
+	static constexpr uint8 Version = PropertySchemaVersion;
+
+	/** 值结构体的一个属性（类型表中每个值类型只写一次） */
+	struct FSavedProperty
+	{
+		FString Name;
+		FString Type;
+		int32 ArrayDim = 1;
+
+		friend FArchive& operator<<(FArchive& Ar, FSavedProperty& Property)
+		{
+			return Ar << Property.Name << Property.Type << Property.ArrayDim;
+		}
+	};
+
+	static FString GetPropertyType(const FProperty* Property)
+	{
+		FString ExtendedType;
+		const FString Type = Property->GetCPPType(&ExtendedType);
+		return Type + ExtendedType;
+	}
+
+	static TArray<FSavedProperty> GetPropertySchema(const UScriptStruct* ValueType)
+	{
+		TArray<FSavedProperty> Schema;
+		for (TFieldIterator<FProperty> It(ValueType); It; ++It)
+		{
+			Schema.Add({ It->GetName(), GetPropertyType(*It), It->ArrayDim });
+		}
+		return Schema;
+	}
+
+	/** 属性结构的摘要：由名称字符串计算，跨进程、编辑器与 Cook 版本稳定 */
+	static uint32 GetLayoutHash(const TArray<FSavedProperty>& Schema)
+	{
+		uint32 Hash = 0;
+		for (const FSavedProperty& Property : Schema)
+		{
+			Hash = FCrc::StrCrc32(*Property.Name, Hash);
+			Hash = FCrc::StrCrc32(*Property.Type, Hash);
+			Hash = FCrc::MemCrc32(&Property.ArrayDim, sizeof(Property.ArrayDim), Hash);
+		}
+		return Hash;
+	}
+
+	/** 读取时使用的值类型：存档中的每个属性对应到当前类型的属性（不再存在或类型不同时为空，读取时跳过） */
+	struct FLoadedValueType
+	{
+		UScriptStruct* Type = nullptr;
+		TArray<const FProperty*> Properties;
+	};
+
+	static FLoadedValueType ResolveValueLayout(UScriptStruct* ValueType, const TArray<FSavedProperty>& SavedSchema, uint32 SavedLayoutHash)
+	{
+		FLoadedValueType Loaded;
+		Loaded.Type = ValueType;
+		Loaded.Properties.Reserve(SavedSchema.Num());
+
+		const TArray<FSavedProperty> CurrentSchema = GetPropertySchema(ValueType);
+		if (GetLayoutHash(CurrentSchema) == SavedLayoutHash && CurrentSchema.Num() == SavedSchema.Num())
+		{
+			for (TFieldIterator<FProperty> It(ValueType); It; ++It)
+			{
+				Loaded.Properties.Add(*It);
+			}
+			return Loaded;
+		}
+
+		int32 NumMatched = 0;
+		for (const FSavedProperty& Saved : SavedSchema)
+		{
+			const FProperty* Property = ValueType->FindPropertyByName(FName(*Saved.Name));
+			if (Property && Property->ArrayDim == Saved.ArrayDim && GetPropertyType(Property) == Saved.Type)
+			{
+				++NumMatched;
+			}
+			else
+			{
+				Property = nullptr;
+			}
+			Loaded.Properties.Add(Property);
+		}
+
+		UE_LOG(LogSyStateCategories, Log, TEXT("Serialize (Load): Layout of value type %s changed since save, %d of %d saved fields loaded by name"),
+			*ValueType->GetPathName(), NumMatched, SavedSchema.Num());
+		return Loaded;
+	}
+
+	/** 写出带字节数前缀的一段数据：字节数在写完后回填（不支持定位的归档只用于统计 / 校验，不会被读回） */
+	static void SaveSized(FArchive& Ar, TFunctionRef<void()> SaveBody)
+	{
+		int32 Size = 0;
+		const int64 SizeOffset = Ar.Tell();
+		Ar << Size;
+		const int64 Start = Ar.Tell();
+
+		SaveBody();
+
+		if (SizeOffset != INDEX_NONE)
+		{
+			const int64 End = Ar.Tell();
+			Size = static_cast<int32>(End - Start);
+			Ar.Seek(SizeOffset);
+			Ar << Size;
+			Ar.Seek(End);
+		}
+	}
+
+	static void SerializeProperty(FArchive& Ar, const FProperty* Property, void* StructMemory)
+	{
+		FStructuredArchiveFromArchive StructuredAr(Ar);
+		Property->SerializeBinProperty(StructuredAr.GetSlot(), StructMemory);
+	}
+
+	/** 解析类型表中的路径（先查找已加载的对象） */
+	template<typename T>
+	static T* ResolveType(const FString& Path)
+	{
+		if (Path.IsEmpty())
+		{
+			return nullptr;
+		}
+		T* Type = FindObject<T>(nullptr, *Path);
+		return Type ? Type : LoadObject<T>(nullptr, *Path);
+	}
+
+	/** 要写出的一个元数据对象 */
+	struct FSavedMetadata
+	{
+		UO_TagMetadata* Metadata = nullptr;
+		int32 ClassIndex = INDEX_NONE;
+		int32 StructIndex = INDEX_NONE;
+		FInstancedStruct Value;
+	};
+
+	/** 跳过无法读取的载荷 */
+	static void SkipPayload(FArchive& Ar, int64 PayloadStart, int32 PayloadSize)
+	{
+		if (PayloadStart == INDEX_NONE)
+		{
+			Ar.SetError();
+			return;
+		}
+		Ar.Seek(PayloadStart + PayloadSize);
+	}
+
+	/**
+	 * 紧凑格式：
+	 *   Marker, Version
+	 *   类表 [路径]，值类型表 [路径, 布局摘要, [属性名, 属性类型, 数组长度]]
+	 *   条目 [Tag, [类下标, 值类型下标, 载荷字节数, 载荷]]
+	 * 有值类型的元数据载荷为各属性的 [字节数, 二进制值]（属性名只在类型表中写一次），
+	 * 其它元数据为完整的 UObject::Serialize
+	 */
+	static void SaveCompact(FArchive& Ar, const TMap<FGameplayTag, FSyStateMetadatas>& StateData)
+	{
+		TArray<UClass*> Classes;
+		TMap<UClass*, int32> ClassIndices;
+		TArray<UScriptStruct*> Structs;
+		TMap<UScriptStruct*, int32> StructIndices;
+
+		TArray<TArray<FSavedMetadata>> SavedEntries;
+		SavedEntries.Reserve(StateData.Num());
+		for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : StateData)
+		{
+			TArray<FSavedMetadata>& SavedMetadatas = SavedEntries.AddDefaulted_GetRef();
+			SavedMetadatas.Reserve(Pair.Value.MetadataArray.Num());
+			for (const TObjectPtr<UO_TagMetadata>& MetadataPtr : Pair.Value.MetadataArray)
+			{
+				FSavedMetadata& Saved = SavedMetadatas.AddDefaulted_GetRef();
+				Saved.Metadata = MetadataPtr;
+				if (!Saved.Metadata)
+				{
+					UE_LOG(LogSyStateCategories, Warning, TEXT("Serialize (Save): Null metadata object in tag %s"), *Pair.Key.ToString());
+					continue;
+				}
+
+				UClass* MetadataClass = Saved.Metadata->GetClass();
+				const int32* ClassIndex = ClassIndices.Find(MetadataClass);
+				Saved.ClassIndex = ClassIndex ? *ClassIndex : ClassIndices.Add(MetadataClass, Classes.Add(MetadataClass));
+
+				if (const USyStateMetadataBase* StateMetadata = Cast<USyStateMetadataBase>(Saved.Metadata))
+				{
+					Saved.Value = StateMetadata->GetValueStruct();
+					if (UScriptStruct* ValueType = const_cast<UScriptStruct*>(Saved.Value.GetScriptStruct()))
+					{
+						const int32* StructIndex = StructIndices.Find(ValueType);
+						Saved.StructIndex = StructIndex ? *StructIndex : StructIndices.Add(ValueType, Structs.Add(ValueType));
+					}
+				}
+			}
+		}
+
+		int32 Marker = CompactMarker;
+		uint8 FormatVersion = Version;
+		Ar << Marker;
+		Ar << FormatVersion;
+
+		int32 NumClasses = Classes.Num();
+		Ar << NumClasses;
+		for (UClass* MetadataClass : Classes)
+		{
+			FString ClassPath = MetadataClass->GetPathName();
+			Ar << ClassPath;
+		}
+
+		int32 NumStructs = Structs.Num();
+		Ar << NumStructs;
+		for (UScriptStruct* ValueType : Structs)
+		{
+			FString StructPath = ValueType->GetPathName();
+			TArray<FSavedProperty> Schema = GetPropertySchema(ValueType);
+			uint32 LayoutHash = GetLayoutHash(Schema);
+			Ar << StructPath;
+			Ar << LayoutHash;
+			Ar << Schema;
+		}
+
+		int32 NumEntries = StateData.Num();
+		Ar << NumEntries;
+
+		int32 EntryIndex = 0;
+		for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : StateData)
+		{
+			FGameplayTag Tag = Pair.Key;
+			Ar << Tag;
+
+			TArray<FSavedMetadata>& SavedMetadatas = SavedEntries[EntryIndex++];
+			int32 NumMetadata = SavedMetadatas.Num();
+			Ar << NumMetadata;
+
+			for (FSavedMetadata& Saved : SavedMetadatas)
+			{
+				Ar << Saved.ClassIndex;
+				Ar << Saved.StructIndex;
+
+				SaveSized(Ar, [&Ar, &Saved, &Structs]()
+				{
+					if (Saved.StructIndex != INDEX_NONE)
+					{
+						// 按属性分段写出，布局变化后仍可逐个字段读取或跳过
+						for (TFieldIterator<FProperty> It(Structs[Saved.StructIndex]); It; ++It)
+						{
+							const FProperty* Property = *It;
+							SaveSized(Ar, [&Ar, Property, &Saved]()
+							{
+								SerializeProperty(Ar, Property, Saved.Value.GetMutableMemory());
+							});
+						}
+					}
+					else if (Saved.Metadata)
+					{
+						Saved.Metadata->Serialize(Ar);
+					}
+				});
+			}
+		}
+
+		UE_LOG(LogSyStateCategories, Verbose, TEXT("Serialize (Save): Saved %d state categories (%d classes, %d value types)"), NumEntries, NumClasses, NumStructs);
+	}
+
+	static void LoadCompact(FArchive& Ar, TMap<FGameplayTag, FSyStateMetadatas>& StateData)
 	{
-		// 加载时：读取序列化的数据
+		uint8 FormatVersion = 0;
+		Ar << FormatVersion;
+		if (FormatVersion > Version)
+		{
+			UE_LOG(LogSyStateCategories, Error, TEXT("Serialize (Load): Unsupported state format version %d (latest %d)"), FormatVersion, Version);
+			Ar.SetError();
+			return;
+		}
+
+		// 每个类 / 值类型只解析一次路径
+		int32 NumClasses = 0;
+		Ar << NumClasses;
+		TArray<UClass*> Classes;
+		Classes.Reserve(FMath::Max(NumClasses, 0));
+		for (int32 i = 0; i < NumClasses && !Ar.IsError(); ++i)
+		{
+			FString ClassPath;
+			Ar << ClassPath;
+			UClass* MetadataClass = ResolveType<UClass>(ClassPath);
+			if (!MetadataClass || !MetadataClass->IsChildOf(UO_TagMetadata::StaticClass()))
+			{
+				UE_LOG(LogSyStateCategories, Error, TEXT("Serialize (Load): Failed to load metadata class: %s"), *ClassPath);
+				MetadataClass = nullptr;
+			}
+			Classes.Add(MetadataClass);
+		}
+
+		int32 NumStructs = 0;
+		Ar << NumStructs;
+		TArray<FLoadedValueType> Structs;
+		Structs.Reserve(FMath::Max(NumStructs, 0));
+		for (int32 i = 0; i < NumStructs && !Ar.IsError(); ++i)
+		{
+			FString StructPath;
+			uint32 LayoutHash = 0;
+			Ar << StructPath;
+			Ar << LayoutHash;
+
+			TArray<FSavedProperty> Schema;
+			if (FormatVersion >= PropertySchemaVersion)
+			{
+				Ar << Schema;
+			}
+
+			FLoadedValueType& Loaded = Structs.AddDefaulted_GetRef();
+			UScriptStruct* ValueType = ResolveType<UScriptStruct>(StructPath);
+			if (!ValueType)
+			{
+				UE_LOG(LogSyStateCategories, Error, TEXT("Serialize (Load): Failed to load value type: %s"), *StructPath);
+			}
+			else if (FormatVersion < PropertySchemaVersion)
+			{
+				// 版本 1 的载荷为不分段的 SerializeBin，其布局摘要不可跨进程比较，无法确认布局一致
+				UE_LOG(LogSyStateCategories, Warning, TEXT("Serialize (Load): Values of type %s saved in state format version %d are skipped"), *StructPath, FormatVersion);
+			}
+			else
+			{
+				Loaded = ResolveValueLayout(ValueType, Schema, LayoutHash);
+			}
+		}
+
 		int32 NumEntries = 0;
 		Ar << NumEntries;
-		
+		StateData.Empty(FMath::Max(NumEntries, 0));
+
+		for (int32 i = 0; i < NumEntries && !Ar.IsError(); ++i)
+		{
+			FGameplayTag Tag;
+			Ar << Tag;
+
+			int32 NumMetadata = 0;
+			Ar << NumMetadata;
+
+			FSyStateMetadatas& Metadatas = StateData.Add(Tag);
+			Metadatas.MetadataArray.Empty(FMath::Max(NumMetadata, 0));
+
+			for (int32 j = 0; j < NumMetadata && !Ar.IsError(); ++j)
+			{
+				int32 ClassIndex = INDEX_NONE;
+				int32 StructIndex = INDEX_NONE;
+				int32 PayloadSize = 0;
+				Ar << ClassIndex;
+				Ar << StructIndex;
+				Ar << PayloadSize;
+				const int64 PayloadStart = Ar.Tell();
+
+				UClass* MetadataClass = Classes.IsValidIndex(ClassIndex) ? Classes[ClassIndex] : nullptr;
+				if (!MetadataClass)
+				{
+					SkipPayload(Ar, PayloadStart, PayloadSize);
+					continue;
+				}
+
+				if (StructIndex == INDEX_NONE)
+				{
+					UO_TagMetadata* NewMetadata = NewObject<UO_TagMetadata>(GetTransientPackage(), MetadataClass);
+					NewMetadata->Serialize(Ar);
+					Metadatas.MetadataArray.Add(NewMetadata);
+					continue;
+				}
+
+				const FLoadedValueType* ValueType = Structs.IsValidIndex(StructIndex) ? &Structs[StructIndex] : nullptr;
+				if (!ValueType || !ValueType->Type || !MetadataClass->IsChildOf(USyStateMetadataBase::StaticClass()))
+				{
+					SkipPayload(Ar, PayloadStart, PayloadSize);
+					continue;
+				}
+
+				// 存档中不再匹配的字段被跳过，当前类型新增的字段保持默认值
+				FInstancedStruct Value;
+				Value.InitializeAs(ValueType->Type);
+				for (const FProperty* Property : ValueType->Properties)
+				{
+					int32 PropertySize = 0;
+					Ar << PropertySize;
+					const int64 PropertyStart = Ar.Tell();
+					if (Property)
+					{
+						SerializeProperty(Ar, Property, Value.GetMutableMemory());
+					}
+					if (!Property || (PropertyStart != INDEX_NONE && Ar.Tell() != PropertyStart + PropertySize))
+					{
+						SkipPayload(Ar, PropertyStart, PropertySize);
+					}
+				}
+
+				USyStateMetadataBase* NewMetadata = FSyStateMetadataPool::Get().Acquire(MetadataClass);
+				NewMetadata->SetStateTag(Tag);
+				NewMetadata->SetValueStruct(Value);
+				Metadatas.MetadataArray.Add(NewMetadata);
+			}
+		}
+
+		UE_LOG(LogSyStateCategories, Verbose, TEXT("Serialize (Load): Loaded %d state categories (%d classes, %d value types)"), NumEntries, NumClasses, NumStructs);
+	}
+
+	/** 旧格式：每个元数据对象写出类路径与完整的 UObject::Serialize */
+	static void LoadLegacy(FArchive& Ar, int32 NumEntries, TMap<FGameplayTag, FSyStateMetadatas>& StateData)
+	{
 		StateData.Empty(NumEntries);
-		
+
 		for (int32 i = 0; i < NumEntries; ++i)
 		{
 			// 读取 GameplayTag
 			FGameplayTag Tag;
 			Ar << Tag;
-			
+
 			// 读取元数据数组大小
 			int32 NumMetadata = 0;
 			Ar << NumMetadata;
-			
+
 			FSyStateMetadatas& Metadatas = StateData.Add(Tag);
 			Metadatas.MetadataArray.Empty(NumMetadata);
-			
+
 			// 读取每个元数据对象
 			for (int32 j = 0; j < NumMetadata; ++j)
 			{
 				// 读取对象类路径
 				FString ClassPath;
 				Ar << ClassPath;
-				
+
 				if (ClassPath.IsEmpty())
 				{
 					UE_LOG(LogSyStateCategories, Warning, TEXT("Serialize (Load): Empty class path for metadata object %d in tag %s"), j, *Tag.ToString());
 					continue;
 				}
-				
+
 				// 尝试加载类
 				UClass* MetadataClass = LoadObject<UClass>(nullptr, *ClassPath);
 				if (!MetadataClass)
@@ -250,7 +707,7 @@ bool FSyStateCategories::Serialize(FArchive& Ar)
 					UE_LOG(LogSyStateCategories, Error, TEXT("Serialize (Load): Failed to load metadata class: %s"), *ClassPath);
 					continue;
 				}
-				
+
 				// 创建新的元数据对象
 				UO_TagMetadata* NewMetadata = NewObject<UO_TagMetadata>(GetTransientPackage(), MetadataClass);
 				if (!NewMetadata)
@@ -258,59 +715,58 @@ bool FSyStateCategories::Serialize(FArchive& Ar)
 					UE_LOG(LogSyStateCategories, Error, TEXT("Serialize (Load): Failed to create metadata object of class %s"), *ClassPath);
 					continue;
 				}
-				
+
 				// 序列化对象的属性
 				NewMetadata->Serialize(Ar);
-				
+
 				// 添加到数组
 				Metadatas.MetadataArray.Add(NewMetadata);
 			}
 		}
-		
-		UE_LOG(LogSyStateCategories, Verbose, TEXT("Serialize (Load): Loaded %d state categories with total metadata objects"), NumEntries);
+
+		UE_LOG(LogSyStateCategories, Verbose, TEXT("Serialize (Load): Loaded %d legacy state categories"), NumEntries);
 	}
-	else if (Ar.IsSaving())
+}
+
+bool FSyStateCategories::Serialize(FArchive& Ar)
+{
+	if (Ar.IsLoading())
 	{
-		// 保存时：写入序列化数据
-		int32 NumEntries = StateData.Num();
-		Ar << NumEntries;
-		
-		for (const auto& Pair : StateData)
+		// 旧存档以条目数开头，紧凑格式以负数标记开头
+		int32 Header = 0;
+		Ar << Header;
+		if (Header == SyStateCategoriesFormat::CompactMarker)
 		{
-			// 写入 GameplayTag
-			FGameplayTag Tag = Pair.Key;
-			Ar << Tag;
-			
-			// 写入元数据数组大小
-			const FSyStateMetadatas& Metadatas = Pair.Value;
-			int32 NumMetadata = Metadatas.MetadataArray.Num();
-			Ar << NumMetadata;
-			
-			// 写入每个元数据对象
-			for (const TObjectPtr<UO_TagMetadata>& MetadataPtr : Metadatas.MetadataArray)
+			SyStateCategoriesFormat::LoadCompact(Ar, StateData);
+		}
+		else if (Header >= 0)
+		{
+			SyStateCategoriesFormat::LoadLegacy(Ar, Header, StateData);
+		}
+		else
+		{
+			UE_LOG(LogSyStateCategories, Error, TEXT("Serialize (Load): Unknown state format header %d"), Header);
+			Ar.SetError();
+		}
+
+		// 读档创建的对象都归本集合所有
+		AcquiredMetadata.Reset();
+		for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : StateData)
+		{
+			for (const TObjectPtr<UO_TagMetadata>& Metadata : Pair.Value.MetadataArray)
 			{
-				if (MetadataPtr)
-				{
-					// 写入对象类路径
-					FString ClassPath = MetadataPtr->GetClass()->GetPathName();
-					Ar << ClassPath;
-					
-					// 序列化对象的属性
-					MetadataPtr->Serialize(Ar);
-				}
-				else
+				if (Metadata)
 				{
-					// Null 对象 - 写入空字符串
-					FString EmptyPath;
-					Ar << EmptyPath;
-					UE_LOG(LogSyStateCategories, Warning, TEXT("Serialize (Save): Null metadata object in tag %s"), *Tag.ToString());
+					AcquiredMetadata.Add(Metadata.Get());
 				}
 			}
 		}
-		
-		UE_LOG(LogSyStateCategories, Verbose, TEXT("Serialize (Save): Saved %d state categories"), NumEntries);
 	}
-	
+	else if (Ar.IsSaving())
+	{
+		SyStateCategoriesFormat::SaveCompact(Ar, StateData);
+	}
+
 	return true;
 }
 
@@ -344,86 +800,641 @@ void FSyStateCategories::PostSerialize(const FArchive& Ar)
 
 // --- FSyLayeredStateContainer Implementation ---
 
+void FSyLayeredStateContainer::SetPackedValueStorage(bool bEnable)
+{
+	if (bPackedValues == bEnable)
+	{
+		return;
+	}
+
+	ClearAllLayers();
+	CachedEffectiveState.ReleaseAllMetadata();
+	bPackedValues = bEnable;
+}
+
 FSyStateCategories& FSyLayeredStateContainer::GetLayer(ESyStateLayer Layer)
 {
-	return StateLayers.FindOrAdd(Layer);
+	ensureMsgf(!bPackedValues, TEXT("FSyLayeredStateContainer::GetLayer: writable layer access is not supported with packed value storage."));
+
+	// 可写引用可能被任意修改，无法得知涉及哪些标签
+	MakeLayerPrivate(Layer);
+	InvalidateCache(Layer);
+	return StateLayers[ToLayerIndex(Layer)];
 }
 
 const FSyStateCategories& FSyLayeredStateContainer::GetLayer(ESyStateLayer Layer) const
 {
-	static const FSyStateCategories EmptyState;
-	if (const FSyStateCategories* Found = StateLayers.Find(Layer))
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	if (bPackedValues && bLayerViewDirty[LayerIndex])
+	{
+		// 按需生成元数据视图（复用已有的元数据对象）
+		const FSyStateValueArena& Values = GetLayerValues(LayerIndex);
+		TArray<FGameplayTag> Tags;
+		Values.GetTags(Tags);
+
+		TMap<FGameplayTag, TArray<FInstancedStruct>> ParamsMap;
+		ParamsMap.Reserve(Tags.Num());
+		for (const FGameplayTag& StateTag : Tags)
+		{
+			Values.GetValues(StateTag, ParamsMap.Add(StateTag));
+		}
+
+		const_cast<FSyStateCategories&>(StateLayers[LayerIndex]).UpdateFromParameterMap(ParamsMap);
+		bLayerViewDirty[LayerIndex] = false;
+	}
+	return bPackedValues ? StateLayers[LayerIndex] : GetLayerState(LayerIndex);
+}
+
+bool FSyLayeredStateContainer::GetLayerTagValues(ESyStateLayer Layer, const FGameplayTag& StateTag, TArray<FInstancedStruct>& OutValues) const
+{
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	if (bPackedValues)
 	{
-		return *Found;
+		return GetLayerValues(LayerIndex).GetValues(StateTag, OutValues);
+	}
+
+	const FSyStateMetadatas* Metadatas = GetLayerState(LayerIndex).GetStateDataMap().Find(StateTag);
+	if (!Metadatas)
+	{
+		return false;
+	}
+	for (const TObjectPtr<UO_TagMetadata>& MetaPtr : Metadatas->MetadataArray)
+	{
+		if (const USyStateMetadataBase* Metadata = Cast<USyStateMetadataBase>(MetaPtr))
+		{
+			OutValues.Add(Metadata->GetValueStruct());
+		}
 	}
-	return EmptyState;
+	return true;
 }
 
 void FSyLayeredStateContainer::SetLayer(ESyStateLayer Layer, const FSyStateCategories& NewState)
 {
-	StateLayers.FindOrAdd(Layer) = NewState;
-	InvalidateCache();
+	if (bPackedValues)
+	{
+		const int32 LayerIndex = ToLayerIndex(Layer);
+		MarkPackedLayerTagsDirty(Layer);
+		MarkLayerTagsDirty(Layer, NewState);
+		if (IsLayerShared(LayerIndex))
+		{
+			SharedDefaultLayer.Reset();
+		}
+		LayerValues[LayerIndex].Reset();
+		for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : NewState.GetStateDataMap())
+		{
+			TArray<FInstancedStruct> Values;
+			for (const TObjectPtr<UO_TagMetadata>& MetaPtr : Pair.Value.MetadataArray)
+			{
+				if (const USyStateMetadataBase* Metadata = Cast<USyStateMetadataBase>(MetaPtr))
+				{
+					Values.Add(Metadata->GetValueStruct());
+				}
+			}
+			LayerValues[LayerIndex].SetValues(Pair.Key, Values);
+		}
+		return;
+	}
+
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	MarkLayerTagsDirty(Layer, GetLayerState(LayerIndex));
+	MarkLayerTagsDirty(Layer, NewState);
+	if (IsLayerShared(LayerIndex))
+	{
+		SharedDefaultLayer.Reset();
+	}
+	StateLayers[LayerIndex] = NewState;
 }
 
 void FSyLayeredStateContainer::ClearLayer(ESyStateLayer Layer)
 {
-	if (StateLayers.Remove(Layer) > 0)
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	if (bPackedValues)
 	{
-		InvalidateCache();
+		MarkPackedLayerTagsDirty(Layer);
+		LayerValues[LayerIndex].Reset();
+	}
+	else
+	{
+		MarkLayerTagsDirty(Layer, GetLayerState(LayerIndex));
+		StateLayers[LayerIndex].ReleaseAllMetadata();
+	}
+
+	// 共享层只释放引用，其元数据对象仍被其它容器使用
+	if (IsLayerShared(LayerIndex))
+	{
+		SharedDefaultLayer.Reset();
 	}
 }
 
-FSyStateCategories FSyLayeredStateContainer::GetEffectiveState() const
+const FSyStateCategories& FSyLayeredStateContainer::GetEffectiveState() const
 {
-	// 检查缓存是否有效
-	if (CacheVersion == CurrentVersion)
+	if (bPackedValues)
 	{
+		// 紧凑存储：只为被读取的有效状态生成元数据对象
+		TArray<FGameplayTag> TagsToUpdate;
+		if (bCacheFullyDirty)
+		{
+			TSet<FGameplayTag> AllTags;
+			for (int32 LayerIndex = 0; LayerIndex < (int32)ESyStateLayer::MAX; ++LayerIndex)
+			{
+				TArray<FGameplayTag> LayerTags;
+				GetLayerValues(LayerIndex).GetTags(LayerTags);
+				AllTags.Append(LayerTags);
+			}
+			for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : CachedEffectiveState.GetStateDataMap())
+			{
+				AllTags.Add(Pair.Key);
+			}
+			TagsToUpdate = AllTags.Array();
+		}
+		else
+		{
+			TagsToUpdate = DirtyTags.Array();
+		}
+
+		for (const FGameplayTag& StateTag : TagsToUpdate)
+		{
+			const int32 WinningLayer = FindWinningLayer(StateTag);
+			if (WinningLayer == INDEX_NONE)
+			{
+				CachedEffectiveState.ReleaseStateMetadata(StateTag);
+				continue;
+			}
+
+			TArray<FInstancedStruct> Values;
+			GetLayerValues(WinningLayer).GetValues(StateTag, Values);
+			CachedEffectiveState.AddOrUpdateMetadataParam(StateTag, Values);
+		}
+		bCacheFullyDirty = false;
+		DirtyTags.Reset();
 		return CachedEffectiveState;
 	}
 
-	// 重新计算有效状态
-	FSyStateCategories Result;
-	
-	// 按优先级从低到高合并 (Default < Persistent < Temporary < Override)
-	for (int32 LayerIndex = 0; LayerIndex < (int32)ESyStateLayer::MAX; ++LayerIndex)
+	if (bCacheFullyDirty)
 	{
-		ESyStateLayer CurrentLayer = static_cast<ESyStateLayer>(LayerIndex);
-		if (const FSyStateCategories* LayerState = StateLayers.Find(CurrentLayer))
+		// 整体重建：按优先级从低到高合并 (Default < Persistent < Temporary < Override)
+		CachedEffectiveState.Empty();
+		for (int32 LayerIndex = 0; LayerIndex < (int32)ESyStateLayer::MAX; ++LayerIndex)
 		{
-			Result.MergeWith(*LayerState);
+			CachedEffectiveState.MergeWith(GetLayerState(LayerIndex));
 		}
+		bCacheFullyDirty = false;
+		DirtyTags.Reset();
+		return CachedEffectiveState;
 	}
 
-	// 更新缓存
-	CachedEffectiveState = Result;
-	CacheVersion = CurrentVersion;
+	// 增量：只重算被修改过的标签
+	for (const FGameplayTag& StateTag : DirtyTags)
+	{
+		if (const FSyStateMetadatas* Metadatas = FindEffectiveMetadatas(StateTag))
+		{
+			CachedEffectiveState.StateData.FindOrAdd(StateTag) = *Metadatas;
+		}
+		else
+		{
+			CachedEffectiveState.ReleaseStateMetadata(StateTag);
+		}
+	}
+	DirtyTags.Reset();
+	return CachedEffectiveState;
+}
 
-	return Result;
+void FSyLayeredStateContainer::MarkMetadataHandedOut() const
+{
+	// 非紧凑存储的有效状态直接引用各层的对象，各层一并标记
+	for (const FSyStateCategories& LayerState : StateLayers)
+	{
+		LayerState.MarkMetadataHandedOut();
+	}
+	CachedEffectiveState.MarkMetadataHandedOut();
 }
 
-bool FSyLayeredStateContainer::HasDataInLayer(ESyStateLayer Layer) const
+const FSyStateMetadatas* FSyLayeredStateContainer::FindEffectiveMetadatas(const FGameplayTag& StateTag) const
+{
+	if (bPackedValues)
+	{
+		// 紧凑存储没有逐层的元数据对象，从按需生成的有效状态中查找
+		return GetEffectiveState().GetStateDataMap().Find(StateTag);
+	}
+
+	// 合并时高层级整体替换同名标签，因此从高到低第一个包含该标签的层即为最终结果
+	for (int32 LayerIndex = (int32)ESyStateLayer::MAX - 1; LayerIndex >= 0; --LayerIndex)
+	{
+		if (const FSyStateMetadatas* Metadatas = GetLayerState(LayerIndex).GetStateDataMap().Find(StateTag))
+		{
+			return Metadatas;
+		}
+	}
+	return nullptr;
+}
+
+const void* FSyLayeredStateContainer::FindEffectivePackedValue(const FGameplayTag& StateTag, const UScriptStruct* ValueType) const
+{
+	if (!bPackedValues)
+	{
+		return nullptr;
+	}
+	const int32 WinningLayer = FindWinningLayer(StateTag);
+	return WinningLayer != INDEX_NONE ? GetLayerValues(WinningLayer).FindValue(StateTag, ValueType) : nullptr;
+}
+
+bool FSyLayeredStateContainer::GetEffectiveValue(const FGameplayTag& StateTag, const UScriptStruct* ValueType, FInstancedStruct& OutValue) const
+{
+	if (bPackedValues)
+	{
+		if (const void* Value = FindEffectivePackedValue(StateTag, ValueType))
+		{
+			OutValue.InitializeAs(ValueType, static_cast<const uint8*>(Value));
+			return true;
+		}
+		return false;
+	}
+
+	if (const FSyStateMetadatas* Metadatas = FindEffectiveMetadatas(StateTag))
+	{
+		for (const TObjectPtr<UO_TagMetadata>& MetaPtr : Metadatas->MetadataArray)
+		{
+			const USyStateMetadataBase* Metadata = Cast<USyStateMetadataBase>(MetaPtr);
+			if (Metadata && Metadata->GetValueDataType() == ValueType)
+			{
+				OutValue = Metadata->GetValueStruct();
+				return OutValue.IsValid();
+			}
+		}
+	}
+	return false;
+}
+
+bool FSyLayeredStateContainer::GetFirstEffectiveValue(const FGameplayTag& StateTag, FInstancedStruct& OutValue) const
 {
-	if (const FSyStateCategories* LayerState = StateLayers.Find(Layer))
+	if (bPackedValues)
 	{
-		return !LayerState->GetStateDataMap().IsEmpty();
+		const int32 WinningLayer = FindWinningLayer(StateTag);
+		TArray<FInstancedStruct> Values;
+		if (WinningLayer != INDEX_NONE && GetLayerValues(WinningLayer).GetValues(StateTag, Values) && Values.Num() > 0)
+		{
+			OutValue = MoveTemp(Values[0]);
+			return true;
+		}
+		return false;
+	}
+
+	if (const FSyStateMetadatas* Metadatas = FindEffectiveMetadatas(StateTag))
+	{
+		for (const TObjectPtr<UO_TagMetadata>& MetaPtr : Metadatas->MetadataArray)
+		{
+			if (const USyStateMetadataBase* Metadata = Cast<USyStateMetadataBase>(MetaPtr))
+			{
+				OutValue = Metadata->GetValueStruct();
+				if (OutValue.IsValid())
+				{
+					return true;
+				}
+			}
+		}
 	}
 	return false;
 }
 
+bool FSyLayeredStateContainer::HasDataInLayer(ESyStateLayer Layer) const
+{
+	if (bPackedValues)
+	{
+		return !GetLayerValues(ToLayerIndex(Layer)).IsEmpty();
+	}
+	return !GetLayerState(ToLayerIndex(Layer)).GetStateDataMap().IsEmpty();
+}
+
 void FSyLayeredStateContainer::ClearAllLayers()
 {
-	StateLayers.Empty();
+	for (FSyStateCategories& LayerState : StateLayers)
+	{
+		LayerState.ReleaseAllMetadata();
+	}
+	for (FSyStateValueArena& Values : LayerValues)
+	{
+		Values.Reset();
+	}
+	SharedDefaultLayer.Reset();
 	InvalidateCache();
 }
 
 void FSyLayeredStateContainer::ApplyParameterSetToLayer(ESyStateLayer Layer, const FSyStateParameterSet& ParamSet)
 {
-	FSyStateCategories& LayerState = GetLayer(Layer);
-	LayerState.UpdateFromParameterMap(ParamSet.GetParametersAsMap());
-	InvalidateCache();
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	const TMap<FGameplayTag, TArray<FInstancedStruct>> ParamsMap = ParamSet.GetParametersAsMap();
+
+	// 整层替换：不拷贝共享层，直接在空的私有存储上重建
+	if (IsLayerShared(LayerIndex))
+	{
+		if (bPackedValues)
+		{
+			MarkPackedLayerTagsDirty(Layer);
+		}
+		else
+		{
+			MarkLayerTagsDirty(Layer, GetLayerState(LayerIndex));
+		}
+		SharedDefaultLayer.Reset();
+	}
+
+	if (bPackedValues)
+	{
+		// 与 UpdateFromParameterMap 一致：移除参数集中没有的标签
+		TArray<FGameplayTag> ExistingTags;
+		LayerValues[LayerIndex].GetTags(ExistingTags);
+		for (const FGameplayTag& StateTag : ExistingTags)
+		{
+			if (!ParamsMap.Contains(StateTag))
+			{
+				LayerValues[LayerIndex].RemoveTag(StateTag);
+				MarkTagDirty(Layer, StateTag);
+			}
+		}
+		for (const TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : ParamsMap)
+		{
+			SetPackedTagValues(LayerValues[LayerIndex], Pair.Key, Pair.Value);
+			MarkTagDirty(Layer, Pair.Key);
+		}
+		return;
+	}
+
+	// UpdateFromParameterMap 会移除参数集中没有的标签：原有标签与新标签都需要重算
+	FSyStateCategories& LayerState = StateLayers[LayerIndex];
+	MarkLayerTagsDirty(Layer, LayerState);
+
+	for (const TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : ParamsMap)
+	{
+		MarkTagDirty(Layer, Pair.Key);
+	}
+	LayerState.UpdateFromParameterMap(ParamsMap);
+}
+
+void FSyLayeredStateContainer::ApplyTagParamsToLayer(ESyStateLayer Layer, const FGameplayTag& StateTag, const TArray<FInstancedStruct>& Params)
+{
+	if (!StateTag.IsValid())
+	{
+		return;
+	}
+
+	MakeLayerPrivate(Layer);
+	if (bPackedValues)
+	{
+		SetPackedTagValues(LayerValues[ToLayerIndex(Layer)], StateTag, Params);
+	}
+	else
+	{
+		StateLayers[ToLayerIndex(Layer)].AddOrUpdateMetadataParam(StateTag, Params);
+	}
+	MarkTagDirty(Layer, StateTag);
+}
+
+void FSyLayeredStateContainer::RemoveTagFromLayer(ESyStateLayer Layer, const FGameplayTag& StateTag)
+{
+	if (LayerContainsTag(ToLayerIndex(Layer), StateTag))
+	{
+		MakeLayerPrivate(Layer);
+	}
+
+	bool bRemoved = false;
+	if (bPackedValues)
+	{
+		bRemoved = LayerValues[ToLayerIndex(Layer)].RemoveTag(StateTag);
+	}
+	else
+	{
+		FSyStateCategories& LayerState = StateLayers[ToLayerIndex(Layer)];
+		bRemoved = LayerState.GetStateDataMap().Contains(StateTag);
+		LayerState.ReleaseStateMetadata(StateTag);
+	}
+	if (bRemoved)
+	{
+		MarkTagDirty(Layer, StateTag);
+	}
 }
 
-void FSyLayeredStateContainer::InvalidateCache()
+bool FSyLayeredStateContainer::ConsumeEffectiveChanges(FSyEffectiveStateChange& OutChange)
 {
-	++CurrentVersion;
+	OutChange = FSyEffectiveStateChange();
+	OutChange.ChangedLayers = PendingChangedLayers;
+	OutChange.bAllTags = bPendingAllTags;
+
+	if (!bPendingAllTags)
+	{
+		for (const TPair<FGameplayTag, uint8>& Pair : PendingChangedTags)
+		{
+			// 胜出层高于所有被修改的层时，有效值没有变化
+			const int32 WinningLayer = FindWinningLayer(Pair.Key);
+			if (WinningLayer == INDEX_NONE || (Pair.Value >> WinningLayer) != 0)
+			{
+				OutChange.ChangedTags.AddTag(Pair.Key);
+			}
+		}
+	}
+
+	PendingChangedTags.Reset();
+	PendingChangedLayers = 0;
+	bPendingAllTags = false;
+	return !OutChange.IsEmpty();
+}
+
+void FSyLayeredStateContainer::PostSerialize(const FArchive& Ar)
+{
+	if (Ar.IsLoading())
+	{
+		// 读入了 Default 层的数据时，以读入的为准
+		if (!StateLayers[(int32)ESyStateLayer::Default].GetStateDataMap().IsEmpty())
+		{
+			SharedDefaultLayer.Reset();
+		}
+		InvalidateCache();
+	}
+}
+
+void FSyLayeredStateContainer::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	if (!bPackedValues)
+	{
+		return;
+	}
+
+	for (FSyStateValueArena& Values : LayerValues)
+	{
+		Values.AddReferencedObjects(Collector);
+	}
+
+	// 按需生成的有效状态元数据对象只由非 UPROPERTY 的缓存持有
+	for (TPair<FGameplayTag, FSyStateMetadatas>& Pair : CachedEffectiveState.StateData)
+	{
+		Collector.AddReferencedObjects(Pair.Value.MetadataArray);
+	}
+}
+
+bool FSyLayeredStateContainer::LayerContainsTag(int32 LayerIndex, const FGameplayTag& StateTag) const
+{
+	return bPackedValues
+		? GetLayerValues(LayerIndex).Contains(StateTag)
+		: GetLayerState(LayerIndex).GetStateDataMap().Contains(StateTag);
+}
+
+int32 FSyLayeredStateContainer::FindWinningLayer(const FGameplayTag& StateTag) const
+{
+	for (int32 LayerIndex = (int32)ESyStateLayer::MAX - 1; LayerIndex >= 0; --LayerIndex)
+	{
+		if (LayerContainsTag(LayerIndex, StateTag))
+		{
+			return LayerIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void FSyLayeredStateContainer::SetPackedTagValues(FSyStateValueArena& Values, const FGameplayTag& StateTag, const TArray<FInstancedStruct>& Params)
+{
+	// 只保留结构描述中声明的值类型，按描述的顺序排列
+	const TSharedRef<const FSyStateTagSchema> Schema = FSyStateTagSchemaCache::Get().FindOrBuild(StateTag);
+
+	TArray<FInstancedStruct, TInlineAllocator<4>> FilteredParams;
+	for (const FSyStateTagSchema::FSlot& Slot : Schema->Slots)
+	{
+		const UScriptStruct* ExpectedValueType = Slot.ValueType;
+		if (const FInstancedStruct* Found = Params.FindByPredicate([ExpectedValueType](const FInstancedStruct& Param) { return Param.IsValid() && Param.GetScriptStruct() == ExpectedValueType; }))
+		{
+			FilteredParams.Add(*Found);
+		}
+	}
+	Values.SetValues(StateTag, FilteredParams);
+}
+
+void FSyLayeredStateContainer::MarkPackedLayerTagsDirty(ESyStateLayer Layer)
+{
+	TArray<FGameplayTag> Tags;
+	GetLayerValues(ToLayerIndex(Layer)).GetTags(Tags);
+	for (const FGameplayTag& StateTag : Tags)
+	{
+		MarkTagDirty(Layer, StateTag);
+	}
+}
+
+const FSyStateCategories& FSyLayeredStateContainer::GetLayerState(int32 LayerIndex) const
+{
+	return IsLayerShared(LayerIndex) ? SharedDefaultLayer->State : StateLayers[LayerIndex];
+}
+
+const FSyStateValueArena& FSyLayeredStateContainer::GetLayerValues(int32 LayerIndex) const
+{
+	return IsLayerShared(LayerIndex) ? SharedDefaultLayer->Values : LayerValues[LayerIndex];
+}
+
+void FSyLayeredStateContainer::MakeLayerPrivate(ESyStateLayer Layer)
+{
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	if (!IsLayerShared(LayerIndex))
+	{
+		return;
+	}
+
+	const TSharedPtr<const FSySharedStateLayer> Shared = MoveTemp(SharedDefaultLayer);
+	if (bPackedValues)
+	{
+		LayerValues[LayerIndex] = Shared->Values;
+	}
+	else
+	{
+		// 以新的元数据对象重建，之后的修改不影响其它容器
+		StateLayers[LayerIndex].UpdateFromParameterMap(Shared->Params);
+
+		// 有效状态缓存引用的是共享层的对象，重建以指向私有对象（有效值不变，不产生变化事件）
+		bCacheFullyDirty = true;
+		DirtyTags.Reset();
+	}
+
+	// 值句柄可能指向共享层的内存
+	++Version;
+}
+
+void FSyLayeredStateContainer::SetSharedDefaultLayer(const FSyStateParameterSet& ParamSet)
+{
+	const ESyStateLayer Layer = ESyStateLayer::Default;
+	const int32 LayerIndex = ToLayerIndex(Layer);
+	const TMap<FGameplayTag, TArray<FInstancedStruct>> ParamsMap = ParamSet.GetParametersAsMap();
+
+	// 原有标签与新标签都需要重算
+	if (bPackedValues)
+	{
+		MarkPackedLayerTagsDirty(Layer);
+	}
+	else
+	{
+		MarkLayerTagsDirty(Layer, GetLayerState(LayerIndex));
+		StateLayers[LayerIndex].ReleaseAllMetadata();
+	}
+	LayerValues[LayerIndex].Reset();
+	SharedDefaultLayer.Reset();
+
+	if (ParamsMap.IsEmpty())
+	{
+		return;
+	}
+
+	SharedDefaultLayer = FSySharedStateLayerCache::Get().FindOrAdd(ParamsMap, bPackedValues, [](FSySharedStateLayer& NewLayer)
+	{
+		if (NewLayer.bPackedValues)
+		{
+			for (const TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : NewLayer.Params)
+			{
+				SetPackedTagValues(NewLayer.Values, Pair.Key, Pair.Value);
+			}
+		}
+		else
+		{
+			NewLayer.State.UpdateFromParameterMap(NewLayer.Params);
+		}
+	});
+
+	for (const TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : ParamsMap)
+	{
+		MarkTagDirty(Layer, Pair.Key);
+	}
+}
+
+void FSyLayeredStateContainer::MarkTagDirty(ESyStateLayer Layer, const FGameplayTag& StateTag)
+{
+	++Version;
+	bLayerViewDirty[ToLayerIndex(Layer)] = true;
+
+	const uint8 LayerBit = 1 << ToLayerIndex(Layer);
+	PendingChangedLayers |= LayerBit;
+	if (!bPendingAllTags)
+	{
+		PendingChangedTags.FindOrAdd(StateTag) |= LayerBit;
+	}
+
+	if (!bCacheFullyDirty)
+	{
+		DirtyTags.Add(StateTag);
+	}
+}
+
+void FSyLayeredStateContainer::MarkLayerTagsDirty(ESyStateLayer Layer, const FSyStateCategories& LayerState)
+{
+	for (const TPair<FGameplayTag, FSyStateMetadatas>& Pair : LayerState.GetStateDataMap())
+	{
+		MarkTagDirty(Layer, Pair.Key);
+	}
+}
+
+void FSyLayeredStateContainer::InvalidateCache(ESyStateLayer Layer)
+{
+	++Version;
+	for (int32 LayerIndex = 0; LayerIndex < (int32)ESyStateLayer::MAX; ++LayerIndex)
+	{
+		bLayerViewDirty[LayerIndex] |= Layer == ESyStateLayer::MAX || LayerIndex == (int32)Layer;
+	}
+	bCacheFullyDirty = true;
+	DirtyTags.Reset();
+
+	PendingChangedLayers |= Layer == ESyStateLayer::MAX ? 0xFF >> (8 - (int32)ESyStateLayer::MAX) : 1 << ToLayerIndex(Layer);
+	bPendingAllTags = true;
+	PendingChangedTags.Reset();
 }
@@ -0,0 +1,274 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateJournal.h"
+#include "Foundation/SyLogging.h"
+#include "HAL/FileManager.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+namespace SyStateJournal
+{
+	static constexpr uint32 Magic = 0x4C4A5953; // "SYJL"
+	static constexpr uint32 Version = 1;
+
+	/** Type + PayloadSize + Crc */
+	static constexpr int64 EntryOverhead = sizeof(uint8) + sizeof(int32) + sizeof(uint32);
+}
+
+FSyStateJournal::FSyStateJournal(const FString& InFilePath)
+	: FilePath(InFilePath)
+{
+}
+
+void FSyStateJournal::AppendRecord(const FSyStateModificationRecord& Record)
+{
+	// 共享载荷不是属性，序列化前先内联
+	TOptional<FSyStateModificationRecord> InlineRecord;
+	if (Record.Payload.IsValid())
+	{
+		InlineRecord.Emplace(Record.WithInlinePayload());
+	}
+	FSyStateModificationRecord* RecordToWrite = InlineRecord.IsSet() ? &InlineRecord.GetValue() : const_cast<FSyStateModificationRecord*>(&Record);
+
+	// 按属性名序列化，结构体增删字段后旧日志仍可回放
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	FObjectAndNameAsStringProxyArchive Proxy(Writer, false);
+	FSyStateModificationRecord::StaticStruct()->SerializeItem(Proxy, RecordToWrite, nullptr);
+
+	AppendEntry(EEntryType::Record, Payload);
+}
+
+void FSyStateJournal::AppendUnload(const FGuid& OperationId)
+{
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	FGuid MutableId = OperationId;
+	Writer << MutableId;
+
+	AppendEntry(EEntryType::Unload, Payload);
+}
+
+void FSyStateJournal::AppendEntry(EEntryType Type, TArray<uint8>& Payload)
+{
+	FMemoryWriter Writer(PendingBytes, false, true);
+
+	uint8 TypeValue = static_cast<uint8>(Type);
+	int32 PayloadSize = Payload.Num();
+	uint32 Crc = FCrc::MemCrc32(Payload.GetData(), PayloadSize);
+
+	Writer << TypeValue << PayloadSize;
+	Writer.Serialize(Payload.GetData(), PayloadSize);
+	Writer << Crc;
+
+	++NumPendingEntries;
+}
+
+bool FSyStateJournal::Flush()
+{
+	if (PendingBytes.Num() == 0)
+	{
+		return true;
+	}
+
+	IFileManager& FileManager = IFileManager::Get();
+	const bool bNewFile = FileManager.FileSize(*FilePath) <= 0;
+
+	TUniquePtr<FArchive> File(FileManager.CreateFileWriter(*FilePath, FILEWRITE_Append | FILEWRITE_AllowRead));
+	if (!File)
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to open state journal for append: %s"), *FilePath);
+		return false;
+	}
+
+	if (bNewFile)
+	{
+		uint32 MagicValue = SyStateJournal::Magic;
+		uint32 VersionValue = SyStateJournal::Version;
+		*File << MagicValue << VersionValue;
+	}
+
+	File->Serialize(PendingBytes.GetData(), PendingBytes.Num());
+	if (!File->Close() || File->IsError())
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to append %d journal entries to: %s"), NumPendingEntries, *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogSyStateManager, Verbose, TEXT("Appended %d journal entries (%d bytes) to: %s"), NumPendingEntries, PendingBytes.Num(), *FilePath);
+	PendingBytes.Reset();
+	NumPendingEntries = 0;
+	return true;
+}
+
+void FSyStateJournal::DiscardPending()
+{
+	PendingBytes.Reset();
+	NumPendingEntries = 0;
+}
+
+bool FSyStateJournal::Reset()
+{
+	DiscardPending();
+
+	IFileManager& FileManager = IFileManager::Get();
+	if (!FileManager.FileExists(*FilePath))
+	{
+		return true;
+	}
+	return FileManager.Delete(*FilePath, false, false, true);
+}
+
+int64 FSyStateJournal::GetFileSize() const
+{
+	return FMath::Max<int64>(IFileManager::Get().FileSize(*FilePath), 0);
+}
+
+bool FSyStateJournal::TruncateTo(int64 ValidSize)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to read state journal for truncation: %s"), *FilePath);
+		return false;
+	}
+	if (ValidSize < 0 || ValidSize >= FileData.Num())
+	{
+		return true;
+	}
+
+	// 没有可移植的原地截断：重写保留的部分
+	const int32 NumDropped = FileData.Num() - static_cast<int32>(ValidSize);
+	FileData.SetNum(static_cast<int32>(ValidSize));
+	if (!FFileHelper::SaveArrayToFile(FileData, *FilePath))
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to truncate state journal: %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogSyStateManager, Warning, TEXT("Dropped %d unreadable trailing byte(s) from state journal: %s"), NumDropped, *FilePath);
+	return true;
+}
+
+bool FSyStateJournal::Replay(TArray<FSyStateModificationRecord>& InOutLog, int32& OutNumApplied, TArray<FGuid>& OutUnloadedOperationIds, int64& OutValidSize) const
+{
+	OutNumApplied = 0;
+	OutUnloadedOperationIds.Reset();
+	OutValidSize = 0;
+
+	TArray<uint8> FileData;
+	if (!IFileManager::Get().FileExists(*FilePath))
+	{
+		return true;
+	}
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to read state journal: %s"), *FilePath);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 MagicValue = 0;
+	uint32 VersionValue = 0;
+	Reader << MagicValue << VersionValue;
+	if (Reader.IsError() || MagicValue != SyStateJournal::Magic || VersionValue != SyStateJournal::Version)
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("State journal has an invalid header (Magic: 0x%08X, Version: %u): %s"), MagicValue, VersionValue, *FilePath);
+		return false;
+	}
+	OutValidSize = Reader.Tell();
+
+	// OperationId -> 位置；卸载只做标记，回放结束后一次性移除，保持剩余记录的顺序
+	TMap<FGuid, int32> OperationIndex;
+	OperationIndex.Reserve(InOutLog.Num());
+	for (int32 Index = 0; Index < InOutLog.Num(); ++Index)
+	{
+		OperationIndex.Add(InOutLog[Index].Operation.OperationId, Index);
+	}
+	TBitArray<> Removed(false, InOutLog.Num());
+
+	TArray<uint8> Payload;
+	while (Reader.TotalSize() - Reader.Tell() >= SyStateJournal::EntryOverhead)
+	{
+		uint8 TypeValue = 0;
+		int32 PayloadSize = 0;
+		Reader << TypeValue << PayloadSize;
+		if (PayloadSize < 0 || Reader.TotalSize() - Reader.Tell() < PayloadSize + static_cast<int64>(sizeof(uint32)))
+		{
+			UE_LOG(LogSyStateManager, Warning, TEXT("State journal ends with a truncated entry; ignoring the tail: %s"), *FilePath);
+			break;
+		}
+
+		Payload.SetNumUninitialized(PayloadSize);
+		Reader.Serialize(Payload.GetData(), PayloadSize);
+		uint32 Crc = 0;
+		Reader << Crc;
+		if (Crc != FCrc::MemCrc32(Payload.GetData(), PayloadSize))
+		{
+			UE_LOG(LogSyStateManager, Warning, TEXT("State journal entry failed its checksum; ignoring the tail: %s"), *FilePath);
+			break;
+		}
+
+		FMemoryReader PayloadReader(Payload);
+		switch (static_cast<EEntryType>(TypeValue))
+		{
+		case EEntryType::Record:
+		{
+			FSyStateModificationRecord Record;
+			FObjectAndNameAsStringProxyArchive Proxy(PayloadReader, true);
+			FSyStateModificationRecord::StaticStruct()->SerializeItem(Proxy, &Record, nullptr);
+
+			const FGuid OperationId = Record.Operation.OperationId;
+			if (OperationIndex.Contains(OperationId))
+			{
+				break;
+			}
+			OperationIndex.Add(OperationId, InOutLog.Add(MoveTemp(Record)));
+			Removed.Add(false);
+			++OutNumApplied;
+			break;
+		}
+		case EEntryType::Unload:
+		{
+			FGuid OperationId;
+			PayloadReader << OperationId;
+			OutUnloadedOperationIds.AddUnique(OperationId);
+			if (const int32* Index = OperationIndex.Find(OperationId))
+			{
+				Removed[*Index] = true;
+				OperationIndex.Remove(OperationId);
+				++OutNumApplied;
+			}
+			break;
+		}
+		default:
+			UE_LOG(LogSyStateManager, Warning, TEXT("Skipping unknown state journal entry type %d."), TypeValue);
+			break;
+		}
+		OutValidSize = Reader.Tell();
+	}
+	if (OutValidSize < Reader.TotalSize())
+	{
+		UE_LOG(LogSyStateManager, Warning, TEXT("State journal has %lld unreadable trailing byte(s) after offset %lld: %s"),
+			Reader.TotalSize() - OutValidSize, OutValidSize, *FilePath);
+	}
+
+	int32 WriteIndex = 0;
+	for (int32 ReadIndex = 0; ReadIndex < InOutLog.Num(); ++ReadIndex)
+	{
+		if (!Removed[ReadIndex])
+		{
+			if (WriteIndex != ReadIndex)
+			{
+				InOutLog[WriteIndex] = MoveTemp(InOutLog[ReadIndex]);
+			}
+			++WriteIndex;
+		}
+	}
+	InOutLog.SetNum(WriteIndex);
+
+	return true;
+}
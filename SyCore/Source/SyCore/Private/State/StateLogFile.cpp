@@ -0,0 +1,527 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateLogFile.h"
+#include "State/StatePayloadPool.h"
+#include "Foundation/SyLogging.h"
+#include "Algo/StableSort.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+namespace SyStateLogFile
+{
+	static constexpr uint32 Magic = 0x534C5953; // "SYLS"
+	static constexpr uint32 LegacyVersion = 1;
+	static constexpr uint32 BlockVersion = 2;
+	static constexpr uint32 PayloadTableVersion = 3;
+	static constexpr uint32 RecordSequenceVersion = 4;
+	static constexpr uint32 Version = 5;
+
+	/** Magic + Version + NumTargets + DirectoryOffset */
+	static constexpr int64 HeaderSize = sizeof(uint32) + sizeof(uint32) + sizeof(int32) + sizeof(int64);
+
+	static const FName CompressionFormat = NAME_Oodle;
+
+	/** 写出块内的载荷表：共享载荷按对象去重，没有载荷的记录下标为 INDEX_NONE（修改仍内联在记录中） */
+	void WritePayloadTable(FArchive& Ar, const TArray<FSyStateModificationRecord>& Records)
+	{
+		TMap<const FSyStatePayload*, int32> PayloadIndices;
+		TArray<FSyStateParameterSet*> Payloads;
+		TArray<int32> RecordPayloadIndices;
+		RecordPayloadIndices.Reserve(Records.Num());
+		for (const FSyStateModificationRecord& Record : Records)
+		{
+			const FSyStatePayload* Payload = Record.Payload.Get();
+			if (!Payload)
+			{
+				RecordPayloadIndices.Add(INDEX_NONE);
+				continue;
+			}
+
+			int32* ExistingIndex = PayloadIndices.Find(Payload);
+			if (!ExistingIndex)
+			{
+				ExistingIndex = &PayloadIndices.Add(Payload, Payloads.Add(const_cast<FSyStateParameterSet*>(&Payload->Parameters)));
+			}
+			RecordPayloadIndices.Add(*ExistingIndex);
+		}
+
+		int32 NumPayloads = Payloads.Num();
+		Ar << NumPayloads;
+		for (FSyStateParameterSet* Parameters : Payloads)
+		{
+			FSyStateParameterSet::StaticStruct()->SerializeItem(Ar, Parameters, nullptr);
+		}
+		Ar << RecordPayloadIndices;
+	}
+
+	/** 读取块内的载荷表并让记录引用共享载荷 */
+	bool ReadPayloadTable(FArchive& Ar, TArray<FSyStateModificationRecord>& Records)
+	{
+		int32 NumPayloads = 0;
+		Ar << NumPayloads;
+		if (Ar.IsError() || NumPayloads < 0)
+		{
+			return false;
+		}
+
+		TArray<TSharedPtr<const FSyStatePayload>> Payloads;
+		Payloads.Reserve(NumPayloads);
+		for (int32 i = 0; i < NumPayloads && !Ar.IsError(); ++i)
+		{
+			FSyStateParameterSet Parameters;
+			FSyStateParameterSet::StaticStruct()->SerializeItem(Ar, &Parameters, nullptr);
+			Payloads.Add(FSyStatePayloadPool::MakePayload(MoveTemp(Parameters)));
+		}
+
+		TArray<int32> RecordPayloadIndices;
+		Ar << RecordPayloadIndices;
+		if (Ar.IsError() || RecordPayloadIndices.Num() != Records.Num())
+		{
+			return false;
+		}
+
+		for (int32 Index = 0; Index < Records.Num(); ++Index)
+		{
+			const int32 PayloadIndex = RecordPayloadIndices[Index];
+			if (PayloadIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			if (!Payloads.IsValidIndex(PayloadIndex))
+			{
+				return false;
+			}
+			Records[Index].Payload = Payloads[PayloadIndex];
+		}
+		return true;
+	}
+
+	template<typename StructType>
+	void SerializeArray(FArchive& Ar, TArray<StructType>& Items)
+	{
+		int32 Num = Items.Num();
+		Ar << Num;
+		if (Ar.IsLoading())
+		{
+			if (Num < 0)
+			{
+				Ar.SetError();
+				return;
+			}
+			Items.SetNum(Num);
+		}
+
+		for (StructType& Item : Items)
+		{
+			StructType::StaticStruct()->SerializeItem(Ar, &Item, nullptr);
+			if (Ar.IsError())
+			{
+				return;
+			}
+		}
+	}
+
+	/** 压缩数据；无收益时返回 false，调用方保存原始数据 */
+	bool Compress(const TArray<uint8>& Uncompressed, TArray<uint8>& OutCompressed)
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(CompressionFormat, Uncompressed.Num());
+		OutCompressed.SetNumUninitialized(CompressedSize);
+		if (!FCompression::CompressMemory(CompressionFormat, OutCompressed.GetData(), CompressedSize, Uncompressed.GetData(), Uncompressed.Num())
+			|| CompressedSize >= Uncompressed.Num())
+		{
+			return false;
+		}
+		OutCompressed.SetNum(CompressedSize);
+		return true;
+	}
+
+	bool Decompress(const uint8* Stored, int64 StoredSize, bool bCompressed, int64 UncompressedSize, TArray<uint8>& OutUncompressed)
+	{
+		if (UncompressedSize < 0 || UncompressedSize > MAX_int32 || StoredSize < 0 || StoredSize > MAX_int32)
+		{
+			return false;
+		}
+
+		OutUncompressed.SetNumUninitialized(static_cast<int32>(UncompressedSize));
+		if (bCompressed)
+		{
+			return FCompression::UncompressMemory(CompressionFormat, OutUncompressed.GetData(), OutUncompressed.Num(), Stored, static_cast<int32>(StoredSize));
+		}
+		if (StoredSize != UncompressedSize)
+		{
+			return false;
+		}
+		FMemory::Memcpy(OutUncompressed.GetData(), Stored, OutUncompressed.Num());
+		return true;
+	}
+
+	void SerializeTargetKey(FArchive& Ar, FSyStateTargetKey& Key)
+	{
+		uint8 Scope = static_cast<uint8>(Key.Scope);
+		FString TypeTagName = Key.TypeTag.GetTagName().ToString();
+		FString AliasName = Key.Alias.ToString();
+		Ar << Scope << TypeTagName << AliasName << Key.EntityId;
+
+		if (Ar.IsLoading())
+		{
+			Key.Scope = static_cast<ESyStateTargetScope>(FMath::Min<uint8>(Scope, static_cast<uint8>(ESyStateTargetScope::Num)));
+			Key.TypeTag = FGameplayTag::RequestGameplayTag(FName(*TypeTagName), false);
+			Key.Alias = AliasName.IsEmpty() || AliasName == TEXT("None") ? NAME_None : FName(*AliasName);
+		}
+	}
+
+	/** 版本 1：整个载荷一次压缩 */
+	bool ReadLegacy(FMemoryReader& Reader, const TArray<uint8>& FileBytes, FSyStateLogFileData& OutData)
+	{
+		int64 UncompressedSize = 0;
+		int64 CompressedSize = 0;
+		Reader << UncompressedSize << CompressedSize;
+
+		const int64 StoredSize = CompressedSize > 0 ? CompressedSize : UncompressedSize;
+		TArray<uint8> Uncompressed;
+		if (Reader.IsError() || StoredSize > Reader.TotalSize() - Reader.Tell()
+			|| !Decompress(FileBytes.GetData() + Reader.Tell(), StoredSize, CompressedSize > 0, UncompressedSize, Uncompressed))
+		{
+			return false;
+		}
+
+		FMemoryReader PayloadReader(Uncompressed, true);
+		FObjectAndNameAsStringProxyArchive Proxy(PayloadReader, true);
+		SerializeArray(Proxy, OutData.Records);
+		SerializeArray(Proxy, OutData.Checkpoints);
+		return !Proxy.IsError() && !PayloadReader.IsError();
+	}
+}
+
+bool FSyStateLogFile::Write(const FString& FilePath, const FSyStateLogFileData& Data)
+{
+	// 1. 按目标分组（保持同一目标内的记录顺序）
+	TMap<FSyStateTargetKey, TArray<int32>> RecordsByTarget;
+	for (int32 Index = 0; Index < Data.Records.Num(); ++Index)
+	{
+		const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(Data.Records[Index].Operation.Target);
+		if (TargetKey.IsValid())
+		{
+			RecordsByTarget.FindOrAdd(TargetKey).Add(Index);
+		}
+	}
+
+	TMap<FSyStateTargetKey, const TArray<FSyStateCheckpointEntry>*> CheckpointsByTarget;
+	for (const FSyStateTargetCheckpoint& Checkpoint : Data.Checkpoints)
+	{
+		const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(Checkpoint.Target);
+		if (TargetKey.IsValid())
+		{
+			CheckpointsByTarget.Add(TargetKey, &Checkpoint.Entries);
+			RecordsByTarget.FindOrAdd(TargetKey);
+		}
+	}
+
+	// 2. 逐目标序列化并独立压缩
+	TArray<uint8> FileBytes;
+	FMemoryWriter Writer(FileBytes, true);
+	uint32 MagicValue = SyStateLogFile::Magic;
+	uint32 VersionValue = SyStateLogFile::Version;
+	int32 NumTargets = RecordsByTarget.Num();
+	int64 DirectoryOffset = 0;
+	Writer << MagicValue << VersionValue << NumTargets << DirectoryOffset;
+
+	TArray<FSyStateLogFileTargetEntry> Directory;
+	Directory.Reserve(NumTargets);
+	int64 TotalUncompressed = 0;
+
+	TArray<uint8> Block;
+	TArray<uint8> Compressed;
+	TArray<FSyStateModificationRecord> TargetRecords;
+	TArray<FSyStateCheckpointEntry> TargetCheckpoint;
+	for (const TPair<FSyStateTargetKey, TArray<int32>>& Pair : RecordsByTarget)
+	{
+		TargetRecords.Reset(Pair.Value.Num());
+		for (int32 Index : Pair.Value)
+		{
+			TargetRecords.Add(Data.Records[Index]);
+		}
+		const TArray<FSyStateCheckpointEntry>* const* CheckpointPtr = CheckpointsByTarget.Find(Pair.Key);
+		TargetCheckpoint = CheckpointPtr ? **CheckpointPtr : TArray<FSyStateCheckpointEntry>();
+
+		Block.Reset();
+		{
+			FMemoryWriter BlockWriter(Block, true);
+			FObjectAndNameAsStringProxyArchive Proxy(BlockWriter, false);
+			SyStateLogFile::SerializeArray(Proxy, TargetRecords);
+			SyStateLogFile::WritePayloadTable(Proxy, TargetRecords);
+			TArray<int32> RecordSequence = Pair.Value;
+			Proxy << RecordSequence;
+			SyStateLogFile::SerializeArray(Proxy, TargetCheckpoint);
+		}
+
+		FSyStateLogFileTargetEntry& Entry = Directory.AddDefaulted_GetRef();
+		Entry.Target = Pair.Key;
+		Entry.Offset = Writer.Tell();
+		Entry.UncompressedSize = Block.Num();
+		Entry.NumRecords = TargetRecords.Num();
+		Entry.bCompressed = SyStateLogFile::Compress(Block, Compressed);
+
+		const TArray<uint8>& Stored = Entry.bCompressed ? Compressed : Block;
+		Entry.StoredSize = Stored.Num();
+		Writer.Serialize(const_cast<uint8*>(Stored.GetData()), Stored.Num());
+		TotalUncompressed += Block.Num();
+	}
+
+	// 3. 目录写在数据块之后，再回填文件头中的目录偏移
+	DirectoryOffset = Writer.Tell();
+	for (FSyStateLogFileTargetEntry& Entry : Directory)
+	{
+		uint8 bCompressed = Entry.bCompressed ? 1 : 0;
+		SyStateLogFile::SerializeTargetKey(Writer, Entry.Target);
+		Writer << Entry.Offset << Entry.StoredSize << Entry.UncompressedSize << bCompressed << Entry.NumRecords;
+	}
+	double ExpiryGameClockSeconds = Data.ExpiryGameClockSeconds;
+	Writer << ExpiryGameClockSeconds;
+	Writer.Seek(SyStateLogFile::HeaderSize - sizeof(int64));
+	Writer << DirectoryOffset;
+
+	// 4. 写临时文件后替换
+	const FString TempPath = FilePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(FileBytes, *TempPath))
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to write state log file: %s"), *TempPath);
+		return false;
+	}
+	if (!IFileManager::Get().Move(*FilePath, *TempPath, true, true))
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("Failed to replace state log file: %s"), *FilePath);
+		return false;
+	}
+
+	UE_LOG(LogSyStateManager, Verbose, TEXT("Wrote state log file %s: %d records in %d target block(s), %lld -> %d bytes."),
+		*FilePath, Data.Records.Num(), Directory.Num(), TotalUncompressed, FileBytes.Num());
+	return true;
+}
+
+bool FSyStateLogFile::ReadDirectory(const uint8* FileData, int64 FileSize, TArray<FSyStateLogFileTargetEntry>& OutDirectory, double& OutExpiryGameClockSeconds)
+{
+	OutExpiryGameClockSeconds = 0.0;
+	if (!FileData || FileSize < SyStateLogFile::HeaderSize)
+	{
+		return false;
+	}
+
+	// 文件头与目录很小，拷贝后用内存读取器解析
+	TArray<uint8> Header(FileData, static_cast<int32>(SyStateLogFile::HeaderSize));
+	FMemoryReader HeaderReader(Header, true);
+
+	uint32 MagicValue = 0;
+	uint32 VersionValue = 0;
+	int32 NumTargets = 0;
+	int64 DirectoryOffset = 0;
+	HeaderReader << MagicValue << VersionValue << NumTargets << DirectoryOffset;
+	if (MagicValue != SyStateLogFile::Magic || VersionValue < SyStateLogFile::BlockVersion || VersionValue > SyStateLogFile::Version
+		|| NumTargets < 0 || DirectoryOffset < SyStateLogFile::HeaderSize || DirectoryOffset > FileSize
+		|| FileSize - DirectoryOffset > MAX_int32)
+	{
+		return false;
+	}
+
+	TArray<uint8> DirectoryBytes(FileData + DirectoryOffset, static_cast<int32>(FileSize - DirectoryOffset));
+	FMemoryReader Reader(DirectoryBytes, true);
+
+	OutDirectory.Reset(NumTargets);
+	for (int32 i = 0; i < NumTargets; ++i)
+	{
+		FSyStateLogFileTargetEntry& Entry = OutDirectory.AddDefaulted_GetRef();
+		uint8 bCompressed = 0;
+		SyStateLogFile::SerializeTargetKey(Reader, Entry.Target);
+		Reader << Entry.Offset << Entry.StoredSize << Entry.UncompressedSize << bCompressed << Entry.NumRecords;
+		Entry.bCompressed = bCompressed != 0;
+		Entry.FileVersion = VersionValue;
+
+		if (Reader.IsError() || Entry.Offset < SyStateLogFile::HeaderSize || Entry.StoredSize < 0
+			|| Entry.Offset + Entry.StoredSize > DirectoryOffset)
+		{
+			OutDirectory.Reset();
+			return false;
+		}
+	}
+
+	if (VersionValue >= SyStateLogFile::Version)
+	{
+		Reader << OutExpiryGameClockSeconds;
+		if (Reader.IsError())
+		{
+			OutDirectory.Reset();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FSyStateLogFile::ReadTargetBlock(const uint8* FileData, int64 FileSize, const FSyStateLogFileTargetEntry& Entry,
+	TArray<FSyStateModificationRecord>& OutRecords, TArray<int32>& OutRecordSequence, TArray<FSyStateCheckpointEntry>& OutCheckpointEntries)
+{
+	if (!FileData || Entry.Offset + Entry.StoredSize > FileSize)
+	{
+		return false;
+	}
+
+	TArray<uint8> Block;
+	if (!SyStateLogFile::Decompress(FileData + Entry.Offset, Entry.StoredSize, Entry.bCompressed, Entry.UncompressedSize, Block))
+	{
+		return false;
+	}
+
+	TArray<FSyStateModificationRecord> Records;
+	FMemoryReader BlockReader(Block, true);
+	FObjectAndNameAsStringProxyArchive Proxy(BlockReader, true);
+	SyStateLogFile::SerializeArray(Proxy, Records);
+	if (Entry.FileVersion >= SyStateLogFile::PayloadTableVersion && !SyStateLogFile::ReadPayloadTable(Proxy, Records))
+	{
+		return false;
+	}
+	TArray<int32> RecordSequence;
+	if (Entry.FileVersion >= SyStateLogFile::RecordSequenceVersion)
+	{
+		Proxy << RecordSequence;
+		if (RecordSequence.Num() != Records.Num())
+		{
+			return false;
+		}
+	}
+	else
+	{
+		RecordSequence.Init(INDEX_NONE, Records.Num());
+	}
+	SyStateLogFile::SerializeArray(Proxy, OutCheckpointEntries);
+	if (Proxy.IsError() || BlockReader.IsError())
+	{
+		return false;
+	}
+
+	OutRecords.Append(MoveTemp(Records));
+	OutRecordSequence.Append(MoveTemp(RecordSequence));
+	return true;
+}
+
+bool FSyStateLogFile::Read(const FString& FilePath, FSyStateLogFileData& OutData)
+{
+	TArray<uint8> FileBytes;
+	if (!IFileManager::Get().FileExists(*FilePath) || !FFileHelper::LoadFileToArray(FileBytes, *FilePath))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileBytes, true);
+	uint32 MagicValue = 0;
+	uint32 VersionValue = 0;
+	Reader << MagicValue << VersionValue;
+	if (Reader.IsError() || MagicValue != SyStateLogFile::Magic)
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("State log file has an invalid header: %s"), *FilePath);
+		return false;
+	}
+
+	if (VersionValue == SyStateLogFile::LegacyVersion)
+	{
+		if (!SyStateLogFile::ReadLegacy(Reader, FileBytes, OutData))
+		{
+			UE_LOG(LogSyStateManager, Error, TEXT("Failed to decode state log file: %s"), *FilePath);
+			return false;
+		}
+		return true;
+	}
+
+	TArray<FSyStateLogFileTargetEntry> Directory;
+	if (!ReadDirectory(FileBytes.GetData(), FileBytes.Num(), Directory, OutData.ExpiryGameClockSeconds))
+	{
+		UE_LOG(LogSyStateManager, Error, TEXT("State log file has an invalid directory (Version: %u): %s"), VersionValue, *FilePath);
+		return false;
+	}
+
+	TArray<int32> RecordSequence;
+	TArray<FSyStateCheckpointEntry> CheckpointEntries;
+	for (const FSyStateLogFileTargetEntry& Entry : Directory)
+	{
+		CheckpointEntries.Reset();
+		if (!ReadTargetBlock(FileBytes.GetData(), FileBytes.Num(), Entry, OutData.Records, RecordSequence, CheckpointEntries))
+		{
+			UE_LOG(LogSyStateManager, Error, TEXT("Failed to decode block for target %s in: %s"), *Entry.Target.ToString(), *FilePath);
+			return false;
+		}
+		if (CheckpointEntries.Num() > 0)
+		{
+			FSyStateTargetCheckpoint& Checkpoint = OutData.Checkpoints.AddDefaulted_GetRef();
+			Checkpoint.Target = Entry.Target.ToOperationTarget();
+			Checkpoint.Entries = MoveTemp(CheckpointEntries);
+		}
+	}
+
+	// 按块读取的记录按目标分组：恢复写入时的全局顺序（旧版本文件没有记录位置，保持分组顺序）
+	if (!RecordSequence.Contains(INDEX_NONE))
+	{
+		TArray<int32> Order;
+		Order.Reserve(OutData.Records.Num());
+		for (int32 Index = 0; Index < OutData.Records.Num(); ++Index)
+		{
+			Order.Add(Index);
+		}
+		Algo::StableSortBy(Order, [&RecordSequence](int32 Index) { return RecordSequence[Index]; });
+
+		TArray<FSyStateModificationRecord> OrderedRecords;
+		OrderedRecords.Reserve(Order.Num());
+		for (int32 Index : Order)
+		{
+			OrderedRecords.Add(MoveTemp(OutData.Records[Index]));
+		}
+		OutData.Records = MoveTemp(OrderedRecords);
+	}
+	return true;
+}
+
+// ===== FSyStateMappedLogFile =====
+
+FSyStateMappedLogFile::~FSyStateMappedLogFile()
+{
+	// 先释放映射区域，再关闭文件句柄
+	Region.Reset();
+	Handle.Reset();
+}
+
+TUniquePtr<FSyStateMappedLogFile> FSyStateMappedLogFile::Open(const FString& FilePath)
+{
+	if (!IFileManager::Get().FileExists(*FilePath))
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FSyStateMappedLogFile> MappedFile(new FSyStateMappedLogFile());
+	MappedFile->Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	if (!MappedFile->Handle)
+	{
+		return nullptr;
+	}
+
+	MappedFile->FileSize = MappedFile->Handle->GetFileSize();
+	MappedFile->Region.Reset(MappedFile->Handle->MapRegion(0, MappedFile->FileSize));
+	if (!MappedFile->Region)
+	{
+		return nullptr;
+	}
+
+	MappedFile->FileData = MappedFile->Region->GetMappedPtr();
+	if (!FSyStateLogFile::ReadDirectory(MappedFile->FileData, MappedFile->FileSize, MappedFile->Directory, MappedFile->ExpiryGameClockSeconds))
+	{
+		return nullptr;
+	}
+	return MappedFile;
+}
+
+bool FSyStateMappedLogFile::ReadTarget(const FSyStateLogFileTargetEntry& Entry, TArray<FSyStateModificationRecord>& OutRecords, TArray<int32>& OutRecordSequence, TArray<FSyStateCheckpointEntry>& OutCheckpointEntries) const
+{
+	return FSyStateLogFile::ReadTargetBlock(FileData, FileSize, Entry, OutRecords, OutRecordSequence, OutCheckpointEntries);
+}
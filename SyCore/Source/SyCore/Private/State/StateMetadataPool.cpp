@@ -0,0 +1,141 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateMetadataPool.h"
+#include "State/Types/StateMetadataTypes.h"
+#include "UObject/Package.h"
+
+FSyStateMetadataPool* FSyStateMetadataPool::Instance = nullptr;
+
+FSyStateMetadataPool& FSyStateMetadataPool::Get()
+{
+	check(Instance);
+	return *Instance;
+}
+
+void FSyStateMetadataPool::Initialize()
+{
+	if (!Instance)
+	{
+		Instance = new FSyStateMetadataPool();
+	}
+}
+
+void FSyStateMetadataPool::Shutdown()
+{
+	delete Instance;
+	Instance = nullptr;
+}
+
+void FSyStateMetadataPool::FFreeList::PromotePending()
+{
+	if (Pending.Num() > 0 && PendingFrame != GFrameCounter)
+	{
+		Ready.Append(MoveTemp(Pending));
+		Pending.Reset();
+	}
+}
+
+USyStateMetadataBase* FSyStateMetadataPool::Acquire(UClass* MetadataClass)
+{
+	if (!MetadataClass || !MetadataClass->IsChildOf(USyStateMetadataBase::StaticClass()))
+	{
+		return nullptr;
+	}
+
+	if (IsInGameThread())
+	{
+		if (FFreeList* FreeList = FreeLists.Find(MetadataClass))
+		{
+			FreeList->PromotePending();
+			while (FreeList->Ready.Num() > 0)
+			{
+				USyStateMetadataBase* Metadata = FreeList->Ready.Pop(EAllowShrinking::No);
+				if (IsValid(Metadata))
+				{
+					// 归还时不重置：归还当帧仍持有指针的调用方读到的是原值
+					Metadata->ResetForReuse();
+					++NumReused;
+					return Metadata;
+				}
+			}
+		}
+	}
+
+	++NumCreated;
+	return NewObject<USyStateMetadataBase>(GetTransientPackage(), MetadataClass);
+}
+
+void FSyStateMetadataPool::Release(UO_TagMetadata* Metadata)
+{
+	USyStateMetadataBase* StateMetadata = Cast<USyStateMetadataBase>(Metadata);
+	if (!StateMetadata)
+	{
+		return;
+	}
+
+	// 只回收由池 / 运行时创建的临时对象；资产或存档中的对象交给原有生命周期
+	if (!IsInGameThread() || !IsValid(StateMetadata) || StateMetadata->GetOuter() != GetTransientPackage() || StateMetadata->IsRooted())
+	{
+		++NumDiscarded;
+		return;
+	}
+
+	FFreeList& FreeList = FreeLists.FindOrAdd(StateMetadata->GetClass());
+	if (FreeList.Ready.Contains(StateMetadata) || FreeList.Pending.Contains(StateMetadata))
+	{
+		ensureMsgf(false, TEXT("Metadata %s was released to the pool twice."), *StateMetadata->GetName());
+		return;
+	}
+	if (FreeList.Num() >= MaxPooledPerClass)
+	{
+		++NumDiscarded;
+		return;
+	}
+
+	FreeList.PromotePending();
+	FreeList.Pending.Add(StateMetadata);
+	FreeList.PendingFrame = GFrameCounter;
+	++NumReleased;
+}
+
+void FSyStateMetadataPool::Trim()
+{
+	FreeLists.Empty();
+}
+
+void FSyStateMetadataPool::SetMaxPooledPerClass(int32 InMaxPooledPerClass)
+{
+	MaxPooledPerClass = FMath::Max(0, InMaxPooledPerClass);
+	for (TPair<const UClass*, FFreeList>& Pair : FreeLists)
+	{
+		FFreeList& FreeList = Pair.Value;
+		if (FreeList.Num() > MaxPooledPerClass)
+		{
+			FreeList.Ready.SetNum(FMath::Min(FreeList.Ready.Num(), MaxPooledPerClass));
+			FreeList.Pending.SetNum(MaxPooledPerClass - FreeList.Ready.Num());
+		}
+	}
+}
+
+FSyStateMetadataPoolStats FSyStateMetadataPool::GetStats() const
+{
+	FSyStateMetadataPoolStats Result;
+	Result.NumCreated = NumCreated.load();
+	Result.NumReused = NumReused.load();
+	Result.NumReleased = NumReleased.load();
+	Result.NumDiscarded = NumDiscarded.load();
+	for (const TPair<const UClass*, FFreeList>& Pair : FreeLists)
+	{
+		Result.NumPooled += Pair.Value.Num();
+	}
+	return Result;
+}
+
+void FSyStateMetadataPool::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<const UClass*, FFreeList>& Pair : FreeLists)
+	{
+		Collector.AddReferencedObjects(Pair.Value.Ready);
+		Collector.AddReferencedObjects(Pair.Value.Pending);
+	}
+}
@@ -0,0 +1,114 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StatePayloadPool.h"
+#include "State/Types/Metadatas/ListMetadataValueTypes.h"
+#include "State/Types/Metadatas/NumericModifierTypes.h"
+#include "Hash/CityHash.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+
+namespace SyStatePayloadPool
+{
+	/** 按序列化后的字节计算内容哈希（FInstancedStruct 没有通用的 GetTypeHash） */
+	uint64 ComputeHash(const FSyStateParameterSet& Parameters)
+	{
+		TArray<uint8> Bytes;
+		FMemoryWriter Writer(Bytes);
+		FObjectAndNameAsStringProxyArchive Proxy(Writer, false);
+		FSyStateParameterSet::StaticStruct()->SerializeItem(Proxy, const_cast<FSyStateParameterSet*>(&Parameters), nullptr);
+		return CityHash64(reinterpret_cast<const char*>(Bytes.GetData()), Bytes.Num());
+	}
+
+	/** 列表类型与数值修饰累积聚合，重复合并会改变结果 */
+	bool IsIdempotent(const FSyStateParameterSet& Parameters)
+	{
+		const UScriptStruct* ListBaseType = FSyListParameterBase::StaticStruct();
+		for (const FSyStateParams& ModParams : Parameters.Parameters)
+		{
+			for (const FInstancedStruct& Param : ModParams.Params)
+			{
+				const UScriptStruct* StructType = Param.GetScriptStruct();
+				if (StructType && (StructType->IsChildOf(ListBaseType)
+					|| StructType == FSyNumericModifier::StaticStruct()
+					|| StructType == FSyNumericModifierStack::StaticStruct()))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+TSharedRef<const FSyStatePayload> FSyStatePayloadPool::MakePayload(FSyStateParameterSet&& Parameters)
+{
+	TSharedRef<FSyStatePayload> Payload = MakeShared<FSyStatePayload>();
+	Payload->Parameters = MoveTemp(Parameters);
+	Payload->Hash = SyStatePayloadPool::ComputeHash(Payload->Parameters);
+	Payload->bIdempotent = SyStatePayloadPool::IsIdempotent(Payload->Parameters);
+	return Payload;
+}
+
+TSharedRef<const FSyStatePayload> FSyStatePayloadPool::Intern(const TSharedRef<const FSyStatePayload>& Payload)
+{
+	// 同一哈希下逐个比较内容，顺带清理已释放的载荷
+	for (auto It = Entries.CreateKeyIterator(Payload->Hash); It; ++It)
+	{
+		TSharedPtr<const FSyStatePayload> Existing = It.Value().Pin();
+		if (!Existing.IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		if (Existing == Payload)
+		{
+			return Payload;
+		}
+		if (FSyStateParameterSet::StaticStruct()->CompareScriptStruct(&Existing->Parameters, &Payload->Parameters, PPF_None))
+		{
+			return Existing.ToSharedRef();
+		}
+	}
+
+	Entries.Add(Payload->Hash, Payload);
+	if (Entries.Num() > TrimThreshold)
+	{
+		Trim();
+		TrimThreshold = FMath::Max(256, Entries.Num() * 2);
+	}
+	return Payload;
+}
+
+void FSyStatePayloadPool::InternRecord(FSyStateModificationRecord& Record)
+{
+	if (Record.Payload.IsValid())
+	{
+		Record.Payload = Intern(Record.Payload.ToSharedRef());
+		return;
+	}
+	if (Record.Operation.Modifier.StateModifications.Parameters.Num() == 0)
+	{
+		return;
+	}
+
+	Record.Payload = Intern(MakePayload(MoveTemp(Record.Operation.Modifier.StateModifications)));
+	Record.Operation.Modifier.StateModifications.Parameters.Empty();
+}
+
+void FSyStatePayloadPool::Trim()
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	Entries.Compact();
+}
+
+void FSyStatePayloadPool::Reset()
+{
+	Entries.Reset();
+	TrimThreshold = 256;
+}
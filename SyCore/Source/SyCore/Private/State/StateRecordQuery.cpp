@@ -0,0 +1,35 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateRecordQuery.h"
+
+bool FSyStateRecordQuery::Matches(const FSyStateModificationRecord& Record) const
+{
+	const FSyOperation& Operation = Record.Operation;
+
+	if (SourceTag.IsValid() && Operation.Source.SourceTypeTag != SourceTag)
+	{
+		return false;
+	}
+
+	if (SourceEntityId.IsValid() && Operation.Source.SourceEntityId != SourceEntityId)
+	{
+		return false;
+	}
+
+	if (Record.Timestamp < MinTimestamp || Record.Timestamp > MaxTimestamp)
+	{
+		return false;
+	}
+
+	if (StateTag.IsValid())
+	{
+		const bool bTouchesStateTag = Record.GetStateModifications().Parameters.ContainsByPredicate(
+			[this](const FSyStateParams& Params) { return Params.Tag == StateTag; });
+		if (!bTouchesStateTag)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateSharedLayer.h"
+#include "UObject/UnrealType.h"
+
+FSySharedStateLayerCache* FSySharedStateLayerCache::Instance = nullptr;
+
+namespace SySharedStateLayer
+{
+	/** 值的哈希：只组合支持哈希的属性，其余属性由逐值比较兜底 */
+	static uint32 HashValue(const FInstancedStruct& Value)
+	{
+		const UScriptStruct* ValueType = Value.GetScriptStruct();
+		uint32 Hash = GetTypeHash(ValueType);
+		if (!ValueType)
+		{
+			return Hash;
+		}
+
+		for (TFieldIterator<FProperty> It(ValueType); It; ++It)
+		{
+			const FProperty* Property = *It;
+			if (!Property->HasAnyPropertyFlags(CPF_HasGetValueTypeHash))
+			{
+				continue;
+			}
+			for (int32 ArrayIndex = 0; ArrayIndex < Property->ArrayDim; ++ArrayIndex)
+			{
+				Hash = HashCombine(Hash, Property->GetValueTypeHash(Property->ContainerPtrToValuePtr<void>(Value.GetMemory(), ArrayIndex)));
+			}
+		}
+		return Hash;
+	}
+}
+
+FSySharedStateLayerCache& FSySharedStateLayerCache::Get()
+{
+	check(Instance);
+	return *Instance;
+}
+
+void FSySharedStateLayerCache::Initialize()
+{
+	if (!Instance)
+	{
+		Instance = new FSySharedStateLayerCache();
+	}
+}
+
+void FSySharedStateLayerCache::Shutdown()
+{
+	delete Instance;
+	Instance = nullptr;
+}
+
+TSharedRef<const FSySharedStateLayer> FSySharedStateLayerCache::FindOrAdd(const TMap<FGameplayTag, TArray<FInstancedStruct>>& Params, bool bPackedValues, TFunctionRef<void(FSySharedStateLayer&)> BuildLayer)
+{
+	check(IsInGameThread());
+
+	const uint32 Hash = HashCombine(HashParams(Params), GetTypeHash(bPackedValues));
+	TArray<TWeakPtr<FSySharedStateLayer>>& Bucket = Layers.FindOrAdd(Hash);
+
+	for (int32 Index = Bucket.Num() - 1; Index >= 0; --Index)
+	{
+		const TSharedPtr<FSySharedStateLayer> Existing = Bucket[Index].Pin();
+		if (!Existing.IsValid())
+		{
+			Bucket.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+			continue;
+		}
+		if (Existing->bPackedValues == bPackedValues && ParamsIdentical(Existing->Params, Params))
+		{
+			return Existing.ToSharedRef();
+		}
+	}
+
+	const TSharedRef<FSySharedStateLayer> NewLayer = MakeShared<FSySharedStateLayer>();
+	NewLayer->Params = Params;
+	NewLayer->Hash = Hash;
+	NewLayer->bPackedValues = bPackedValues;
+	BuildLayer(*NewLayer);
+
+	Bucket.Add(NewLayer);
+	return NewLayer;
+}
+
+int32 FSySharedStateLayerCache::Num() const
+{
+	int32 Count = 0;
+	for (const TPair<uint32, TArray<TWeakPtr<FSySharedStateLayer>>>& Pair : Layers)
+	{
+		for (const TWeakPtr<FSySharedStateLayer>& Layer : Pair.Value)
+		{
+			Count += Layer.IsValid() ? 1 : 0;
+		}
+	}
+	return Count;
+}
+
+uint32 FSySharedStateLayerCache::HashParams(const TMap<FGameplayTag, TArray<FInstancedStruct>>& Params)
+{
+	// 各标签的哈希相加，与 TMap 的插入顺序无关
+	uint32 Hash = Params.Num();
+	for (const TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : Params)
+	{
+		uint32 TagHash = GetTypeHash(Pair.Key);
+		for (const FInstancedStruct& Value : Pair.Value)
+		{
+			TagHash = HashCombine(TagHash, SySharedStateLayer::HashValue(Value));
+		}
+		Hash += TagHash;
+	}
+	return Hash;
+}
+
+void FSySharedStateLayerCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (TPair<uint32, TArray<TWeakPtr<FSySharedStateLayer>>>& Pair : Layers)
+	{
+		for (const TWeakPtr<FSySharedStateLayer>& WeakLayer : Pair.Value)
+		{
+			const TSharedPtr<FSySharedStateLayer> Layer = WeakLayer.Pin();
+			if (!Layer.IsValid())
+			{
+				continue;
+			}
+
+			for (TPair<FGameplayTag, FSyStateMetadatas>& StatePair : Layer->State.StateData)
+			{
+				Collector.AddReferencedObjects(StatePair.Value.MetadataArray);
+			}
+			Layer->Values.AddReferencedObjects(Collector);
+			for (TPair<FGameplayTag, TArray<FInstancedStruct>>& ParamsPair : Layer->Params)
+			{
+				for (FInstancedStruct& Value : ParamsPair.Value)
+				{
+					Value.AddStructReferencedObjects(Collector);
+				}
+			}
+		}
+	}
+}
+
+bool FSySharedStateLayerCache::ParamsIdentical(const TMap<FGameplayTag, TArray<FInstancedStruct>>& A, const TMap<FGameplayTag, TArray<FInstancedStruct>>& B)
+{
+	if (A.Num() != B.Num())
+	{
+		return false;
+	}
+	for (const TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : A)
+	{
+		const TArray<FInstancedStruct>* Other = B.Find(Pair.Key);
+		if (!Other || *Other != Pair.Value)
+		{
+			return false;
+		}
+	}
+	return true;
+}
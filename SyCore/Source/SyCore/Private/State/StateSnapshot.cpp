@@ -0,0 +1,47 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateSnapshot.h"
+
+FSyStateParameterSet FSyStateSnapshot::ToParameterSet() const
+{
+	FSyStateParameterSet Result;
+	Result.Parameters.Reserve(Entries.Num());
+	for (const TPair<FGameplayTag, FSyStateSnapshotEntryRef>& Pair : Entries)
+	{
+		Result.Parameters.Emplace(Pair.Key, Pair.Value->Params);
+	}
+	return Result;
+}
+
+void FSyStateSnapshot::Diff(const FSyStateSnapshot* NewSnapshot, const FSyStateSnapshot* OldSnapshot,
+	TArray<FGameplayTag>& OutChangedTags, TArray<FGameplayTag>& OutRemovedTags)
+{
+	if (NewSnapshot == OldSnapshot)
+	{
+		return;
+	}
+
+	if (NewSnapshot)
+	{
+		for (const TPair<FGameplayTag, FSyStateSnapshotEntryRef>& Pair : NewSnapshot->Entries)
+		{
+			// 条目在版本间共享，指针相同即内容未变化
+			const FSyStateSnapshotEntryRef* OldEntry = OldSnapshot ? OldSnapshot->Entries.Find(Pair.Key) : nullptr;
+			if (!OldEntry || &OldEntry->Get() != &Pair.Value.Get())
+			{
+				OutChangedTags.Add(Pair.Key);
+			}
+		}
+	}
+
+	if (OldSnapshot)
+	{
+		for (const TPair<FGameplayTag, FSyStateSnapshotEntryRef>& Pair : OldSnapshot->Entries)
+		{
+			if (!NewSnapshot || !NewSnapshot->Entries.Contains(Pair.Key))
+			{
+				OutRemovedTags.Add(Pair.Key);
+			}
+		}
+	}
+}
@@ -0,0 +1,125 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateTagSchema.h"
+#include "State/Types/StateMetadataTypes.h"
+#include "DS_TagMetadata.h"
+#include "GameplayTagsModule.h"
+#include "UObject/UObjectGlobals.h"
+
+FSyStateTagSchemaCache* FSyStateTagSchemaCache::Instance = nullptr;
+
+FSyStateTagSchemaCache& FSyStateTagSchemaCache::Get()
+{
+	check(Instance);
+	return *Instance;
+}
+
+void FSyStateTagSchemaCache::Initialize()
+{
+	if (!Instance)
+	{
+		Instance = new FSyStateTagSchemaCache();
+	}
+}
+
+void FSyStateTagSchemaCache::Shutdown()
+{
+	delete Instance;
+	Instance = nullptr;
+}
+
+FSyStateTagSchemaCache::FSyStateTagSchemaCache()
+{
+	TagTreeChangedHandle = IGameplayTagsModule::OnGameplayTagTreeChanged.AddRaw(this, &FSyStateTagSchemaCache::Invalidate);
+#if WITH_EDITOR
+	PropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddRaw(this, &FSyStateTagSchemaCache::HandleObjectPropertyChanged);
+	ObjectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddRaw(this, &FSyStateTagSchemaCache::HandleObjectsReplaced);
+#endif
+}
+
+FSyStateTagSchemaCache::~FSyStateTagSchemaCache()
+{
+	IGameplayTagsModule::OnGameplayTagTreeChanged.Remove(TagTreeChangedHandle);
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangedHandle);
+	FCoreUObjectDelegates::OnObjectsReplaced.Remove(ObjectsReplacedHandle);
+#endif
+}
+
+TSharedRef<const FSyStateTagSchema> FSyStateTagSchemaCache::FindOrBuild(const FGameplayTag& StateTag)
+{
+	{
+		FReadScopeLock ReadLock(SchemasLock);
+		if (const TSharedRef<FSyStateTagSchema>* Existing = Schemas.Find(StateTag))
+		{
+			return *Existing;
+		}
+	}
+
+	// 在锁外解析（GetValueDataType 可能进入蓝图），并发解析同一标签时以先写入的为准
+	TSharedRef<FSyStateTagSchema> Schema = BuildSchema(StateTag);
+
+	FWriteScopeLock WriteLock(SchemasLock);
+	if (const TSharedRef<FSyStateTagSchema>* Existing = Schemas.Find(StateTag))
+	{
+		return *Existing;
+	}
+	Schemas.Add(StateTag, Schema);
+	return Schema;
+}
+
+void FSyStateTagSchemaCache::Invalidate()
+{
+	FWriteScopeLock WriteLock(SchemasLock);
+	Schemas.Empty();
+}
+
+TSharedRef<FSyStateTagSchema> FSyStateTagSchemaCache::BuildSchema(const FGameplayTag& StateTag)
+{
+	TSharedRef<FSyStateTagSchema> Schema = MakeShared<FSyStateTagSchema>();
+	if (!StateTag.IsValid())
+	{
+		return Schema;
+	}
+
+	for (UO_TagMetadata* TemplateInstance : UDS_TagMetadata::GetTagMetadata(StateTag))
+	{
+		if (const USyStateMetadataBase* TemplateMetadata = Cast<USyStateMetadataBase>(TemplateInstance))
+		{
+			FSyStateTagSchema::FSlot& Slot = Schema->Slots.AddDefaulted_GetRef();
+			Slot.MetadataClass = TemplateMetadata->GetClass();
+			Slot.ValueType = TemplateMetadata->GetValueDataType();
+		}
+	}
+	return Schema;
+}
+
+void FSyStateTagSchemaCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	FReadScopeLock ReadLock(SchemasLock);
+	for (TPair<FGameplayTag, TSharedRef<FSyStateTagSchema>>& Pair : Schemas)
+	{
+		for (FSyStateTagSchema::FSlot& Slot : Pair.Value->Slots)
+		{
+			Collector.AddReferencedObject(Slot.MetadataClass);
+			Collector.AddReferencedObject(Slot.ValueType);
+		}
+	}
+}
+
+#if WITH_EDITOR
+void FSyStateTagSchemaCache::HandleObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	// 标签元数据资产或其中的模板被编辑
+	if (Object && (Object->IsA<UDS_TagMetadata>() || Object->IsA<UO_TagMetadata>() || Object->GetTypedOuter<UDS_TagMetadata>()))
+	{
+		Invalidate();
+	}
+}
+
+void FSyStateTagSchemaCache::HandleObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap)
+{
+	// 蓝图元数据类重编译后旧类被替换
+	Invalidate();
+}
+#endif
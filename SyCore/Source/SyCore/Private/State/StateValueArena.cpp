@@ -0,0 +1,257 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/StateValueArena.h"
+#include "UObject/UObjectGlobals.h"
+
+FSyStateValueArena::FSyStateValueArena(const FSyStateValueArena& Other)
+{
+	CopyFrom(Other);
+}
+
+FSyStateValueArena& FSyStateValueArena::operator=(const FSyStateValueArena& Other)
+{
+	if (this != &Other)
+	{
+		Reset();
+		CopyFrom(Other);
+	}
+	return *this;
+}
+
+FSyStateValueArena& FSyStateValueArena::operator=(FSyStateValueArena&& Other)
+{
+	if (this != &Other)
+	{
+		Reset();
+		Ranges = MoveTemp(Other.Ranges);
+		Slots = MoveTemp(Other.Slots);
+		Memory = MoveTemp(Other.Memory);
+		WastedBytes = Other.WastedBytes;
+		WastedSlots = Other.WastedSlots;
+		Other.WastedBytes = 0;
+		Other.WastedSlots = 0;
+	}
+	return *this;
+}
+
+FSyStateValueArena::~FSyStateValueArena()
+{
+	Reset();
+}
+
+void FSyStateValueArena::SetValues(const FGameplayTag& StateTag, TConstArrayView<FInstancedStruct> Values)
+{
+	if (FRange* Existing = Ranges.Find(StateTag))
+	{
+		// 布局不变（最常见：同一个值被反复更新），原地拷贝
+		if (MatchesLayout(*Existing, Values))
+		{
+			int32 SlotIndex = Existing->FirstSlot;
+			for (const FInstancedStruct& Value : Values)
+			{
+				if (Value.IsValid())
+				{
+					const FSlot& Slot = Slots[SlotIndex++];
+					Slot.ValueType->CopyScriptStruct(GetValuePtr(Slot), Value.GetMemory());
+				}
+			}
+			return;
+		}
+		ReleaseRange(*Existing);
+	}
+
+	FRange NewRange;
+	NewRange.FirstSlot = Slots.Num();
+	for (const FInstancedStruct& Value : Values)
+	{
+		if (!Value.IsValid())
+		{
+			continue;
+		}
+
+		UScriptStruct* ValueType = const_cast<UScriptStruct*>(Value.GetScriptStruct());
+		FSlot& Slot = Slots.AddDefaulted_GetRef();
+		Slot.ValueType = ValueType;
+		Slot.Offset = AllocateValue(ValueType);
+		ValueType->CopyScriptStruct(GetValuePtr(Slot), Value.GetMemory());
+		++NewRange.NumSlots;
+	}
+	Ranges.Add(StateTag, NewRange);
+
+	if (WastedBytes > 256 && WastedBytes * 2 > Memory.Num())
+	{
+		Compact();
+	}
+}
+
+bool FSyStateValueArena::RemoveTag(const FGameplayTag& StateTag)
+{
+	FRange Range;
+	if (!Ranges.RemoveAndCopyValue(StateTag, Range))
+	{
+		return false;
+	}
+	ReleaseRange(Range);
+	return true;
+}
+
+const void* FSyStateValueArena::FindValue(const FGameplayTag& StateTag, const UScriptStruct* ValueType) const
+{
+	if (const FRange* Range = Ranges.Find(StateTag))
+	{
+		for (int32 SlotIndex = Range->FirstSlot; SlotIndex < Range->FirstSlot + Range->NumSlots; ++SlotIndex)
+		{
+			if (Slots[SlotIndex].ValueType == ValueType)
+			{
+				return GetValuePtr(Slots[SlotIndex]);
+			}
+		}
+	}
+	return nullptr;
+}
+
+bool FSyStateValueArena::GetValues(const FGameplayTag& StateTag, TArray<FInstancedStruct>& OutValues) const
+{
+	const FRange* Range = Ranges.Find(StateTag);
+	if (!Range)
+	{
+		return false;
+	}
+
+	OutValues.Reserve(OutValues.Num() + Range->NumSlots);
+	for (int32 SlotIndex = Range->FirstSlot; SlotIndex < Range->FirstSlot + Range->NumSlots; ++SlotIndex)
+	{
+		const FSlot& Slot = Slots[SlotIndex];
+		FInstancedStruct& Value = OutValues.AddDefaulted_GetRef();
+		Value.InitializeAs(Slot.ValueType, GetValuePtr(Slot));
+	}
+	return true;
+}
+
+void FSyStateValueArena::Reset()
+{
+	for (const TPair<FGameplayTag, FRange>& Pair : Ranges)
+	{
+		for (int32 SlotIndex = Pair.Value.FirstSlot; SlotIndex < Pair.Value.FirstSlot + Pair.Value.NumSlots; ++SlotIndex)
+		{
+			Slots[SlotIndex].ValueType->DestroyStruct(GetValuePtr(Slots[SlotIndex]));
+		}
+	}
+	Ranges.Reset();
+	Slots.Reset();
+	Memory.Reset();
+	WastedBytes = 0;
+	WastedSlots = 0;
+}
+
+SIZE_T FSyStateValueArena::GetAllocatedSize() const
+{
+	return Ranges.GetAllocatedSize() + Slots.GetAllocatedSize() + Memory.GetAllocatedSize();
+}
+
+void FSyStateValueArena::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for (const TPair<FGameplayTag, FRange>& Pair : Ranges)
+	{
+		for (int32 SlotIndex = Pair.Value.FirstSlot; SlotIndex < Pair.Value.FirstSlot + Pair.Value.NumSlots; ++SlotIndex)
+		{
+			FSlot& Slot = Slots[SlotIndex];
+			Collector.AddReferencedObject(Slot.ValueType);
+			if (Slot.ValueType)
+			{
+				Collector.AddPropertyReferencesWithStructARO(Slot.ValueType, GetValuePtr(Slot));
+			}
+		}
+	}
+}
+
+int32 FSyStateValueArena::AllocateValue(const UScriptStruct* ValueType)
+{
+	const int32 Offset = Align(Memory.Num(), FMath::Max(ValueType->GetMinAlignment(), 1));
+	Memory.SetNumZeroed(Offset + ValueType->GetStructureSize());
+	ValueType->InitializeStruct(Memory.GetData() + Offset);
+	return Offset;
+}
+
+void FSyStateValueArena::ReleaseRange(const FRange& Range)
+{
+	for (int32 SlotIndex = Range.FirstSlot; SlotIndex < Range.FirstSlot + Range.NumSlots; ++SlotIndex)
+	{
+		FSlot& Slot = Slots[SlotIndex];
+		Slot.ValueType->DestroyStruct(GetValuePtr(Slot));
+		WastedBytes += Slot.ValueType->GetStructureSize();
+		Slot.ValueType = nullptr;
+	}
+	WastedSlots += Range.NumSlots;
+}
+
+bool FSyStateValueArena::MatchesLayout(const FRange& Range, TConstArrayView<FInstancedStruct> Values) const
+{
+	int32 SlotIndex = Range.FirstSlot;
+	for (const FInstancedStruct& Value : Values)
+	{
+		if (!Value.IsValid())
+		{
+			continue;
+		}
+		if (SlotIndex >= Range.FirstSlot + Range.NumSlots || Slots[SlotIndex].ValueType != Value.GetScriptStruct())
+		{
+			return false;
+		}
+		++SlotIndex;
+	}
+	return SlotIndex == Range.FirstSlot + Range.NumSlots;
+}
+
+void FSyStateValueArena::Compact()
+{
+	TArray<FSlot> NewSlots;
+	NewSlots.Reserve(Slots.Num() - WastedSlots);
+	TArray<uint8, TAlignedHeapAllocator<16>> NewMemory;
+	NewMemory.Reserve(Memory.Num() - WastedBytes);
+
+	for (TPair<FGameplayTag, FRange>& Pair : Ranges)
+	{
+		const int32 NewFirstSlot = NewSlots.Num();
+		for (int32 SlotIndex = Pair.Value.FirstSlot; SlotIndex < Pair.Value.FirstSlot + Pair.Value.NumSlots; ++SlotIndex)
+		{
+			const FSlot& Slot = Slots[SlotIndex];
+			const int32 Size = Slot.ValueType->GetStructureSize();
+			const int32 NewOffset = Align(NewMemory.Num(), FMath::Max(Slot.ValueType->GetMinAlignment(), 1));
+			NewMemory.SetNumUninitialized(NewOffset + Size);
+
+			// 按位搬移，旧内存随后直接释放，不再析构
+			FMemory::Memcpy(NewMemory.GetData() + NewOffset, GetValuePtr(Slot), Size);
+			NewSlots.Add({ Slot.ValueType, NewOffset });
+		}
+		Pair.Value.FirstSlot = NewFirstSlot;
+	}
+
+	Slots = MoveTemp(NewSlots);
+	Memory = MoveTemp(NewMemory);
+	WastedBytes = 0;
+	WastedSlots = 0;
+}
+
+void FSyStateValueArena::CopyFrom(const FSyStateValueArena& Other)
+{
+	Ranges.Reserve(Other.Ranges.Num());
+	Slots.Reserve(Other.Slots.Num() - Other.WastedSlots);
+	Memory.Reserve(Other.Memory.Num() - Other.WastedBytes);
+
+	for (const TPair<FGameplayTag, FRange>& Pair : Other.Ranges)
+	{
+		FRange NewRange;
+		NewRange.FirstSlot = Slots.Num();
+		NewRange.NumSlots = Pair.Value.NumSlots;
+		for (int32 SlotIndex = Pair.Value.FirstSlot; SlotIndex < Pair.Value.FirstSlot + Pair.Value.NumSlots; ++SlotIndex)
+		{
+			const FSlot& OtherSlot = Other.Slots[SlotIndex];
+			FSlot& Slot = Slots.AddDefaulted_GetRef();
+			Slot.ValueType = OtherSlot.ValueType;
+			Slot.Offset = AllocateValue(OtherSlot.ValueType);
+			Slot.ValueType->CopyScriptStruct(GetValuePtr(Slot), Other.GetValuePtr(OtherSlot));
+		}
+		Ranges.Add(Pair.Key, NewRange);
+	}
+}
@@ -2,12 +2,16 @@
 
 #include "State/SyStateComponent.h"
 #include "State/SyStateManagerSubsystem.h" // 包含 StateManager 子系统
+#include "State/SyStateUpdateSubsystem.h"
+#include "State/StateTagSchema.h"
 #include "Entity/SyEntityComponent.h" // Include Entity Component
 #include "GameFramework/Actor.h"
 #include "Engine/World.h"
 #include "Logging/LogMacros.h"
 #include "State/Types/StateContainerTypes.h" // Included via header, but good practice
 #include "State/Types/StateParameterTypes.h" // Included via header, but good practice
+#include "State/Types/StateMetadataTypes.h"
+#include "State/Types/Metadatas/NumericModifierTypes.h"
 #include "Engine/GameInstance.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogSyStateComponent, Log, All); // 添加日志分类
@@ -44,10 +48,11 @@ void USyStateComponent::OnSyComponentInitialized()
     
     // 1. 查找并缓存 EntityComponent
     FindAndCacheEntityComponent();
+    LayeredState.SetPackedValueStorage(bUsePackedValueStorage);
 
     // 2. 应用默认初始化数据到本地状态
     UE_LOG(LogSyStateComponent, Log, TEXT("%s: Applying initialization data to Default layer."), *GetNameSafe(GetOwner()));
-    LayeredState.ApplyParameterSetToLayer(ESyStateLayer::Default, DefaultInitData);
+    ApplyDefaultLayer(DefaultInitData);
 
     // 3. 如果启用全局同步，连接到 StateManager 并应用全局状态
     if (bEnableGlobalSync)
@@ -55,9 +60,8 @@ void USyStateComponent::OnSyComponentInitialized()
         TryConnectToStateManager();
         if (StateManagerSubsystem)
         {
-            // 应用全局状态，但不广播（稍后统一广播）
-            FSyStateParameterSet AggregatedMods = StateManagerSubsystem->GetAggregatedModifications(GetTargetTypeTag());
-            LayeredState.ApplyParameterSetToLayer(ESyStateLayer::Persistent, AggregatedMods);
+            // 应用全局状态，但不广播（尚未完全初始化，稍后统一广播）
+            ApplyAggregatedModifications();
             
             UE_LOG(LogSyStateComponent, Log, TEXT("%s: Applied global state from StateManager."), *GetNameSafe(GetOwner()));
         }
@@ -69,20 +73,51 @@ void USyStateComponent::OnSyComponentInitialized()
     
     // 4. 标记为已完全初始化
     bIsFullyInitialized = true;
+
+    // 之后的快照同步交给世界级批量更新
+    if (bEnableGlobalSync && bUseBatchedStateUpdate)
+    {
+        if (UWorld* World = GetWorld())
+        {
+            StateUpdateSubsystem = World->GetSubsystem<USyStateUpdateSubsystem>();
+            if (StateUpdateSubsystem)
+            {
+                StateUpdateSubsystem->RegisterComponent(this);
+            }
+        }
+    }
     
     // 5. ✅ 广播初始状态（此时所有 Core 阶段组件都已准备好）
     UE_LOG(LogSyStateComponent, Log, TEXT("%s: StateComponent fully initialized, broadcasting initial state."), *GetNameSafe(GetOwner()));
-    OnEffectiveStateChanged.Broadcast();
+    BroadcastEffectiveStateChanges(true);
 }
 
 void USyStateComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
     // 断开与 StateManager 的连接
     DisconnectFromStateManager();
+    if (StateUpdateSubsystem)
+    {
+        StateUpdateSubsystem->UnregisterComponent(this);
+        StateUpdateSubsystem = nullptr;
+    }
+    for (FSyStateSnapshotPtr& Applied : AppliedSnapshots)
+    {
+        Applied.Reset();
+    }
+    bHasSyncedSnapshots = false;
+    StateTagListeners.Empty();
 
     Super::EndPlay(EndPlayReason);
 }
 
+void USyStateComponent::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+    // 紧凑存储中的值与按需生成的元数据对象不经过 UPROPERTY 追踪
+    CastChecked<USyStateComponent>(InThis)->LayeredState.AddReferencedObjects(Collector);
+    Super::AddReferencedObjects(InThis, Collector);
+}
+
 void USyStateComponent::FindAndCacheEntityComponent()
 {
     if (!GetOwner())
@@ -122,12 +157,24 @@ void USyStateComponent::ApplyInitializationData(const FSyStateParameterSet& Init
     UE_LOG(LogSyStateComponent, Log, TEXT("%s: Applying initialization data to Default layer."), *GetNameSafe(GetOwner()));
     
     // 应用到默认层
-    LayeredState.ApplyParameterSetToLayer(ESyStateLayer::Default, InitData);
+    ApplyDefaultLayer(InitData);
 
     // Broadcast that the effective state has changed (只有在完全初始化后才广播)
     if (bIsFullyInitialized)
     {
-        OnEffectiveStateChanged.Broadcast();
+        BroadcastEffectiveStateChanges();
+    }
+}
+
+void USyStateComponent::ApplyDefaultLayer(const FSyStateParameterSet& InitData)
+{
+    if (bShareDefaultLayer)
+    {
+        LayeredState.SetSharedDefaultLayer(InitData);
+    }
+    else
+    {
+        LayeredState.ApplyParameterSetToLayer(ESyStateLayer::Default, InitData);
     }
 }
 
@@ -139,7 +186,7 @@ void USyStateComponent::ApplyTemporaryModifications(const FSyStateParameterSet&
     LayeredState.ApplyParameterSetToLayer(ESyStateLayer::Temporary, TempModifications);
 
     // Broadcast that the effective state has changed
-    OnEffectiveStateChanged.Broadcast();
+    BroadcastEffectiveStateChanges();
 }
 
 void USyStateComponent::ClearStateLayer(ESyStateLayer Layer)
@@ -149,38 +196,95 @@ void USyStateComponent::ClearStateLayer(ESyStateLayer Layer)
     LayeredState.ClearLayer(Layer);
 
     // Broadcast that the effective state has changed
+    BroadcastEffectiveStateChanges();
+}
+
+USyStateComponent::FOnStateTagChanged& USyStateComponent::OnStateTagChanged(const FGameplayTag& StateTag)
+{
+    if (TSharedRef<FOnStateTagChanged>* Existing = StateTagListeners.Find(StateTag))
+    {
+        return Existing->Get();
+    }
+    return StateTagListeners.Add(StateTag, MakeShared<FOnStateTagChanged>()).Get();
+}
+
+void USyStateComponent::RemoveStateTagListeners(const void* UserObject)
+{
+    for (auto It = StateTagListeners.CreateIterator(); It; ++It)
+    {
+        It.Value()->RemoveAll(UserObject);
+        if (!It.Value()->IsBound())
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+void USyStateComponent::BroadcastEffectiveStateChanges(bool bAllTags)
+{
+    FSyEffectiveStateChange Change;
+    LayeredState.ConsumeEffectiveChanges(Change);
+    Change.bAllTags |= bAllTags;
+    DispatchEffectiveStateChange(Change);
+}
+
+void USyStateComponent::DispatchEffectiveStateChange(FSyEffectiveStateChange& Change)
+{
+    if (Change.bAllTags)
+    {
+        Change.ChangedTags.Reset();
+    }
+    else if (Change.IsEmpty())
+    {
+        // 修改全部被更高层遮盖，有效状态没有变化
+        return;
+    }
+
     OnEffectiveStateChanged.Broadcast();
+    OnEffectiveStateTagsChanged.Broadcast(Change);
+
+    if (StateTagListeners.Num() == 0)
+    {
+        return;
+    }
+
+    // 先收集再广播：回调中可能增删订阅
+    TArray<TPair<FGameplayTag, TSharedRef<FOnStateTagChanged>>> ToNotify;
+    for (const TPair<FGameplayTag, TSharedRef<FOnStateTagChanged>>& Pair : StateTagListeners)
+    {
+        if (Change.AffectsTag(Pair.Key))
+        {
+            ToNotify.Emplace(Pair.Key, Pair.Value);
+        }
+    }
+    for (const TPair<FGameplayTag, TSharedRef<FOnStateTagChanged>>& Pair : ToNotify)
+    {
+        Pair.Value->Broadcast(Pair.Key);
+    }
 }
 
 // --- State Access ---
 
 const FSyStateCategories& USyStateComponent::GetStateLayer(ESyStateLayer Layer) const
 {
+    // 蓝图可能跨帧持有返回的元数据对象，这些对象之后不再入池复用
+    LayeredState.MarkMetadataHandedOut();
     return LayeredState.GetLayer(Layer);
 }
 
-FSyStateCategories USyStateComponent::GetEffectiveStateCategories() const
+const FSyStateCategories& USyStateComponent::GetEffectiveStateCategories() const
 {
+    LayeredState.MarkMetadataHandedOut();
     // 使用分层容器的缓存机制获取有效状态
     return LayeredState.GetEffectiveState();
 }
 
 bool USyStateComponent::GetEffectiveStateParam(FGameplayTag StateTag, FInstancedStruct& OutParam) const
 {
-    // 获取有效状态（已自动按优先级合并）
-    FSyStateCategories EffectiveState = GetEffectiveStateCategories();
-    
-    if (const FSyStateMetadatas* Metadatas = EffectiveState.GetStateDataMap().Find(StateTag))
+    // 只查找胜出层中该标签的值，不合并其余标签
+    if (LayeredState.GetFirstEffectiveValue(StateTag, OutParam))
     {
-        // Find the first valid metadata param
-        for(const auto& MetaPtr : Metadatas->MetadataArray)
-        {
-            if(const USyStateMetadataBase* Metadata = Cast<USyStateMetadataBase>(MetaPtr))
-            {
-                 OutParam = Metadata->GetValueStruct();
-                 if (OutParam.IsValid()) return true;
-            }
-        }
+        return true;
     }
 
     // Not found
@@ -208,13 +312,21 @@ void USyStateComponent::TryConnectToStateManager()
             return;
         }
         
-        // 使用智能订阅（只订阅相关的目标类型）
-        FOnStateModificationChangedNative Delegate;
-        Delegate.BindUObject(this, &USyStateComponent::HandleStateModificationChanged);
+        // 使用智能订阅：目标类型 + 本实例的别名 / 实体ID（实例定向的操作只会通知本组件）
+        FOnTargetStateChangedNative Delegate;
+        Delegate.BindUObject(this, &USyStateComponent::HandleTargetStateChanged);
         
-        StateManagerSubsystem->SubscribeToTargetType(TargetTag, this, Delegate);
-        UE_LOG(LogSyStateComponent, Log, TEXT("%s: ✅ Subscribed to StateManager for target type: %s"), 
-            *GetNameSafe(GetOwner()), *TargetTag.ToString());
+        FSyStateTargetKey TargetKeys[(int32)ESyStateTargetScope::Num];
+        GetStateTargetKeys(TargetKeys);
+        for (const FSyStateTargetKey& TargetKey : TargetKeys)
+        {
+            if (TargetKey.IsValid())
+            {
+                StateManagerSubsystem->SubscribeToTarget(TargetKey, this, Delegate);
+                UE_LOG(LogSyStateComponent, Log, TEXT("%s: ✅ Subscribed to StateManager for target: %s"), 
+                    *GetNameSafe(GetOwner()), *TargetKey.ToString());
+            }
+        }
     }
     else 
     { 
@@ -233,39 +345,177 @@ void USyStateComponent::DisconnectFromStateManager()
     }
 }
 
-void USyStateComponent::HandleStateModificationChanged(const FSyStateModificationRecord& ChangedRecord)
+void USyStateComponent::HandleTargetStateChanged(const FSyTargetStateChange& Change)
 {
     if (!StateManagerSubsystem || !bEnableGlobalSync) return;
 
-    // 智能订阅已过滤不相关记录，直接应用
-    UE_LOG(LogSyStateComponent, VeryVerbose, TEXT("%s: 📨 Received state modification (OpID: %s). Re-applying aggregated modifications."),
-        *GetNameSafe(GetOwner()), *ChangedRecord.Operation.OperationId.ToString());
-     
+    // 智能订阅已过滤不相关目标，且同一周期内的多条记录已合并为一次通知
+    UE_LOG(LogSyStateComponent, VeryVerbose, TEXT("%s: 📨 Received %d coalesced state modification(s) touching [%s]. Syncing snapshot."),
+        *GetNameSafe(GetOwner()), Change.NumRecords, *Change.ChangedStateTags.ToStringSimple());
+
+    // 延迟通知本就在帧末派发：交给批量更新与其它实体一起同步；立即模式下保持同步应用
+    if (StateUpdateSubsystem && StateManagerSubsystem->GetNotificationMode() == ESyStateNotificationMode::Deferred
+        && StateUpdateSubsystem->RequestUpdate(this))
+    {
+        return;
+    }
+
     ApplyAggregatedModifications();
 }
 
-void USyStateComponent::ApplyAggregatedModifications()
+void USyStateComponent::GetStateTargetKeys(FSyStateTargetKey (&OutKeys)[(int32)ESyStateTargetScope::Num]) const
 {
-    if (!StateManagerSubsystem || !bEnableGlobalSync) return;
+    OutKeys[(int32)ESyStateTargetScope::Type] = FSyStateTargetKey::FromType(GetTargetTypeTag());
+    OutKeys[(int32)ESyStateTargetScope::Alias] = FSyStateTargetKey::FromAlias(EntityComponent ? EntityComponent->GetEntityAlias() : NAME_None);
+    OutKeys[(int32)ESyStateTargetScope::Entity] = FSyStateTargetKey::FromEntity(EntityComponent ? EntityComponent->GetEntityId() : FGuid());
+}
+
+bool USyStateComponent::ApplyAggregatedModifications()
+{
+    FSyStateSyncRequest Request;
+    if (!PrepareSnapshotSync(Request))
+    {
+        return false;
+    }
+
+    ApplySnapshotSync(Request);
+
+    // Broadcast that the effective state definitely changed (只有在完全初始化后才广播)
+    if (bIsFullyInitialized)
+    {
+        BroadcastEffectiveStateChanges();
+    }
+    return true;
+}
+
+bool USyStateComponent::PrepareSnapshotSync(FSyStateSyncRequest& OutRequest)
+{
+    OutRequest.Reset();
+    if (!StateManagerSubsystem || !bEnableGlobalSync) return false;
 
     FGameplayTag CurrentTargetTag = GetTargetTypeTag();
     if (!CurrentTargetTag.IsValid()) 
     { 
         UE_LOG(LogSyStateComponent, Warning, TEXT("%s: Cannot apply mods, invalid TargetTag."), *GetNameSafe(GetOwner())); 
-        return; 
+        return false; 
     }
 
-    FSyStateParameterSet AggregatedMods = StateManagerSubsystem->GetAggregatedModifications(CurrentTargetTag);
+    constexpr int32 NumScopes = (int32)ESyStateTargetScope::Num;
+    FSyStateTargetKey TargetKeys[NumScopes];
+    GetStateTargetKeys(TargetKeys);
+
+    // 取各范围的最新快照，与上次应用的快照比较，收集受影响的状态标签
+    for (int32 ScopeIndex = 0; ScopeIndex < NumScopes; ++ScopeIndex)
+    {
+        FSyStateSnapshotPtr& NewSnapshot = OutRequest.NewSnapshots[ScopeIndex];
+        if (TargetKeys[ScopeIndex].IsValid())
+        {
+            // 类型范围使用层级有效快照：父类型（如 Entity.NPC）的操作同样作用于本类型
+            NewSnapshot = ScopeIndex == (int32)ESyStateTargetScope::Type
+                ? StateManagerSubsystem->GetEffectiveTypeSnapshot(TargetKeys[ScopeIndex].TypeTag)
+                : StateManagerSubsystem->GetSnapshot(TargetKeys[ScopeIndex]);
+        }
+
+        // 快照未变化（同一版本的共享对象），跳过
+        if (NewSnapshot == AppliedSnapshots[ScopeIndex])
+        {
+            continue;
+        }
 
-    // 应用到持久层（全局状态层）
-    LayeredState.ApplyParameterSetToLayer(ESyStateLayer::Persistent, AggregatedMods);
+        TArray<FGameplayTag> ChangedTags;
+        TArray<FGameplayTag> RemovedTags;
+        FSyStateSnapshot::Diff(NewSnapshot.Get(), AppliedSnapshots[ScopeIndex].Get(), ChangedTags, RemovedTags);
+        OutRequest.DirtyTags.Append(ChangedTags);
+        OutRequest.DirtyTags.Append(RemovedTags);
+    }
 
-    UE_LOG(LogSyStateComponent, Verbose, TEXT("%s: Applied aggregated modifications to Persistent layer for Tag %s."), 
-        *GetNameSafe(GetOwner()), *CurrentTargetTag.ToString());
+    OutRequest.bFirstSync = !bHasSyncedSnapshots;
+    for (int32 ScopeIndex = 0; ScopeIndex < NumScopes; ++ScopeIndex)
+    {
+        AppliedSnapshots[ScopeIndex] = OutRequest.NewSnapshots[ScopeIndex];
+    }
+    bHasSyncedSnapshots = true;
 
-    // Broadcast that the effective state definitely changed (只有在完全初始化后才广播)
-    if (bIsFullyInitialized)
+    if (!OutRequest.bFirstSync && OutRequest.DirtyTags.Num() == 0)
+    {
+        return false;
+    }
+
+    // 结构描述的首次解析会读取标签元数据模板，在游戏线程完成（应用可能在工作线程中进行）
+    if (CanApplySnapshotSyncInParallel())
     {
-        OnEffectiveStateChanged.Broadcast();
+        for (const FGameplayTag& StateTag : OutRequest.DirtyTags)
+        {
+            FSyStateTagSchemaCache::Get().FindOrBuild(StateTag);
+        }
     }
+    return true;
+}
+
+void USyStateComponent::ApplySnapshotSync(const FSyStateSyncRequest& Request)
+{
+    constexpr int32 NumScopes = (int32)ESyStateTargetScope::Num;
+    const FSyStateSnapshotPtr (&NewSnapshots)[NumScopes] = Request.NewSnapshots;
+
+    // 首次同步时 Persistent 层可能残留存档数据，先整体清空再按快照重建
+    if (Request.bFirstSync)
+    {
+        LayeredState.ClearLayer(ESyStateLayer::Persistent);
+    }
+
+    // 只更新受影响的标签：按 类型 < 别名 < 实体 的顺序合并（列表追加，其余覆盖）
+    for (const FGameplayTag& StateTag : Request.DirtyTags)
+    {
+        const TArray<FInstancedStruct>* SingleSource = nullptr;
+        TArray<FInstancedStruct> MergedParams;
+        int32 NumSources = 0;
+        for (int32 ScopeIndex = 0; ScopeIndex < NumScopes; ++ScopeIndex)
+        {
+            const TArray<FInstancedStruct>* ScopeParams = NewSnapshots[ScopeIndex].IsValid() ? NewSnapshots[ScopeIndex]->FindParams(StateTag) : nullptr;
+            if (!ScopeParams)
+            {
+                continue;
+            }
+
+            if (NumSources == 0)
+            {
+                SingleSource = ScopeParams;
+            }
+            else
+            {
+                if (NumSources == 1)
+                {
+                    MergedParams = *SingleSource;
+                }
+                USyStateManagerSubsystem::MergeStateParams(MergedParams, *ScopeParams);
+            }
+            ++NumSources;
+        }
+
+        if (NumSources == 0)
+        {
+            LayeredState.RemoveTagFromLayer(ESyStateLayer::Persistent, StateTag);
+        }
+        else
+        {
+            const TArray<FInstancedStruct>& FinalParams = NumSources == 1 ? *SingleSource : MergedParams;
+            if (FSyNumericModifierStack::HasUnbasedStack(FinalParams))
+            {
+                // 没有基础值的数值修饰以 Default 层的初始值为基础（例如初始 100 + Add -10 = 90）
+                TArray<FInstancedStruct> DefaultValues;
+                LayeredState.GetLayerTagValues(ESyStateLayer::Default, StateTag, DefaultValues);
+
+                TArray<FInstancedStruct> ResolvedParams = FinalParams;
+                FSyNumericModifierStack::ResolveWithFallback(ResolvedParams, DefaultValues);
+                LayeredState.ApplyTagParamsToLayer(ESyStateLayer::Persistent, StateTag, ResolvedParams);
+            }
+            else
+            {
+                LayeredState.ApplyTagParamsToLayer(ESyStateLayer::Persistent, StateTag, FinalParams);
+            }
+        }
+    }
+
+    UE_LOG(LogSyStateComponent, Verbose, TEXT("%s: Synced Persistent layer (%d state tag(s) updated)."), 
+        *GetNameSafe(GetOwner()), Request.DirtyTags.Num());
 }
@@ -11,6 +11,19 @@
 #include "Kismet/GameplayStatics.h" // 包含 GameplayStatics
 #include "StructUtils/InstancedStruct.h"
 #include "State/Types/Metadatas/ListMetadataValueTypes.h" // *** 包含新的列表基类头文件 ***
+#include "State/Types/Metadatas/NumericModifierTypes.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Engine/GameInstance.h"
+#include "Algo/Reverse.h"
+#include "Algo/StableSort.h"
+#include "Misc/Paths.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "PlatformFeatures.h"
+#include "SaveGameSystem.h"
+#include "UObject/GarbageCollection.h"
+#include "UObject/StrongObjectPtr.h"
 
 // 定义一个简单的日志分类
 // DEFINE_LOG_CATEGORY_STATIC(LogSyStateManager, Log, All); // 启用日志以方便调试
@@ -19,6 +32,20 @@ void USyStateManagerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
     Super::Initialize(Collection);
     UE_LOG(LogSyStateManager, Log, TEXT("SyStateManagerSubsystem Initialized."));
+
+    // 延迟通知的派发 Tick：默认在帧末统一派发，仅在有待处理变化时启用
+    FlushTickFunction.Owner = this;
+    FlushTickFunction.bCanEverTick = true;
+    FlushTickFunction.bStartWithTickEnabled = false;
+    FlushTickFunction.bTickEvenWhenPaused = true;
+    FlushTickFunction.TickGroup = TG_PostUpdateWork;
+
+    PostWorldInitHandle = FWorldDelegates::OnPostWorldInitialization.AddUObject(this, &USyStateManagerSubsystem::HandlePostWorldInitialization);
+    WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddUObject(this, &USyStateManagerSubsystem::HandleWorldCleanup);
+    if (UGameInstance* GameInstance = GetGameInstance())
+    {
+        RegisterFlushTickFunction(GameInstance->GetWorld());
+    }
     // 在子系统初始化时尝试加载存档
     // TODO: 接入正常读档逻辑
     // LoadLog();
@@ -30,12 +57,86 @@ void USyStateManagerSubsystem::Deinitialize()
     // 在子系统反初始化前尝试保存日志（确保游戏退出时也能保存）
     // TODO: 接入正常读档逻辑
     // SaveLog();
+    // 与 SaveLog 一致，退出时不自动存档：Journal 中尚未 SaveLog 的增量直接丢弃（"不存档退出"）
+    if (Journal)
+    {
+        Journal->DiscardPending();
+        Journal.Reset();
+    }
+    if (PendingAsyncTask.IsValid())
+    {
+        PendingAsyncTask.Wait();
+    }
+    // 已排队的完成回调看到此标记后不再修改本子系统
+    bAsyncPersistenceInProgress = false;
+    bAsyncLoadInProgress = false;
+    OperationsRecordedDuringAsyncLoad.Empty();
+    ReleaseMappedLog();
+    FWorldDelegates::OnPostWorldInitialization.Remove(PostWorldInitHandle);
+    FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+    UnregisterFlushTickFunction();
     ModificationLog.Empty();
+    StateTagIndex.Empty();
+    SourceTagIndex.Empty();
+    SourceEntityIndex.Empty();
+    SnapshotCache.Empty();
+    SnapshotHistory.Empty();
+    PayloadPool.Reset();
+    WorkingSnapshots.Empty();
+    EffectiveTypeSnapshotCache.Empty();
+    TypeAncestryCache.Empty();
+    Checkpoints.Empty();
+    PendingCompactionTargets.Empty();
+    ResetExpiries();
+    BatchDepth = 0;
+    DirtySnapshotTargets.Empty();
+    PendingTargetNotifications.Empty();
+    PendingGlobalBroadcasts.Empty();
     OnStateModificationChanged.Clear(); // Clear the unified delegate
     Super::Deinitialize();
 }
 
+void USyStateManagerSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+    USyStateManagerSubsystem* This = CastChecked<USyStateManagerSubsystem>(InThis);
+
+    // 驻留后修改只保存在共享载荷中（不经过 UPROPERTY 追踪），共享的载荷只报告一次
+    TSet<const FSyStatePayload*> ReportedPayloads;
+    for (const FSyStateModificationRecord& Record : This->ModificationLog)
+    {
+        const FSyStatePayload* Payload = Record.Payload.Get();
+        if (!Payload)
+        {
+            continue;
+        }
+
+        bool bAlreadyReported = false;
+        ReportedPayloads.Add(Payload, &bAlreadyReported);
+        if (!bAlreadyReported)
+        {
+            Collector.AddPropertyReferencesWithStructARO(FSyStateParameterSet::StaticStruct(), const_cast<FSyStateParameterSet*>(&Payload->Parameters), This);
+        }
+    }
+
+    // 检查点中的折叠值同样不经过 UPROPERTY 追踪
+    for (TPair<FSyStateTargetKey, TArray<FSyStateCheckpointEntry>>& Pair : This->Checkpoints)
+    {
+        for (FSyStateCheckpointEntry& Entry : Pair.Value)
+        {
+            Entry.Value.AddStructReferencedObjects(Collector);
+        }
+    }
+
+    Super::AddReferencedObjects(InThis, Collector);
+}
+
 bool USyStateManagerSubsystem::RecordOperation(const FSyOperation& Operation)
+{
+    FSyStateManagerBatchScope BatchScope(this);
+    return RecordOperationInternal(Operation);
+}
+
+bool USyStateManagerSubsystem::RecordOperationInternal(const FSyOperation& Operation)
 {
     // 1. (可选) 基础验证
     if (!ValidateOperation(Operation))
@@ -44,492 +145,2417 @@ bool USyStateManagerSubsystem::RecordOperation(const FSyOperation& Operation)
         return false;
     }
 
-    // 2. 创建记录
-    FSyStateModificationRecord NewRecord(Operation);
+    // 实体ID > 别名 > 类型：带实例标识的操作只路由到对应实例
+    const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(Operation.Target);
 
-    // 3. 添加到日志
-    int32 NewIndex = ModificationLog.Num();
-    ModificationLog.Add(NewRecord);
+    // 新记录必须排在该目标从存档解码的记录之后
+    MaterializeTarget(TargetKey);
+
+    // 2. 创建记录并添加到日志
+    const int32 NewIndex = ModificationLog.Emplace(Operation);
+    if (Operation.Expiry.Clock == ESyOperationExpiryClock::GameTime)
+    {
+        // 游戏时间有效期从记录时的游戏时钟起算，时钟值随记录一起持久化
+        AdvanceExpiryGameClock();
+        ModificationLog[NewIndex].ExpiryGameClockSeconds = ExpiryGameClockSeconds;
+    }
+    const FSyStateModificationRecord& NewRecord = ModificationLog[NewIndex];
     
-    // 4. 更新索引
-    // 4.1 按目标类型索引
-    if (Operation.Target.TargetTypeTag.IsValid())
+    // 3. 更新索引
+    // 3.1 按目标索引
+    if (TargetKey.IsValid())
     {
-        TArray<int32>& Indices = TargetTypeIndex.FindOrAdd(Operation.Target.TargetTypeTag);
-        Indices.Add(NewIndex);
+        TargetIndex.FindOrAdd(TargetKey).Add(NewIndex);
     }
     
-    // 4.2 按操作ID索引
+    // 3.2 按操作ID索引
     if (Operation.OperationId.IsValid())
     {
         OperationIdIndex.Add(Operation.OperationId, NewIndex);
     }
+
+    // 3.3 查询用倒排索引
+    UpdateQueryIndices(NewRecord, INDEX_NONE, NewIndex);
+
+    // 3.4 追加到持久化日志
+    if (Journal)
+    {
+        Journal->AppendRecord(NewRecord);
+    }
+
+    // 3.5 登记有效期
+    ScheduleExpiry(NewRecord);
     
-    // 5. 增量更新聚合快照（而非简单失效）
-    if (Operation.Target.TargetTypeTag.IsValid())
+    // 4. 增量更新工作快照（若该目标在本批次内已失效，则留待提交时整体重算）
+    if (TargetKey.IsValid() && !DirtySnapshotTargets.Contains(TargetKey))
     {
-        FSyStateParameterSet& Snapshot = AggregatedCache.FindOrAdd(Operation.Target.TargetTypeTag);
+        FSyStateSnapshot& Snapshot = GetWorkingSnapshot(TargetKey);
         
-        // 获取当前快照的 Map 形式
-        TMap<FGameplayTag, TArray<FInstancedStruct>> SnapshotMap = Snapshot.GetMutableParametersMap();
+        // 只替换被修改标签的条目，其余条目与已发布快照共享
+        for (const FSyStateParams& ModParams : Operation.Modifier.StateModifications.Parameters)
+        {
+            if (!ModParams.Tag.IsValid()) continue;
+
+            TArray<FInstancedStruct> MergedParams;
+            if (const TArray<FInstancedStruct>* ExistingParams = Snapshot.FindParams(ModParams.Tag))
+            {
+                MergedParams = *ExistingParams;
+            }
+            MergeStateParams(MergedParams, ModParams.Params);
+            Snapshot.Entries.Add(ModParams.Tag, MakeShared<const FSyStateSnapshotEntry>(MoveTemp(MergedParams), Snapshot.Version));
+        }
         
-        // 将新操作的修改增量合并到快照中
-        for (const auto& ModPair : Operation.Modifier.StateModifications.GetParametersAsMap())
-        {
-            const FGameplayTag& StateTag = ModPair.Key;
-            const TArray<FInstancedStruct>& NewParams = ModPair.Value;
-            
-            // 获取快照中对应Tag的现有参数数组
-            TArray<FInstancedStruct>& SnapshotParams = SnapshotMap.FindOrAdd(StateTag);
-            
-            // 合并参数（与 AggregateRecordModifications 中的逻辑一致）
-            for (const FInstancedStruct& SourceStruct : NewParams)
-            {
-                if (!SourceStruct.IsValid()) continue;
-                
-                const UScriptStruct* StructType = SourceStruct.GetScriptStruct();
-                if (!StructType) continue;
-                
-                FInstancedStruct* ExistingPtr = SnapshotParams.FindByPredicate(
-                    [&StructType](const FInstancedStruct& Existing)
-                    {
-                        return Existing.IsValid() && Existing.GetScriptStruct() == StructType;
-                    });
-                
-                if (ExistingPtr)
-                {
-                    // 已存在相同类型的参数，合并或覆盖
-                    const UScriptStruct* ListBaseType = FSyListParameterBase::StaticStruct();
-                    if (StructType && StructType->IsChildOf(ListBaseType) && ExistingPtr->GetScriptStruct()->IsChildOf(ListBaseType))
-                    {
-                        // 列表类型 - 聚合
-                        FSyListParameterBase* TargetList = ExistingPtr->GetMutablePtr<FSyListParameterBase>();
-                        const FSyListParameterBase* SourceList = SourceStruct.GetPtr<FSyListParameterBase>();
-                        if (TargetList && SourceList)
-                        {
-                            TargetList->AggregateItemsInternal(SourceList->GetListItemsInternal());
-                        }
-                    }
-                    else
-                    {
-                        // 非列表类型 - 覆盖
-                        *ExistingPtr = SourceStruct;
-                    }
-                }
-                else
-                {
-                    // 不存在，添加新参数
-                    SnapshotParams.Add(SourceStruct);
-                }
+        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("⚡ Incrementally updated snapshot for target: %s (Version: %d)"), 
+            *TargetKey.ToString(), Snapshot.Version);
+    }
+    
+    // 5. 登记通知（批处理提交时统一派发）
+    QueueChangeNotification(NewRecord);
+
+    // 6. 修改移入载荷池，与内容相同的已有记录共享
+    PayloadPool.InternRecord(ModificationLog[NewIndex]);
+
+    // 7. 异步读档完成时会替换整个日志：保留操作，读档后重新记录
+    if (bAsyncLoadInProgress)
+    {
+        OperationsRecordedDuringAsyncLoad.Add(Operation);
+    }
+
+    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("✅ Operation recorded. RecordId: %s, OperationId: %s, Target: %s"), 
+        *ModificationLog[NewIndex].RecordId.ToString(), *Operation.OperationId.ToString(), *TargetKey.ToString());
+    return true;
+}
+
+bool USyStateManagerSubsystem::UnloadOperation(const FGuid& OperationIdToUnload)
+{
+    FSyStateManagerBatchScope BatchScope(this);
+    return UnloadOperationInternal(OperationIdToUnload);
+}
+
+bool USyStateManagerSubsystem::UnloadOperationInternal(const FGuid& OperationIdToUnload)
+{
+    if (!OperationIdToUnload.IsValid())
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("UnloadOperation called with invalid GUID."));
+        return false;
+    }
+
+    // 使用索引快速查找；不知道操作属于哪个目标，找不到时先解码全部目标再查
+    const int32* FoundIndexPtr = OperationIdIndex.Find(OperationIdToUnload);
+    if (!FoundIndexPtr && LazyTargets.Num() > 0)
+    {
+        MaterializeAllTargets();
+        FoundIndexPtr = OperationIdIndex.Find(OperationIdToUnload);
+    }
+    if (!FoundIndexPtr)
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("UnloadOperation: Operation with ID %s not found in log."), *OperationIdToUnload.ToString());
+        return false;
+    }
+
+    const int32 FoundIndex = *FoundIndexPtr;
+    if (!ModificationLog.IsValidIndex(FoundIndex))
+    {
+        UE_LOG(LogSyStateManager, Error, TEXT("UnloadOperation: Invalid index %d for operation ID %s"), FoundIndex, *OperationIdToUnload.ToString());
+        OperationIdIndex.Remove(OperationIdToUnload);
+        return false;
+    }
+
+    const FSyStateModificationRecord RemovedRecord = RemoveRecordAt(FoundIndex);
+    
+    UE_LOG(LogSyStateManager, Log, TEXT("✅ Unloaded operation with ID: %s"), *OperationIdToUnload.ToString());
+    
+    QueueChangeNotification(RemovedRecord);
+    return true;
+}
+
+FSyStateModificationRecord USyStateManagerSubsystem::RemoveRecordAt(int32 Index)
+{
+    check(ModificationLog.IsValidIndex(Index));
+
+    // 返回的记录交给通知与调用方，载荷内联后不再引用载荷池
+    FSyStateModificationRecord RemovedRecord = MoveTemp(ModificationLog[Index]);
+    RemovedRecord.InlinePayload();
+    const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(RemovedRecord.Operation.Target);
+
+    // 1. 先从索引中移除被卸载的记录
+    OperationIdIndex.Remove(RemovedRecord.Operation.OperationId);
+    ExpiryDeadlines.Remove(RemovedRecord.Operation.OperationId);
+    if (TargetKey.IsValid())
+    {
+        if (TArray<int32>* IndicesPtr = TargetIndex.Find(TargetKey))
+        {
+            // RemoveSingle 保持该目标记录列表的时间顺序（聚合顺序依赖于此）
+            IndicesPtr->RemoveSingle(Index);
+        }
+
+        // 卸载无法增量回退，标记快照在提交时整体重算，丢弃本批次的工作快照
+        DirtySnapshotTargets.Add(TargetKey);
+        WorkingSnapshots.Remove(TargetKey);
+    }
+    UpdateQueryIndices(RemovedRecord, Index, INDEX_NONE);
+
+    if (Journal)
+    {
+        Journal->AppendUnload(RemovedRecord.Operation.OperationId);
+    }
+
+    // 2. 该操作折叠进检查点的值一并移除，并附回返回的记录（通知中的变化标签因此完整）
+    if (TArray<FSyStateCheckpointEntry>* Checkpoint = Checkpoints.Find(TargetKey))
+    {
+        for (int32 EntryIndex = Checkpoint->Num() - 1; EntryIndex >= 0; --EntryIndex)
+        {
+            FSyStateCheckpointEntry& Entry = (*Checkpoint)[EntryIndex];
+            if (Entry.ContributorOperationId == RemovedRecord.Operation.OperationId)
+            {
+                TArray<FInstancedStruct> FoldedParams;
+                FoldedParams.Add(MoveTemp(Entry.Value));
+                RemovedRecord.Operation.Modifier.StateModifications.Parameters.Emplace(Entry.StateTag, FoldedParams);
+                // 保持检查点的时间顺序（聚合时较新的值覆盖较早的）
+                Checkpoint->RemoveAt(EntryIndex);
+            }
+        }
+        if (Checkpoint->Num() == 0)
+        {
+            Checkpoints.Remove(TargetKey);
+        }
+    }
+
+    // 3. 从日志中移除（使用 RemoveAtSwap 提高效率）
+    const int32 LastIndex = ModificationLog.Num() - 1;
+    ModificationLog.RemoveAtSwap(Index);
+
+    // 4. 被交换到当前位置的记录需要更新索引（原位替换，保持目标列表中的相对顺序）
+    if (Index != LastIndex)
+    {
+        const FSyStateModificationRecord& SwappedRecord = ModificationLog[Index];
+
+        if (SwappedRecord.Operation.OperationId.IsValid())
+        {
+            OperationIdIndex.Add(SwappedRecord.Operation.OperationId, Index);
+        }
+
+        if (TArray<int32>* SwappedIndicesPtr = TargetIndex.Find(FSyStateTargetKey::FromOperationTarget(SwappedRecord.Operation.Target)))
+        {
+            const int32 Position = SwappedIndicesPtr->Find(LastIndex);
+            if (Position != INDEX_NONE)
+            {
+                (*SwappedIndicesPtr)[Position] = Index;
+            }
+        }
+
+        UpdateQueryIndices(SwappedRecord, LastIndex, Index);
+    }
+
+    return RemovedRecord;
+}
+
+void USyStateManagerSubsystem::UpdateQueryIndices(const FSyStateModificationRecord& Record, int32 OldIndex, int32 NewIndex)
+{
+    // 新增：追加；移除：RemoveSingle 保持顺序；移动：原位替换
+    auto UpdateList = [OldIndex, NewIndex](TArray<int32>& Indices)
+    {
+        if (OldIndex == INDEX_NONE)
+        {
+            Indices.Add(NewIndex);
+        }
+        else if (NewIndex == INDEX_NONE)
+        {
+            Indices.RemoveSingle(OldIndex);
+        }
+        else if (const int32 Position = Indices.Find(OldIndex); Position != INDEX_NONE)
+        {
+            Indices[Position] = NewIndex;
+        }
+    };
+
+    auto UpdateEntry = [&UpdateList, NewIndex, OldIndex](auto& IndexMap, const auto& Key)
+    {
+        if (OldIndex == INDEX_NONE)
+        {
+            UpdateList(IndexMap.FindOrAdd(Key));
+        }
+        else if (TArray<int32>* Indices = IndexMap.Find(Key))
+        {
+            UpdateList(*Indices);
+            if (Indices->Num() == 0)
+            {
+                IndexMap.Remove(Key);
+            }
+        }
+    };
+
+    const FSyOperation& Operation = Record.Operation;
+
+    // 同一记录对同一状态标签只登记一次
+    TArray<FGameplayTag, TInlineAllocator<8>> VisitedStateTags;
+    for (const FSyStateParams& ModParams : Record.GetStateModifications().Parameters)
+    {
+        if (ModParams.Tag.IsValid() && !VisitedStateTags.Contains(ModParams.Tag))
+        {
+            VisitedStateTags.Add(ModParams.Tag);
+            UpdateEntry(StateTagIndex, ModParams.Tag);
+        }
+    }
+
+    if (Operation.Source.SourceTypeTag.IsValid())
+    {
+        UpdateEntry(SourceTagIndex, Operation.Source.SourceTypeTag);
+    }
+
+    if (Operation.Source.SourceEntityId.IsValid())
+    {
+        UpdateEntry(SourceEntityIndex, Operation.Source.SourceEntityId);
+    }
+}
+
+FSyStateRecordView USyStateManagerSubsystem::QueryRecords(const FSyStateRecordQuery& Query)
+{
+    MaterializeAllTargets();
+
+    // 选择候选最少的倒排索引；条件在索引中不存在时直接返回空视图
+    const TArray<int32>* BestCandidates = nullptr;
+    bool bHasIndexedFilter = false;
+
+    auto ConsiderIndex = [&BestCandidates, &bHasIndexedFilter](const TArray<int32>* Candidates)
+    {
+        static const TArray<int32> EmptyCandidates;
+        const TArray<int32>* Effective = Candidates ? Candidates : &EmptyCandidates;
+        if (!bHasIndexedFilter || Effective->Num() < BestCandidates->Num())
+        {
+            BestCandidates = Effective;
+        }
+        bHasIndexedFilter = true;
+    };
+
+    if (Query.StateTag.IsValid())
+    {
+        ConsiderIndex(StateTagIndex.Find(Query.StateTag));
+    }
+    if (Query.SourceTag.IsValid())
+    {
+        ConsiderIndex(SourceTagIndex.Find(Query.SourceTag));
+    }
+    if (Query.SourceEntityId.IsValid())
+    {
+        ConsiderIndex(SourceEntityIndex.Find(Query.SourceEntityId));
+    }
+
+    if (bHasIndexedFilter)
+    {
+        return FSyStateRecordView(ModificationLog, *BestCandidates, Query);
+    }
+
+    // 只有时间条件（或无条件）：遍历整个日志
+    return FSyStateRecordView(ModificationLog, Query);
+}
+
+TArray<FSyStateModificationRecord> USyStateManagerSubsystem::K2_QueryRecords(FGameplayTag StateTag, FGameplayTag SourceTag, FGuid SourceEntityId, FDateTime MinTimestamp, FDateTime MaxTimestamp)
+{
+    FSyStateRecordQuery Query;
+    Query.StateTag = StateTag;
+    Query.SourceTag = SourceTag;
+    Query.SourceEntityId = SourceEntityId;
+    if (MaxTimestamp > MinTimestamp)
+    {
+        Query.InTimeRange(MinTimestamp, MaxTimestamp);
+    }
+    return QueryRecords(Query).ToArray();
+}
+
+// TODO: 替换为标准过滤规则，现在没用到所以懒得整
+int32 USyStateManagerSubsystem::UnloadOperationsBySource(const FSyOperationSource& SourceToMatch)
+{
+    FSyStateManagerBatchScope BatchScope(this);
+    MaterializeAllTargets();
+
+    // 收集匹配记录的位置（升序）：有效来源标签直接使用倒排索引
+    TArray<int32> MatchedIndices;
+    if (SourceToMatch.SourceTypeTag.IsValid())
+    {
+        if (const TArray<int32>* Indexed = SourceTagIndex.Find(SourceToMatch.SourceTypeTag))
+        {
+            MatchedIndices = *Indexed;
+            MatchedIndices.Sort();
+        }
+    }
+    else
+    {
+        for (int32 i = 0; i < ModificationLog.Num(); ++i)
+        {
+            if (!ModificationLog[i].Operation.Source.SourceTypeTag.IsValid())
+            {
+                MatchedIndices.Add(i);
             }
         }
-        
-        // 将更新后的 Map 同步回快照
-        Snapshot.UpdateFromMap(SnapshotMap);
-        
-        // 更新版本号
-        CacheVersions.Add(Operation.Target.TargetTypeTag, GlobalVersion);
-        GlobalVersion++;
-        
-        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("⚡ Incrementally updated snapshot for target tag: %s (Version: %d)"), 
-            *Operation.Target.TargetTypeTag.ToString(), GlobalVersion - 1);
     }
-    
-    // 6. 广播事件
-    // 6.1 精准广播给智能订阅者（推荐方式）
-    BroadcastToSubscribers(NewRecord);
-    
-    // 6.2 全局广播（用于蓝图或需要监听所有变更的场景）
-    if (OnStateModificationChanged.IsBound())
+
+    // 从后往前移除：RemoveAtSwap 换入的总是未匹配（或已处理）的尾部记录，剩余位置保持有效
+    for (int32 i = MatchedIndices.Num() - 1; i >= 0; --i)
+    {
+        QueueChangeNotification(RemoveRecordAt(MatchedIndices[i]));
+    }
+
+    const int32 RemovedCount = MatchedIndices.Num();
+    if (RemovedCount > 0)
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("Unloaded %d operations matching source (Tag: %s)."), 
+            RemovedCount, 
+            *SourceToMatch.SourceTypeTag.ToString());
+    }
+    else
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("UnloadOperationsBySource: No operations found matching source (Tag: %s)."), 
+            *SourceToMatch.SourceTypeTag.ToString());
+    }
+
+    return RemovedCount;
+}
+
+// ===== 批处理实现 =====
+
+void USyStateManagerSubsystem::BeginBatch()
+{
+    ++BatchDepth;
+}
+
+void USyStateManagerSubsystem::CommitBatch()
+{
+    if (BatchDepth <= 0)
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("CommitBatch called without matching BeginBatch."));
+        BatchDepth = 0;
+        return;
+    }
+
+    if (--BatchDepth == 0)
+    {
+        // 延迟模式下只标记脏目标，交给本帧的派发 Tick；没有可用 Tick 时退化为立即派发
+        if (NotificationMode == ESyStateNotificationMode::Deferred && ScheduleDeferredFlush())
+        {
+            return;
+        }
+        FlushPendingChanges();
+    }
+}
+
+int32 USyStateManagerSubsystem::RecordOperations(TArrayView<const FSyOperation> Operations)
+{
+    FSyStateManagerBatchScope BatchScope(this);
+
+    int32 RecordedCount = 0;
+    for (const FSyOperation& Operation : Operations)
+    {
+        if (RecordOperationInternal(Operation))
+        {
+            ++RecordedCount;
+        }
+    }
+    return RecordedCount;
+}
+
+int32 USyStateManagerSubsystem::UnloadOperations(TArrayView<const FGuid> OperationIds)
+{
+    FSyStateManagerBatchScope BatchScope(this);
+
+    int32 UnloadedCount = 0;
+    for (const FGuid& OperationId : OperationIds)
+    {
+        if (UnloadOperationInternal(OperationId))
+        {
+            ++UnloadedCount;
+        }
+    }
+    return UnloadedCount;
+}
+
+void USyStateManagerSubsystem::QueueChangeNotification(const FSyStateModificationRecord& Record)
+{
+    const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(Record.Operation.Target);
+    if (TargetKey.IsValid())
+    {
+        // 同一目标合并为一个通知：累积变化的状态标签，保留最近一次的记录
+        FSyTargetStateChange& Change = PendingTargetNotifications.FindOrAdd(TargetKey);
+        Change.Target = TargetKey;
+        Change.LastRecord = Record;
+        ++Change.NumRecords;
+        for (const FSyStateParams& ModParams : Record.GetStateModifications().Parameters)
+        {
+            if (ModParams.Tag.IsValid())
+            {
+                Change.ChangedStateTags.AddTag(ModParams.Tag);
+            }
+        }
+    }
+
+    if (OnStateModificationChanged.IsBound())
+    {
+        PendingGlobalBroadcasts.Add(Record);
+    }
+}
+
+bool USyStateManagerSubsystem::HasPendingChanges() const
+{
+    return PendingTargetNotifications.Num() > 0 || PendingGlobalBroadcasts.Num() > 0
+        || DirtySnapshotTargets.Num() > 0 || WorkingSnapshots.Num() > 0;
+}
+
+void USyStateManagerSubsystem::FlushPendingChanges()
+{
+    // 1. 重算本批次内失效的快照（每个目标只重算一次），并发布增量更新的工作快照
+    TSet<FGameplayTag> ChangedTypeTags;
+    for (const FSyStateTargetKey& DirtyKey : DirtySnapshotTargets)
+    {
+        RecalculateSnapshotForTarget(DirtyKey);
+        if (DirtyKey.Scope == ESyStateTargetScope::Type)
+        {
+            ChangedTypeTags.Add(DirtyKey.TypeTag);
+        }
+    }
+    DirtySnapshotTargets.Reset();
+
+    for (TPair<FSyStateTargetKey, TSharedPtr<FSyStateSnapshot>>& Pair : WorkingSnapshots)
+    {
+        if (Pair.Key.Scope == ESyStateTargetScope::Type)
+        {
+            ChangedTypeTags.Add(Pair.Key.TypeTag);
+        }
+        PublishSnapshot(Pair.Key, MoveTemp(Pair.Value));
+    }
+    WorkingSnapshots.Reset();
+
+    // 1.1 重建受影响的层级有效快照（在通知前完成，订阅者读取时为 O(1)）
+    if (ChangedTypeTags.Num() > 0)
+    {
+        RefreshEffectiveTypeSnapshots(ChangedTypeTags);
+    }
+
+    // 2. 先移出待处理数据：订阅者回调中可能再次记录操作（重入会开启新的批处理）
+    TMap<FSyStateTargetKey, FSyTargetStateChange> TargetNotifications = MoveTemp(PendingTargetNotifications);
+    TArray<FSyStateModificationRecord> GlobalBroadcasts = MoveTemp(PendingGlobalBroadcasts);
+    PendingTargetNotifications.Reset();
+    PendingGlobalBroadcasts.Reset();
+    AddDescendantTypeNotifications(TargetNotifications);
+
+    // 3. 精准广播：每个受影响目标只通知一次
+    for (const TPair<FSyStateTargetKey, FSyTargetStateChange>& Pair : TargetNotifications)
+    {
+        BroadcastToSubscribers(Pair.Value);
+    }
+
+    // 4. 全局广播（用于蓝图或需要监听所有变更的场景）
+    if (OnStateModificationChanged.IsBound())
+    {
+        for (const FSyStateModificationRecord& Record : GlobalBroadcasts)
+        {
+            OnStateModificationChanged.Broadcast(Record);
+        }
+    }
+
+    if (TargetNotifications.Num() > 0)
+    {
+        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("📦 Flushed batch: %d target(s) notified, %d record(s) broadcast."), 
+            TargetNotifications.Num(), GlobalBroadcasts.Num());
+    }
+}
+
+// ===== 延迟通知实现 =====
+
+void USyStateManagerSubsystem::SetNotificationMode(ESyStateNotificationMode NewMode)
+{
+    if (NotificationMode == NewMode)
+    {
+        return;
+    }
+
+    NotificationMode = NewMode;
+    UE_LOG(LogSyStateManager, Log, TEXT("State notification mode set to %s."), 
+        NewMode == ESyStateNotificationMode::Deferred ? TEXT("Deferred") : TEXT("Immediate"));
+
+    // 切回立即模式时不能让已排队的通知等到下一帧
+    if (NewMode == ESyStateNotificationMode::Immediate)
+    {
+        FlushDeferredNotifications();
+    }
+}
+
+void USyStateManagerSubsystem::SetDeferredFlushTickGroup(ETickingGroup NewTickGroup)
+{
+    FlushTickFunction.TickGroup = NewTickGroup;
+    FlushTickFunction.EndTickGroup = NewTickGroup;
+}
+
+void USyStateManagerSubsystem::FlushDeferredNotifications()
+{
+    if (IsInBatch())
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("FlushDeferredNotifications called inside a batch; changes will be flushed on CommitBatch."));
+        return;
+    }
+
+    if (FlushTickFunction.IsTickFunctionRegistered())
+    {
+        FlushTickFunction.SetTickFunctionEnable(false);
+    }
+    FlushPendingChanges();
+}
+
+bool USyStateManagerSubsystem::ScheduleDeferredFlush()
+{
+    if (!HasPendingChanges())
+    {
+        return true;
+    }
+
+    if (!FlushTickFunction.IsTickFunctionRegistered())
+    {
+        return false;
+    }
+
+    if (!FlushTickFunction.IsTickFunctionEnabled())
+    {
+        FlushTickFunction.SetTickFunctionEnable(true);
+    }
+    return true;
+}
+
+void USyStateManagerSubsystem::HandlePostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS)
+{
+    if (World && World->IsGameWorld() && World->GetGameInstance() == GetGameInstance())
+    {
+        RegisterFlushTickFunction(World);
+    }
+}
+
+void USyStateManagerSubsystem::HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+    if (World && FlushTickWorld.Get() == World)
+    {
+        // 世界销毁前派发剩余通知，避免变化丢失
+        UnregisterFlushTickFunction();
+        if (!IsInBatch())
+        {
+            FlushPendingChanges();
+        }
+    }
+}
+
+void USyStateManagerSubsystem::RegisterFlushTickFunction(UWorld* World)
+{
+    if (!World || !World->IsGameWorld() || !World->PersistentLevel || FlushTickWorld.Get() == World)
+    {
+        return;
+    }
+
+    UnregisterFlushTickFunction();
+    FlushTickFunction.RegisterTickFunction(World->PersistentLevel);
+    FlushTickWorld = World;
+    LastExpiryWorldTimeSeconds = World->GetTimeSeconds();
+
+    // 注册前已排队的延迟通知，或因切换世界中断的增量压缩与到期检查
+    if ((NotificationMode == ESyStateNotificationMode::Deferred && !IsInBatch() && HasPendingChanges()) || IsCompacting() || ExpiryDeadlines.Num() > 0)
+    {
+        FlushTickFunction.SetTickFunctionEnable(true);
+    }
+
+    UE_LOG(LogSyStateManager, Verbose, TEXT("Registered deferred notification tick on world: %s"), *World->GetName());
+}
+
+void USyStateManagerSubsystem::UnregisterFlushTickFunction()
+{
+    // 结算旧世界中经过的游戏时间，新世界从其当前时间继续累计
+    AdvanceExpiryGameClock();
+    if (FlushTickFunction.IsTickFunctionRegistered())
+    {
+        FlushTickFunction.UnRegisterTickFunction();
+    }
+    FlushTickWorld.Reset();
+}
+
+void FSyStateManagerFlushTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+    // 先关闭自身：派发过程中新产生的变化会重新启用，留到下一帧
+    SetTickFunctionEnable(false);
+
+    if (Owner)
+    {
+        Owner->ExecuteFlushTick();
+    }
+}
+
+FString FSyStateManagerFlushTickFunction::DiagnosticMessage()
+{
+    return TEXT("FSyStateManagerFlushTickFunction");
+}
+
+FName FSyStateManagerFlushTickFunction::DiagnosticContext(bool bDetailed)
+{
+    return FName(TEXT("SyStateManagerFlush"));
+}
+
+void USyStateManagerSubsystem::ExecuteFlushTick()
+{
+    if (IsInBatch())
+    {
+        // 批处理提交时会重新安排派发；压缩与到期检查留到下一帧继续
+        if (IsCompacting() || ExpiryDeadlines.Num() > 0)
+        {
+            FlushTickFunction.SetTickFunctionEnable(true);
+        }
+        return;
+    }
+
+    // 先卸载到期操作，其通知与其余待处理变化在本帧一起派发
+    ExpireDueOperations();
+    FlushPendingChanges();
+
+    const bool bContinueCompaction = IsCompacting() && StepIncrementalCompaction();
+    if (bContinueCompaction || ExpiryDeadlines.Num() > 0)
+    {
+        FlushTickFunction.SetTickFunctionEnable(true);
+    }
+}
+
+// ===== 操作有效期实现 =====
+
+int32 USyStateManagerSubsystem::ExpireDueOperations()
+{
+    if (ExpiryDeadlines.Num() == 0)
+    {
+        // 堆中只剩已卸载操作的残留条目
+        GameTimeExpiryHeap.Reset();
+        RealTimeExpiryHeap.Reset();
+        return 0;
+    }
+
+    AdvanceExpiryGameClock();
+
+    TArray<FGuid> DueOperationIds;
+    PopDueExpiries(GameTimeExpiryHeap, ExpiryGameClockSeconds, DueOperationIds);
+    PopDueExpiries(RealTimeExpiryHeap, ToRealTimeSeconds(FDateTime::UtcNow()), DueOperationIds);
+    if (DueOperationIds.Num() == 0)
+    {
+        return 0;
+    }
+
+    // 同一个批处理：每个受影响目标只重算一次快照、只收到一次合并通知
+    const int32 NumExpired = UnloadOperations(DueOperationIds);
+
+    UE_LOG(LogSyStateManager, Log, TEXT("⏰ Expired %d operation(s); %d still scheduled."), NumExpired, ExpiryDeadlines.Num());
+    return NumExpired;
+}
+
+void USyStateManagerSubsystem::ScheduleExpiry(const FSyStateModificationRecord& Record)
+{
+    const FSyOperation& Operation = Record.Operation;
+    if (!Operation.Expiry.IsSet() || !Operation.OperationId.IsValid())
+    {
+        return;
+    }
+
+    FExpiryEntry Entry;
+    Entry.OperationId = Operation.OperationId;
+    if (Operation.Expiry.Clock == ESyOperationExpiryClock::RealTime)
+    {
+        // 从记录时间戳起算：读档后仍按原定时刻到期
+        Entry.Deadline = ToRealTimeSeconds(Record.Timestamp) + Operation.Expiry.DurationSeconds;
+        RealTimeExpiryHeap.HeapPush(Entry);
+    }
+    else
+    {
+        // 从记录时的游戏时钟起算：读档后继续计算剩余时间；旧存档中没有记录时钟的从现在起算
+        AdvanceExpiryGameClock();
+        const double StartSeconds = Record.ExpiryGameClockSeconds >= 0.0 ? Record.ExpiryGameClockSeconds : ExpiryGameClockSeconds;
+        Entry.Deadline = StartSeconds + Operation.Expiry.DurationSeconds;
+        GameTimeExpiryHeap.HeapPush(Entry);
+    }
+    ExpiryDeadlines.Add(Entry.OperationId, Entry.Deadline);
+
+    if (FlushTickFunction.IsTickFunctionRegistered() && !FlushTickFunction.IsTickFunctionEnabled())
+    {
+        FlushTickFunction.SetTickFunctionEnable(true);
+    }
+}
+
+void USyStateManagerSubsystem::ResetExpiries()
+{
+    GameTimeExpiryHeap.Reset();
+    RealTimeExpiryHeap.Reset();
+    ExpiryDeadlines.Reset();
+}
+
+void USyStateManagerSubsystem::RestoreExpiryGameClock(double SavedClockSeconds)
+{
+    // 日志回放的记录可能晚于快照保存时的时钟：取已知的最新时刻
+    ExpiryGameClockSeconds = SavedClockSeconds;
+    for (const FSyStateModificationRecord& Record : ModificationLog)
+    {
+        ExpiryGameClockSeconds = FMath::Max(ExpiryGameClockSeconds, Record.ExpiryGameClockSeconds);
+    }
+
+    // 读档前经过的世界时间不计入恢复的时钟
+    if (const UWorld* World = FlushTickWorld.Get())
+    {
+        LastExpiryWorldTimeSeconds = World->GetTimeSeconds();
+    }
+}
+
+void USyStateManagerSubsystem::AdvanceExpiryGameClock()
+{
+    if (const UWorld* World = FlushTickWorld.Get())
+    {
+        const double WorldTimeSeconds = World->GetTimeSeconds();
+        ExpiryGameClockSeconds += FMath::Max(0.0, WorldTimeSeconds - LastExpiryWorldTimeSeconds);
+        LastExpiryWorldTimeSeconds = WorldTimeSeconds;
+    }
+}
+
+void USyStateManagerSubsystem::PopDueExpiries(TArray<FExpiryEntry>& Heap, double Now, TArray<FGuid>& OutOperationIds)
+{
+    while (Heap.Num() > 0 && Heap.HeapTop().Deadline <= Now)
+    {
+        FExpiryEntry Entry;
+        Heap.HeapPop(Entry, EAllowShrinking::No);
+
+        // 已被提前卸载（或重新登记）的操作，其旧条目不再有效
+        const double* ScheduledDeadline = ExpiryDeadlines.Find(Entry.OperationId);
+        if (ScheduledDeadline && *ScheduledDeadline == Entry.Deadline)
+        {
+            ExpiryDeadlines.Remove(Entry.OperationId);
+            OutOperationIds.Add(Entry.OperationId);
+        }
+    }
+}
+
+double USyStateManagerSubsystem::ToRealTimeSeconds(const FDateTime& Time)
+{
+    return static_cast<double>(Time.GetTicks()) / ETimespan::TicksPerSecond;
+}
+
+// ===== 日志压缩实现 =====
+
+namespace
+{
+    /** 估算参数数组占用的内存（数组分配 + 结构体实例） */
+    int64 EstimateParamsBytes(const TArray<FInstancedStruct>& Params)
+    {
+        int64 Bytes = Params.GetAllocatedSize();
+        for (const FInstancedStruct& Param : Params)
+        {
+            if (const UScriptStruct* StructType = Param.GetScriptStruct())
+            {
+                Bytes += StructType->GetStructureSize();
+            }
+        }
+        return Bytes;
+    }
+
+    int64 EstimateModificationBytes(const FSyStateParameterSet& Modifications)
+    {
+        int64 Bytes = Modifications.Parameters.GetAllocatedSize();
+        for (const FSyStateParams& ModParams : Modifications.Parameters)
+        {
+            Bytes += EstimateParamsBytes(ModParams.Params);
+        }
+        return Bytes;
+    }
+
+    int64 EstimateCheckpointBytes(const TArray<FSyStateCheckpointEntry>& Checkpoint)
+    {
+        int64 Bytes = Checkpoint.GetAllocatedSize();
+        for (const FSyStateCheckpointEntry& Entry : Checkpoint)
+        {
+            if (const UScriptStruct* StructType = Entry.Value.GetScriptStruct())
+            {
+                Bytes += StructType->GetStructureSize();
+            }
+        }
+        return Bytes;
+    }
+}
+
+FSyStateCompactionStats USyStateManagerSubsystem::CompactLog()
+{
+    // 同步压缩接管进行中的增量压缩
+    PendingCompactionTargets.Reset();
+    MaterializeAllTargets();
+    ActiveCompactionStats = FSyStateCompactionStats();
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    FSyStateCompactionStats Stats;
+    TArray<FSyStateTargetKey> Targets;
+    TargetIndex.GetKeys(Targets);
+    for (const FSyStateTargetKey& TargetKey : Targets)
+    {
+        CompactTarget(TargetKey, Stats);
+    }
+
+    Stats.DurationMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+    FinishCompaction(Stats);
+    return Stats;
+}
+
+void USyStateManagerSubsystem::StartIncrementalCompaction(int32 RecordsPerFrame)
+{
+    CompactionRecordsPerFrame = FMath::Max(1, RecordsPerFrame);
+
+    if (IsCompacting())
+    {
+        UE_LOG(LogSyStateManager, Verbose, TEXT("Incremental compaction already running; budget set to %d records per frame."), CompactionRecordsPerFrame);
+        return;
+    }
+
+    MaterializeAllTargets();
+
+    // 没有可用的 Tick（或无事可做）时同步完成，保证 OnLogCompacted 总会广播
+    if (!FlushTickFunction.IsTickFunctionRegistered() || TargetIndex.Num() == 0)
+    {
+        CompactLog();
+        return;
+    }
+
+    ActiveCompactionStats = FSyStateCompactionStats();
+    TargetIndex.GetKeys(PendingCompactionTargets);
+    FlushTickFunction.SetTickFunctionEnable(true);
+
+    UE_LOG(LogSyStateManager, Log, TEXT("🗜️ Started incremental log compaction: %d target(s), %d records per frame."), 
+        PendingCompactionTargets.Num(), CompactionRecordsPerFrame);
+}
+
+bool USyStateManagerSubsystem::StepIncrementalCompaction()
+{
+    const double StartTime = FPlatformTime::Seconds();
+    const int32 ScannedBefore = ActiveCompactionStats.RecordsScanned;
+
+    // 以目标为单位处理：同一目标的覆盖关系必须在一次扫描中确定
+    while (PendingCompactionTargets.Num() > 0 && ActiveCompactionStats.RecordsScanned - ScannedBefore < CompactionRecordsPerFrame)
+    {
+        CompactTarget(PendingCompactionTargets.Pop(), ActiveCompactionStats);
+    }
+
+    ActiveCompactionStats.DurationMs += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+    if (PendingCompactionTargets.Num() > 0)
+    {
+        return true;
+    }
+
+    const FSyStateCompactionStats Stats = ActiveCompactionStats;
+    ActiveCompactionStats = FSyStateCompactionStats();
+    FinishCompaction(Stats);
+    return false;
+}
+
+void USyStateManagerSubsystem::FinishCompaction(const FSyStateCompactionStats& Stats)
+{
+    LastCompactionStats = Stats;
+
+    UE_LOG(LogSyStateManager, Log, TEXT("🗜️ Log compaction finished: %d target(s), %d record(s) scanned, %d compacted (%d folded to stubs), %d value(s) folded, ~%lld bytes reclaimed in %.2f ms."), 
+        Stats.TargetsProcessed, Stats.RecordsScanned, Stats.RecordsCompacted, Stats.RecordsFolded, 
+        Stats.ValuesFolded, Stats.BytesReclaimed, Stats.DurationMs);
+
+    OnLogCompacted.Broadcast(Stats);
+}
+
+void USyStateManagerSubsystem::CompactTarget(const FSyStateTargetKey& TargetKey, FSyStateCompactionStats& Stats)
+{
+    const TArray<int32>* IndicesPtr = TargetIndex.Find(TargetKey);
+    if (!IndicesPtr)
+    {
+        return;
+    }
+
+    ++Stats.TargetsProcessed;
+    Stats.RecordsScanned += IndicesPtr->Num();
+    if (IndicesPtr->Num() < 2)
+    {
+        return;
+    }
+
+    using FParamSlot = TPair<FGameplayTag, const UScriptStruct*>;
+    const UScriptStruct* ListBaseType = FSyListParameterBase::StaticStruct();
+
+    TArray<FSyStateCheckpointEntry>& Checkpoint = Checkpoints.FindOrAdd(TargetKey);
+    const int64 CheckpointBytesBefore = EstimateCheckpointBytes(Checkpoint);
+
+    // 已被较新记录覆盖的 (状态标签, 参数类型)
+    TSet<FParamSlot> CoveredSlots;
+    // 本次折叠的值（从新到旧）：每个贡献者的值都保留，较新的贡献者卸载后仍能回退到较早的值
+    TArray<FSyStateCheckpointEntry> FoldedEntries;
+    TArray<FParamSlot, TInlineAllocator<8>> RecordSlots;
+    TArray<FGameplayTag, TInlineAllocator<8>> TagsBefore;
+
+    for (int32 Position = IndicesPtr->Num() - 1; Position >= 0; --Position)
+    {
+        const int32 LogIndex = (*IndicesPtr)[Position];
+        FSyStateModificationRecord& Record = ModificationLog[LogIndex];
+        if (Record.GetStateModifications().Parameters.Num() == 0)
+        {
+            continue;
+        }
+
+        // 载荷可能与其他记录共享：在副本上折叠，有变化时再写回并重新驻留
+        FSyStateParameterSet CompactedModifications = Record.GetStateModifications();
+        TArray<FSyStateParams>& Modifications = CompactedModifications.Parameters;
+        const int64 BytesBefore = EstimateModificationBytes(CompactedModifications);
+        RecordSlots.Reset();
+        TagsBefore.Reset();
+        int32 FoldedInRecord = 0;
+
+        for (int32 ModIndex = Modifications.Num() - 1; ModIndex >= 0; --ModIndex)
+        {
+            FSyStateParams& ModParams = Modifications[ModIndex];
+            if (!ModParams.Tag.IsValid())
+            {
+                continue;
+            }
+            TagsBefore.AddUnique(ModParams.Tag);
+
+            bool bStripped = false;
+            for (int32 ParamIndex = ModParams.Params.Num() - 1; ParamIndex >= 0; --ParamIndex)
+            {
+                FInstancedStruct& Param = ModParams.Params[ParamIndex];
+                const UScriptStruct* StructType = Param.GetScriptStruct();
+                if (!StructType || StructType->IsChildOf(ListBaseType) || StructType == FSyNumericModifier::StaticStruct())
+                {
+                    // 列表类型与数值修饰累积聚合，永远不会被覆盖
+                    continue;
+                }
+
+                const FParamSlot Slot(ModParams.Tag, StructType);
+                if (!CoveredSlots.Contains(Slot))
+                {
+                    RecordSlots.AddUnique(Slot);
+                    continue;
+                }
+
+                // 被覆盖：移入检查点（任何记录都可能被卸载，被覆盖的值之后仍可能重新生效，不能丢弃）
+                FoldedEntries.Emplace(ModParams.Tag, MoveTemp(Param), Record.Operation.OperationId);
+                ModParams.Params.RemoveAt(ParamIndex);
+                bStripped = true;
+                ++FoldedInRecord;
+            }
+
+            if (bStripped)
+            {
+                if (ModParams.Params.Num() == 0)
+                {
+                    Modifications.RemoveAt(ModIndex);
+                }
+                else
+                {
+                    ModParams.Params.Shrink();
+                }
+            }
+        }
+
+        // 同一记录内的重复槽位不算覆盖，处理完整条记录后再登记
+        CoveredSlots.Append(RecordSlots);
+
+        if (FoldedInRecord == 0)
+        {
+            continue;
+        }
+
+        Modifications.Shrink();
+
+        // 不再修改的状态标签从倒排索引中移除
+        for (const FGameplayTag& Tag : TagsBefore)
+        {
+            const bool bStillTouched = Modifications.ContainsByPredicate([&Tag](const FSyStateParams& ModParams) { return ModParams.Tag == Tag; });
+            if (!bStillTouched)
+            {
+                if (TArray<int32>* TagIndices = StateTagIndex.Find(Tag))
+                {
+                    TagIndices->RemoveSingle(LogIndex);
+                    if (TagIndices->Num() == 0)
+                    {
+                        StateTagIndex.Remove(Tag);
+                    }
+                }
+            }
+        }
+
+        ++Stats.RecordsCompacted;
+        Stats.ValuesFolded += FoldedInRecord;
+        if (Modifications.Num() == 0)
+        {
+            ++Stats.RecordsFolded;
+        }
+        Stats.BytesReclaimed += BytesBefore - EstimateModificationBytes(CompactedModifications);
+
+        Record.Payload.Reset();
+        Record.Operation.Modifier.StateModifications = MoveTemp(CompactedModifications);
+        PayloadPool.InternRecord(Record);
+    }
+
+    // 按时间顺序追加：检查点中已有的值都早于本次折叠的记录
+    Checkpoint.Reserve(Checkpoint.Num() + FoldedEntries.Num());
+    for (int32 FoldedIndex = FoldedEntries.Num() - 1; FoldedIndex >= 0; --FoldedIndex)
+    {
+        Checkpoint.Add(MoveTemp(FoldedEntries[FoldedIndex]));
+    }
+
+    Stats.BytesReclaimed -= EstimateCheckpointBytes(Checkpoint) - CheckpointBytesBefore;
+    if (Checkpoint.Num() == 0)
+    {
+        Checkpoints.Remove(TargetKey);
+    }
+}
+
+void USyStateManagerSubsystem::AggregateCheckpoint(
+    const FSyStateTargetKey& TargetKey,
+    TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const
+{
+    if (const TArray<FSyStateCheckpointEntry>* Checkpoint = Checkpoints.Find(TargetKey))
+    {
+        // 检查点按时间顺序存放，且早于该目标所有仍修改它的记录：同一 (状态标签, 参数类型) 较新的值覆盖较早的
+        for (const FSyStateCheckpointEntry& Entry : *Checkpoint)
+        {
+            TArray<FInstancedStruct>& Params = OutAggregatedMap.FindOrAdd(Entry.StateTag);
+            const UScriptStruct* StructType = Entry.Value.GetScriptStruct();
+            if (FInstancedStruct* Existing = Params.FindByPredicate([StructType](const FInstancedStruct& Param) { return Param.GetScriptStruct() == StructType; }))
+            {
+                *Existing = Entry.Value;
+            }
+            else
+            {
+                Params.Add(Entry.Value);
+            }
+        }
+    }
+}
+
+FSyStateParameterSet USyStateManagerSubsystem::GetAggregatedModifications(const FGameplayTag& TargetFilterTag /* TODO: 添加 SourceFilterTag */) const
+{
+    // ===== 从共享快照转换（兼容接口，会拷贝参数；C++ 请优先使用 GetSnapshot） =====
+    if (TargetFilterTag.IsValid())
+    {
+        const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromType(TargetFilterTag);
+        MaterializeTargetForConstRead(TargetKey);
+        if (const FSyStateSnapshotPtr Snapshot = FindSnapshot(TargetKey))
+        {
+            UE_LOG(LogSyStateManager, VeryVerbose, TEXT("⚡ Returning pre-aggregated snapshot for target tag: %s"), 
+                *TargetFilterTag.ToString());
+            return Snapshot->ToParameterSet();
+        }
+        
+        // 快照不存在，说明还没有该目标类型的操作记录
+        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("No snapshot found for target tag: %s, returning empty set"), 
+            *TargetFilterTag.ToString());
+        return FSyStateParameterSet();
+    }
+
+    // 没有目标过滤时，手动聚合所有记录（保持向后兼容）
+    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("No target filter provided, manually aggregating all records..."));
+    
+    MaterializeAllTargetsForConstRead();
+
+    FSyStateParameterSet AggregatedResult;
+    TMap<FGameplayTag, TArray<FInstancedStruct>> AggregatedParamsMap;
+    
+    // 压缩产生的检查点早于剩余记录
+    for (const TPair<FSyStateTargetKey, TArray<FSyStateCheckpointEntry>>& Pair : Checkpoints)
+    {
+        AggregateCheckpoint(Pair.Key, AggregatedParamsMap);
+    }
+
+    for (const FSyStateModificationRecord& Record : ModificationLog)
+    {
+        AggregateRecordModifications(Record, AggregatedParamsMap);
+    }
+    
+    AggregatedResult = AggregatedParamsMap;
+    return AggregatedResult;
+}
+
+FSyStateSnapshotPtr USyStateManagerSubsystem::GetSnapshot(const FSyStateTargetKey& TargetKey)
+{
+    MaterializeTarget(TargetKey);
+    return FindSnapshot(TargetKey);
+}
+
+FSyStateSnapshotPtr USyStateManagerSubsystem::GetEffectiveTypeSnapshot(const FGameplayTag& TargetTypeTag)
+{
+    if (!TargetTypeTag.IsValid())
+    {
+        return FSyStateSnapshotPtr();
+    }
+
+    // 有效快照依赖整条祖先链：先解码整条链，之后的合并只读取已发布的快照
+    // 缓存中的类型其祖先链总是已解码；拷贝祖先链，解码不会在遍历中改动正在读取的容器
+    if (LazyTargets.Num() > 0 && !EffectiveTypeSnapshotCache.Contains(TargetTypeTag))
+    {
+        const TArray<FGameplayTag> Ancestry = GetTypeAncestry(TargetTypeTag);
+        for (const FGameplayTag& AncestorTag : Ancestry)
+        {
+            MaterializeTarget(FSyStateTargetKey::FromType(AncestorTag));
+        }
+    }
+
+    if (const FSyStateSnapshotPtr* Cached = EffectiveTypeSnapshotCache.Find(TargetTypeTag))
+    {
+        return *Cached;
+    }
+
+    // 首次读取：计算并缓存，之后只在祖先变化时重建
+    FSyStateSnapshotPtr Effective = BuildEffectiveTypeSnapshot(TargetTypeTag, FSyStateSnapshotPtr());
+    EffectiveTypeSnapshotCache.Add(TargetTypeTag, Effective);
+    return Effective;
+}
+
+// ===== 版本化读取 =====
+
+void USyStateManagerSubsystem::PublishSnapshot(const FSyStateTargetKey& TargetKey, FSyStateSnapshotPtr Snapshot)
+{
+    if (MaxSnapshotHistory > 0)
+    {
+        FSnapshotHistory& History = SnapshotHistory.FindOrAdd(TargetKey);
+        History.Snapshots.Add(Snapshot);
+        if (History.Snapshots.Num() > MaxSnapshotHistory)
+        {
+            const int32 NumEvicted = History.Snapshots.Num() - MaxSnapshotHistory;
+            History.Snapshots.RemoveAt(0, NumEvicted, EAllowShrinking::No);
+            History.EvictedBeforeVersion = History.Snapshots[0]->Version;
+        }
+    }
+
+    SnapshotCache.Add(TargetKey, MoveTemp(Snapshot));
+}
+
+FSyStateSnapshotPtr USyStateManagerSubsystem::GetSnapshotIfChanged(const FSyStateTargetKey& TargetKey, int32 SinceVersion)
+{
+    FSyStateSnapshotPtr Snapshot = GetSnapshot(TargetKey);
+    return Snapshot.IsValid() && Snapshot->Version > SinceVersion ? Snapshot : FSyStateSnapshotPtr();
+}
+
+bool USyStateManagerSubsystem::GetSnapshotAtVersion(const FSyStateTargetKey& TargetKey, int32 Version, FSyStateSnapshotPtr& OutSnapshot)
+{
+    OutSnapshot.Reset();
+
+    const FSyStateSnapshotPtr Current = GetSnapshot(TargetKey);
+    if (Current.IsValid() && Current->Version <= Version)
+    {
+        OutSnapshot = Current;
+        return true;
+    }
+
+    const FSnapshotHistory* History = SnapshotHistory.Find(TargetKey);
+    if (!History)
+    {
+        // 没有历史（未保留或已清除）：只有从未有过快照的目标可以确定当时没有状态
+        return !Current.IsValid();
+    }
+    if (Version < History->EvictedBeforeVersion)
+    {
+        return false;
+    }
+
+    // 最后一个不晚于该版本的快照（历史按版本递增）；没有时说明当时该目标还没有状态
+    for (int32 Index = History->Snapshots.Num() - 1; Index >= 0; --Index)
+    {
+        if (History->Snapshots[Index]->Version <= Version)
+        {
+            OutSnapshot = History->Snapshots[Index];
+            break;
+        }
+    }
+    return true;
+}
+
+bool USyStateManagerSubsystem::K2_GetAggregatedModificationsIfChanged(FGameplayTag TargetTypeTag, int32 SinceVersion, FSyStateParameterSet& OutModifications, int32& OutVersion)
+{
+    OutVersion = SinceVersion;
+    const FSyStateSnapshotPtr Snapshot = GetSnapshotIfChanged(FSyStateTargetKey::FromType(TargetTypeTag), SinceVersion);
+    if (!Snapshot.IsValid())
+    {
+        return false;
+    }
+
+    OutModifications = Snapshot->ToParameterSet();
+    OutVersion = Snapshot->Version;
+    return true;
+}
+
+bool USyStateManagerSubsystem::K2_GetAggregatedModificationsAtVersion(FGameplayTag TargetTypeTag, int32 Version, FSyStateParameterSet& OutModifications)
+{
+    FSyStateSnapshotPtr Snapshot;
+    if (!GetSnapshotAtVersion(FSyStateTargetKey::FromType(TargetTypeTag), Version, Snapshot))
+    {
+        UE_LOG(LogSyStateManager, Verbose, TEXT("Snapshot history for %s no longer covers version %d."), *TargetTypeTag.ToString(), Version);
+        return false;
+    }
+
+    OutModifications = Snapshot.IsValid() ? Snapshot->ToParameterSet() : FSyStateParameterSet();
+    return true;
+}
+
+void USyStateManagerSubsystem::SetSnapshotHistoryLength(int32 NewLength)
+{
+    MaxSnapshotHistory = FMath::Max(0, NewLength);
+    if (MaxSnapshotHistory == 0)
+    {
+        SnapshotHistory.Empty();
+        return;
+    }
+
+    for (TPair<FSyStateTargetKey, FSnapshotHistory>& Pair : SnapshotHistory)
+    {
+        FSnapshotHistory& History = Pair.Value;
+        if (History.Snapshots.Num() > MaxSnapshotHistory)
+        {
+            History.Snapshots.RemoveAt(0, History.Snapshots.Num() - MaxSnapshotHistory);
+            History.EvictedBeforeVersion = History.Snapshots[0]->Version;
+        }
+    }
+}
+
+const TArray<FGameplayTag>& USyStateManagerSubsystem::GetTypeAncestry(const FGameplayTag& TypeTag) const
+{
+    if (const TArray<FGameplayTag>* Cached = TypeAncestryCache.Find(TypeTag))
+    {
+        return *Cached;
+    }
+
+    TArray<FGameplayTag> Ancestry;
+    for (FGameplayTag Current = TypeTag; Current.IsValid(); Current = Current.RequestDirectParent())
+    {
+        Ancestry.Add(Current);
+    }
+    Algo::Reverse(Ancestry);
+    return TypeAncestryCache.Add(TypeTag, MoveTemp(Ancestry));
+}
+
+FSyStateSnapshotPtr USyStateManagerSubsystem::BuildEffectiveTypeSnapshot(const FGameplayTag& TypeTag, const FSyStateSnapshotPtr& Previous) const
+{
+    // 收集祖先链上存在的快照（根在前）
+    TArray<FSyStateSnapshotPtr, TInlineAllocator<8>> Layers;
+    for (const FGameplayTag& AncestorTag : GetTypeAncestry(TypeTag))
+    {
+        const FSyStateSnapshotPtr Snapshot = FindSnapshot(FSyStateTargetKey::FromType(AncestorTag));
+        if (Snapshot.IsValid() && Snapshot->Entries.Num() > 0)
+        {
+            Layers.Add(Snapshot);
+        }
+    }
+
+    if (Layers.Num() == 0)
+    {
+        return FSyStateSnapshotPtr();
+    }
+
+    // 只有一层时直接共享该快照
+    if (Layers.Num() == 1)
+    {
+        return Layers[0];
+    }
+
+    TSharedRef<FSyStateSnapshot> Merged = MakeShared<FSyStateSnapshot>();
+    for (const FSyStateSnapshotPtr& Layer : Layers)
+    {
+        Merged->Version = FMath::Max(Merged->Version, Layer->Version);
+    }
+
+    // 按 根 -> 自身 合并：只有一层提供的标签直接共享条目，多层提供时按聚合规则合并
+    TMap<FGameplayTag, TArray<FInstancedStruct>> MergedParams;
+    for (const FSyStateSnapshotPtr& Layer : Layers)
+    {
+        for (const TPair<FGameplayTag, FSyStateSnapshotEntryRef>& Pair : Layer->Entries)
+        {
+            if (TArray<FInstancedStruct>* Params = MergedParams.Find(Pair.Key))
+            {
+                MergeStateParams(*Params, Pair.Value->Params);
+            }
+            else if (const FSyStateSnapshotEntryRef* Existing = Merged->Entries.Find(Pair.Key))
+            {
+                TArray<FInstancedStruct>& NewParams = MergedParams.Add(Pair.Key, (*Existing)->Params);
+                MergeStateParams(NewParams, Pair.Value->Params);
+            }
+            else
+            {
+                Merged->Entries.Add(Pair.Key, Pair.Value);
+            }
+        }
+    }
+
+    for (TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : MergedParams)
+    {
+        const FSyStateSnapshotEntryRef* OldEntry = Previous.IsValid() ? Previous->Entries.Find(Pair.Key) : nullptr;
+        if (OldEntry && (*OldEntry)->Params == Pair.Value)
+        {
+            Merged->Entries.Add(Pair.Key, *OldEntry);
+        }
+        else
+        {
+            Merged->Entries.Add(Pair.Key, MakeShared<const FSyStateSnapshotEntry>(MoveTemp(Pair.Value), Merged->Version));
+        }
+    }
+
+    // 与上一版本逐条目比较，完全一致时沿用旧快照
+    if (Previous.IsValid() && Previous->Entries.Num() == Merged->Entries.Num())
+    {
+        bool bIdentical = true;
+        for (const TPair<FGameplayTag, FSyStateSnapshotEntryRef>& Pair : Merged->Entries)
+        {
+            const FSyStateSnapshotEntryRef* OldEntry = Previous->Entries.Find(Pair.Key);
+            if (!OldEntry || &OldEntry->Get() != &Pair.Value.Get())
+            {
+                bIdentical = false;
+                break;
+            }
+        }
+        if (bIdentical)
+        {
+            return Previous;
+        }
+    }
+
+    return Merged;
+}
+
+void USyStateManagerSubsystem::RefreshEffectiveTypeSnapshots(const TSet<FGameplayTag>& ChangedTypeTags)
+{
+    int32 RebuiltCount = 0;
+    for (TPair<FGameplayTag, FSyStateSnapshotPtr>& Pair : EffectiveTypeSnapshotCache)
+    {
+        // 祖先链中包含变化的类型（含自身）才需要重建
+        const bool bAffected = GetTypeAncestry(Pair.Key).ContainsByPredicate([&ChangedTypeTags](const FGameplayTag& AncestorTag)
+        {
+            return ChangedTypeTags.Contains(AncestorTag);
+        });
+
+        if (bAffected)
+        {
+            Pair.Value = BuildEffectiveTypeSnapshot(Pair.Key, Pair.Value);
+            ++RebuiltCount;
+        }
+    }
+
+    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("Rebuilt %d hierarchical snapshot(s) for %d changed type(s)."), 
+        RebuiltCount, ChangedTypeTags.Num());
+}
+
+void USyStateManagerSubsystem::AddDescendantTypeNotifications(TMap<FSyStateTargetKey, FSyTargetStateChange>& Notifications) const
+{
+    TArray<FSyTargetStateChange> TypeChanges;
+    for (const TPair<FSyStateTargetKey, FSyTargetStateChange>& Pair : Notifications)
+    {
+        if (Pair.Key.Scope == ESyStateTargetScope::Type)
+        {
+            TypeChanges.Add(Pair.Value);
+        }
+    }
+
+    for (const FSyTargetStateChange& Change : TypeChanges)
+    {
+        for (const TPair<FSyStateTargetKey, TArray<FSubscriberInfo>>& SubscriberPair : TargetSubscribers)
+        {
+            const FSyStateTargetKey& SubscriberKey = SubscriberPair.Key;
+            if (SubscriberKey.Scope != ESyStateTargetScope::Type
+                || SubscriberKey.TypeTag == Change.Target.TypeTag
+                || !SubscriberKey.TypeTag.MatchesTag(Change.Target.TypeTag))
+            {
+                continue;
+            }
+
+            // 子类型订阅者收到父类型变化（多个父类型同时变化时合并）
+            FSyTargetStateChange& DescendantChange = Notifications.FindOrAdd(SubscriberKey);
+            DescendantChange.Target = SubscriberKey;
+            DescendantChange.ChangedStateTags.AppendTags(Change.ChangedStateTags);
+            DescendantChange.LastRecord = Change.LastRecord;
+            DescendantChange.NumRecords += Change.NumRecords;
+        }
+    }
+}
+
+FSyStateSnapshot& USyStateManagerSubsystem::GetWorkingSnapshot(const FSyStateTargetKey& TargetKey)
+{
+    TSharedPtr<FSyStateSnapshot>& Working = WorkingSnapshots.FindOrAdd(TargetKey);
+    if (!Working.IsValid())
+    {
+        Working = MakeShared<FSyStateSnapshot>();
+        Working->Version = ++GlobalVersion;
+
+        // 浅拷贝条目表：条目本身只读共享，仅被修改的标签会替换为新条目
+        if (const FSyStateSnapshotPtr* Published = SnapshotCache.Find(TargetKey); Published && Published->IsValid())
+        {
+            Working->Entries = (*Published)->Entries;
+        }
+    }
+    return *Working;
+}
+
+// 辅助方法：聚合单个记录的修改
+void USyStateManagerSubsystem::AggregateRecordModifications(
+    const FSyStateModificationRecord& Record,
+    TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const
+{
+    for (const FSyStateParams& ModParams : Record.GetStateModifications().Parameters)
+    {
+        if (!ModParams.Tag.IsValid()) continue;
+        MergeStateParams(OutAggregatedMap.FindOrAdd(ModParams.Tag), ModParams.Params);
+    }
+}
+
+void USyStateManagerSubsystem::MergeStateParams(TArray<FInstancedStruct>& ExistingParams, const TArray<FInstancedStruct>& ParamsToMerge)
+{
+    const UScriptStruct* ListBaseType = FSyListParameterBase::StaticStruct();
+
+    for (const FInstancedStruct& SourceStruct : ParamsToMerge)
+    {
+        if (!SourceStruct.IsValid()) continue;
+
+        const UScriptStruct* StructType = SourceStruct.GetScriptStruct();
+        if (!StructType) continue;
+
+        // 数值修饰累积到修饰栈，并重新写出对应的数值
+        if (FSyNumericModifierStack::MergeParam(ExistingParams, SourceStruct, ParamsToMerge))
+        {
+            continue;
+        }
+
+        FInstancedStruct* TargetStructPtr = ExistingParams.FindByPredicate(
+            [&StructType](const FInstancedStruct& ExistingStruct)
+            {
+                return ExistingStruct.IsValid() && ExistingStruct.GetScriptStruct() == StructType;
+            });
+
+        if (TargetStructPtr)
+        {
+            if (StructType->IsChildOf(ListBaseType))
+            {
+                // 列表类型 - 聚合
+                FSyListParameterBase* TargetListBase = TargetStructPtr->GetMutablePtr<FSyListParameterBase>();
+                const FSyListParameterBase* SourceListBase = SourceStruct.GetPtr<FSyListParameterBase>();
+
+                if (TargetListBase && SourceListBase)
+                {
+                    TargetListBase->AggregateItemsInternal(SourceListBase->GetListItemsInternal());
+                }
+                else
+                {
+                    UE_LOG(LogSyStateManager, Warning, TEXT("Failed to get FSyListParameterBase pointers for aggregation for type: %s. Falling back to overwrite."), *StructType->GetName());
+                    *TargetStructPtr = SourceStruct;
+                }
+            }
+            else
+            {
+                // 非列表类型 - 覆盖
+                *TargetStructPtr = SourceStruct;
+            }
+        }
+        else
+        {
+            // 不存在，添加新参数
+            ExistingParams.Add(SourceStruct);
+        }
+    }
+}
+
+void USyStateManagerSubsystem::RecalculateSnapshotForTarget(const FSyStateTargetKey& TargetKey)
+{
+    if (!TargetKey.IsValid())
+    {
+        return;
+    }
+
+    TMap<FGameplayTag, TArray<FInstancedStruct>> AggregatedMap;
+    AggregateTargetParams(TargetKey, AggregatedMap);
+    PublishRecalculatedSnapshot(TargetKey, MoveTemp(AggregatedMap));
+}
+
+void USyStateManagerSubsystem::AggregateTargetParams(const FSyStateTargetKey& TargetKey, TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const
+{
+    // 从检查点开始，重新聚合该目标的所有记录（使用索引，保持时间顺序）
+    AggregateCheckpoint(TargetKey, OutAggregatedMap);
+    if (const TArray<int32>* IndicesPtr = TargetIndex.Find(TargetKey))
+    {
+        const FSyStatePayload* LastPayload = nullptr;
+        for (int32 Index : *IndicesPtr)
+        {
+            if (!ModificationLog.IsValidIndex(Index))
+            {
+                continue;
+            }
+
+            // 紧邻的记录共享同一个只覆盖的载荷时，再次合并结果不变
+            const FSyStateModificationRecord& Record = ModificationLog[Index];
+            const FSyStatePayload* Payload = Record.Payload.Get();
+            if (Payload && Payload == LastPayload && Payload->bIdempotent)
+            {
+                continue;
+            }
+            LastPayload = Payload;
+            AggregateRecordModifications(Record, OutAggregatedMap);
+        }
+    }
+}
+
+void USyStateManagerSubsystem::PublishRecalculatedSnapshot(const FSyStateTargetKey& TargetKey, TMap<FGameplayTag, TArray<FInstancedStruct>>&& AggregatedMap)
+{
+    const TArray<int32>* IndicesPtr = TargetIndex.Find(TargetKey);
+    const FSyStateSnapshotPtr* PreviousPtr = SnapshotCache.Find(TargetKey);
+    const FSyStateSnapshot* Previous = PreviousPtr ? PreviousPtr->Get() : nullptr;
+
+    TSharedRef<FSyStateSnapshot> NewSnapshot = MakeShared<FSyStateSnapshot>();
+    NewSnapshot->Version = GlobalVersion + 1;
+    NewSnapshot->Entries.Reserve(AggregatedMap.Num());
+
+    // 内容未变化的标签直接复用旧条目，订阅者比较时可跳过
+    int32 ReusedCount = 0;
+    for (TPair<FGameplayTag, TArray<FInstancedStruct>>& Pair : AggregatedMap)
+    {
+        const FSyStateSnapshotEntryRef* OldEntry = Previous ? Previous->Entries.Find(Pair.Key) : nullptr;
+        if (OldEntry && (*OldEntry)->Params == Pair.Value)
+        {
+            NewSnapshot->Entries.Add(Pair.Key, *OldEntry);
+            ++ReusedCount;
+        }
+        else
+        {
+            NewSnapshot->Entries.Add(Pair.Key, MakeShared<const FSyStateSnapshotEntry>(MoveTemp(Pair.Value), NewSnapshot->Version));
+        }
+    }
+
+    // 完全没有变化时保留旧快照，版本号不变
+    if (Previous && ReusedCount == Previous->Entries.Num() && ReusedCount == NewSnapshot->Entries.Num())
+    {
+        UE_LOG(LogSyStateManager, Verbose, TEXT("Snapshot for target: %s unchanged after recalculation"), *TargetKey.ToString());
+        return;
+    }
+
+    ++GlobalVersion;
+    PublishSnapshot(TargetKey, NewSnapshot);
+
+    UE_LOG(LogSyStateManager, Verbose, TEXT("✅ Recalculated snapshot for target: %s with %d records (Version: %d, %d/%d entries reused)"), 
+        *TargetKey.ToString(), IndicesPtr ? IndicesPtr->Num() : 0, NewSnapshot->Version, ReusedCount, NewSnapshot->Entries.Num());
+}
+
+const TArray<FSyStateModificationRecord>& USyStateManagerSubsystem::GetAllModifications_Simple() const
+{
+    MaterializeAllTargetsForConstRead();
+    return ModificationLog;
+}
+
+TArray<FSyStateModificationRecord> USyStateManagerSubsystem::GetAllModificationsExpanded() const
+{
+    MaterializeAllTargetsForConstRead();
+
+    TArray<FSyStateModificationRecord> Result;
+    Result.Reserve(ModificationLog.Num());
+    for (const FSyStateModificationRecord& Record : ModificationLog)
+    {
+        Result.Add(Record.WithInlinePayload());
+    }
+    return Result;
+}
+
+bool USyStateManagerSubsystem::SaveLog()
+{
+    // Journal 模式下只追加上次写入后的增量
+    if (PersistenceMode == ESyStatePersistenceMode::Journal && Journal)
+    {
+        return FlushJournal();
+    }
+    return WriteSaveGameSnapshot();
+}
+
+USyStateManagerSaveGame* USyStateManagerSubsystem::BuildSaveGameSnapshot()
+{
+    USyStateManagerSaveGame* SaveGameObject = CreateSaveGameObject();
+    if (SaveGameObject)
+    {
+        InlineRecordsForSave(ModificationLog, SaveGameObject->SavedModificationLog);
+    }
+    return SaveGameObject;
+}
+
+USyStateManagerSaveGame* USyStateManagerSubsystem::CreateSaveGameObject()
+{
+    MaterializeAllTargets();
+
+    // 存档内容会被整体覆盖，无需先读取旧存档
+    USyStateManagerSaveGame* SaveGameObject = Cast<USyStateManagerSaveGame>(UGameplayStatics::CreateSaveGameObject(USyStateManagerSaveGame::StaticClass()));
+    if (!SaveGameObject)
+    {
+        UE_LOG(LogSyStateManager, Error, TEXT("Failed to create SaveGameObject!"));
+        return nullptr;
+    }
+
+    BuildSavedCheckpoints(SaveGameObject->SavedCheckpoints);
+    AdvanceExpiryGameClock();
+    SaveGameObject->SavedExpiryGameClockSeconds = ExpiryGameClockSeconds;
+    SaveGameObject->SaveGameVersion = TEXT("1.2"); // 1.1: 增加检查点；1.2: 增加有效期游戏时钟
+    return SaveGameObject;
+}
+
+void USyStateManagerSubsystem::InlineRecordsForSave(const TArray<FSyStateModificationRecord>& Records, TArray<FSyStateModificationRecord>& OutSavedRecords)
+{
+    // 存档按属性序列化，共享载荷需要内联（载荷只读，可在工作线程执行）
+    OutSavedRecords.Reset(Records.Num());
+    for (const FSyStateModificationRecord& Record : Records)
+    {
+        OutSavedRecords.Add(Record.WithInlinePayload());
+    }
+}
+
+bool USyStateManagerSubsystem::WriteSaveGameSnapshot()
+{
+    USyStateManagerSaveGame* SaveGameObject = BuildSaveGameSnapshot();
+    if (!SaveGameObject)
+    {
+        return false;
+    }
+
+    // 保存到磁盘
+    bool bSuccess = UGameplayStatics::SaveGameToSlot(SaveGameObject, SaveSlotName, UserIndex);
+
+    if (bSuccess)
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("State Manager Log saved successfully to slot: %s"), *SaveSlotName);
+    }
+    else
+    {
+        UE_LOG(LogSyStateManager, Error, TEXT("Failed to save State Manager Log to slot: %s"), *SaveSlotName);
+    }
+
+    return bSuccess;
+}
+
+bool USyStateManagerSubsystem::LoadLog()
+{
+    // 日志被整体替换，尚未解码的目标一并丢弃
+    ReleaseMappedLog();
+
+    USaveGame* LoadedSaveGame = nullptr;
+    if (UGameplayStatics::DoesSaveGameExist(SaveSlotName, UserIndex))
+    {
+        LoadedSaveGame = UGameplayStatics::LoadGameFromSlot(SaveSlotName, UserIndex);
+    }
+    else
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("No existing save game found for State Manager Log in slot: %s. Starting with an empty log."), *SaveSlotName);
+    }
+    return FinishLoadLog(LoadedSaveGame);
+}
+
+bool USyStateManagerSubsystem::FinishLoadLog(USaveGame* LoadedSaveGame)
+{
+    // 没有可用的存档时游戏时钟继续计时
+    AdvanceExpiryGameClock();
+    double SavedClockSeconds = ExpiryGameClockSeconds;
+    bool bLoaded = LoadedSaveGame && ApplySaveGameSnapshot(LoadedSaveGame, SavedClockSeconds);
+    if (!bLoaded)
+    {
+        // 如果加载失败或存档不存在，确保日志是空的
+        ModificationLog.Empty();
+        Checkpoints.Empty();
+    }
+
+    // Journal 模式：在快照之上回放日志文件中的增量
+    if (PersistenceMode == ESyStatePersistenceMode::Journal && Journal)
+    {
+        Journal->DiscardPending();
+
+        int32 NumApplied = 0;
+        TArray<FGuid> UnloadedOperationIds;
+        int64 JournalValidSize = 0;
+        if (Journal->Replay(ModificationLog, NumApplied, UnloadedOperationIds, JournalValidSize))
+        {
+            // 末尾损坏的条目不截掉的话，之后追加的条目都会排在它后面而永远无法回放
+            if (JournalValidSize < Journal->GetFileSize())
+            {
+                Journal->TruncateTo(JournalValidSize);
+            }
+
+            // 回放直接从数组中移除卸载的记录，不经过 RemoveRecordAt：快照中的检查点在这里同步清理
+            RemoveCheckpointContributions(UnloadedOperationIds);
+            UE_LOG(LogSyStateManager, Log, TEXT("Replayed %d journal entries from: %s. %d records after replay."), 
+                NumApplied, *Journal->GetFilePath(), ModificationLog.Num());
+            bLoaded |= NumApplied > 0;
+        }
+    }
+
+    // 日志被整体替换：先恢复游戏时钟（到期时刻依赖它），再重建索引与快照（失败时日志为空，同样需要清空旧快照）
+    RestoreExpiryGameClock(SavedClockSeconds);
+    RebuildIndicesAndSnapshots();
+
+    return bLoaded;
+}
+
+bool USyStateManagerSubsystem::ApplySaveGameSnapshot(USaveGame* LoadedSaveGame, double& OutExpiryGameClockSeconds)
+{
+    USyStateManagerSaveGame* StateSaveGame = Cast<USyStateManagerSaveGame>(LoadedSaveGame);
+    if (!StateSaveGame)
+    {
+        UE_LOG(LogSyStateManager, Error, TEXT("Failed to load State Manager Log from slot: %s (Cast Failed)"), *SaveSlotName);
+        return false;
+    }
+
+    // 从存档对象恢复日志数据
+    // 这里直接覆盖当前的 ModificationLog。如果需要合并或更复杂的逻辑，在此处修改。
+    // 存档对象只用于本次读档，记录直接移出
+    ModificationLog = MoveTemp(StateSaveGame->SavedModificationLog);
+    RestoreCheckpoints(StateSaveGame->SavedCheckpoints);
+    OutExpiryGameClockSeconds = StateSaveGame->SavedExpiryGameClockSeconds;
+    UE_LOG(LogSyStateManager, Log, TEXT("State Manager Log loaded successfully from slot: %s. %d records loaded."), 
+        *SaveSlotName, ModificationLog.Num());
+    // 索引、快照与订阅者通知由 FinishLoadLog 在回放日志后统一重建
+    return true;
+}
+
+void USyStateManagerSubsystem::BuildSavedCheckpoints(TArray<FSyStateTargetCheckpoint>& OutCheckpoints) const
+{
+    OutCheckpoints.Reset(Checkpoints.Num());
+    for (const TPair<FSyStateTargetKey, TArray<FSyStateCheckpointEntry>>& Pair : Checkpoints)
+    {
+        FSyStateTargetCheckpoint& Saved = OutCheckpoints.AddDefaulted_GetRef();
+        Saved.Target = Pair.Key.ToOperationTarget();
+        Saved.Entries = Pair.Value;
+    }
+}
+
+void USyStateManagerSubsystem::RestoreCheckpoints(const TArray<FSyStateTargetCheckpoint>& SavedCheckpoints)
+{
+    Checkpoints.Reset();
+    for (const FSyStateTargetCheckpoint& Saved : SavedCheckpoints)
+    {
+        const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(Saved.Target);
+        if (TargetKey.IsValid() && Saved.Entries.Num() > 0)
+        {
+            Checkpoints.Add(TargetKey, Saved.Entries);
+        }
+    }
+}
+
+void USyStateManagerSubsystem::RemoveCheckpointContributions(const TArray<FGuid>& OperationIds)
+{
+    if (OperationIds.Num() == 0 || Checkpoints.Num() == 0)
+    {
+        return;
+    }
+
+    const TSet<FGuid> RemovedIds(OperationIds);
+    for (auto It = Checkpoints.CreateIterator(); It; ++It)
+    {
+        // RemoveAll 保持检查点的时间顺序
+        It.Value().RemoveAll([&RemovedIds](const FSyStateCheckpointEntry& Entry)
+        {
+            return RemovedIds.Contains(Entry.ContributorOperationId);
+        });
+        if (It.Value().Num() == 0)
+        {
+            It.RemoveCurrent();
+        }
+    }
+}
+
+// ===== 异步存档 / 读档 =====
+
+bool USyStateManagerSubsystem::SaveLogAsync(const FOnStateLogAsyncComplete& OnComplete)
+{
+    if (bAsyncPersistenceInProgress)
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("SaveLogAsync: another async save/load is in progress."));
+        return false;
+    }
+
+    // Journal 模式下与 SaveLog 相同，只追加上次写入后的增量（代价很小，同步完成）
+    if (PersistenceMode == ESyStatePersistenceMode::Journal && Journal)
+    {
+        const bool bSuccess = FlushJournal();
+        AsyncTask(ENamedThreads::GameThread, [OnComplete, bSuccess]()
+        {
+            OnComplete.ExecuteIfBound(bSuccess);
+        });
+        return true;
+    }
+
+    // 游戏线程只拷贝记录（共享载荷只增加引用）与检查点，之后日志的修改不会影响本次存档；
+    // 内联载荷、序列化与经 ISaveGameSystem 写入都在工作线程完成
+    TStrongObjectPtr<USyStateManagerSaveGame> SaveGameObject(CreateSaveGameObject());
+    if (!SaveGameObject)
+    {
+        return false;
+    }
+    TSharedRef<TArray<FSyStateModificationRecord>> Records = MakeShared<TArray<FSyStateModificationRecord>>(ModificationLog);
+
+    bAsyncPersistenceInProgress = true;
+    const double StartTime = FPlatformTime::Seconds();
+    TWeakObjectPtr<USyStateManagerSubsystem> WeakThis(this);
+
+    PendingAsyncTask = Async(EAsyncExecution::ThreadPool, [SaveGameObject = MoveTemp(SaveGameObject), Records, WeakThis, OnComplete, StartTime]() mutable
+    {
+        TArray<uint8> SaveData;
+        {
+            // 填充与序列化期间阻止 GC（存档对象的属性正在被本线程修改）
+            FGCScopeGuard GCGuard;
+            InlineRecordsForSave(*Records, SaveGameObject->SavedModificationLog);
+            UGameplayStatics::SaveGameToMemory(SaveGameObject.Get(), SaveData);
+        }
+
+        ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+        const bool bSuccess = SaveData.Num() > 0 && SaveSystem && SaveSystem->SaveGame(false, *SaveSlotName, UserIndex, SaveData);
+        const int32 NumRecords = Records->Num();
+
+        // 存档对象交回游戏线程释放
+        AsyncTask(ENamedThreads::GameThread, [SaveGameObject = MoveTemp(SaveGameObject), WeakThis, OnComplete, bSuccess, NumRecords, StartTime]()
+        {
+            if (USyStateManagerSubsystem* StateManager = WeakThis.Get())
+            {
+                StateManager->bAsyncPersistenceInProgress = false;
+            }
+
+            UE_LOG(LogSyStateManager, Log, TEXT("%s Async save of %d records to slot %s finished in %.2f ms."), 
+                bSuccess ? TEXT("✅") : TEXT("❌"), NumRecords, *SaveSlotName, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+            OnComplete.ExecuteIfBound(bSuccess);
+        });
+    });
+
+    return true;
+}
+
+bool USyStateManagerSubsystem::LoadLogAsync(const FOnStateLogAsyncComplete& OnComplete)
+{
+    if (bAsyncPersistenceInProgress)
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("LoadLogAsync: another async save/load is in progress."));
+        return false;
+    }
+
+    bAsyncPersistenceInProgress = true;
+    bAsyncLoadInProgress = true;
+    OperationsRecordedDuringAsyncLoad.Reset();
+    const double StartTime = FPlatformTime::Seconds();
+    TWeakObjectPtr<USyStateManagerSubsystem> WeakThis(this);
+
+    // 读取与反序列化在工作线程完成，游戏线程只替换日志、回放 Journal 并重建（与 LoadLog 读取同一槽位）
+    PendingAsyncTask = Async(EAsyncExecution::ThreadPool, [WeakThis, OnComplete, StartTime]()
+    {
+        TStrongObjectPtr<USaveGame> LoadedSaveGame;
+        TArray<uint8> SaveData;
+        ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+        if (SaveSystem && SaveSystem->DoesSaveGameExist(*SaveSlotName, UserIndex) && SaveSystem->LoadGame(false, *SaveSlotName, UserIndex, SaveData))
+        {
+            // 存档类为原生类，反序列化不会触发资源加载；新建的存档对象在 GC 恢复前已被强引用
+            FGCScopeGuard GCGuard;
+            LoadedSaveGame.Reset(UGameplayStatics::LoadGameFromMemory(SaveData));
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [LoadedSaveGame = MoveTemp(LoadedSaveGame), WeakThis, OnComplete, StartTime]()
+        {
+            bool bSuccess = false;
+            USyStateManagerSubsystem* StateManager = WeakThis.Get();
+            if (StateManager && StateManager->bAsyncPersistenceInProgress)
+            {
+                StateManager->bAsyncPersistenceInProgress = false;
+                bSuccess = StateManager->FinishLoadLogAsync(LoadedSaveGame.Get());
+            }
+
+            UE_LOG(LogSyStateManager, Log, TEXT("%s Async load from slot %s finished in %.2f ms."), 
+                bSuccess ? TEXT("✅") : TEXT("❌"), *SaveSlotName, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+            OnComplete.ExecuteIfBound(bSuccess);
+        });
+    });
+
+    return true;
+}
+
+bool USyStateManagerSubsystem::FinishLoadLogAsync(USaveGame* LoadedSaveGame)
+{
+    // 读取期间记录的操作中，之后又被卸载（手动、按来源或到期）的不再恢复
+    bAsyncLoadInProgress = false;
+    TArray<FSyOperation> OperationsToReapply = MoveTemp(OperationsRecordedDuringAsyncLoad);
+    OperationsToReapply.RemoveAll([this](const FSyOperation& Operation)
+    {
+        return !OperationIdIndex.Contains(Operation.OperationId);
+    });
+
+    FSyStateManagerBatchScope BatchScope(this);
+    ReleaseMappedLog();
+    if (!LoadedSaveGame)
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("No existing save game found for State Manager Log in slot: %s. Starting with an empty log."), *SaveSlotName);
+    }
+    const bool bLoaded = FinishLoadLog(LoadedSaveGame);
+
+    // FinishLoadLog 丢弃了尚未写入的 Journal 增量：重新记录后这些操作会再次追加；
+    // 读取期间已写入日志文件的操作已由回放恢复，跳过
+    int32 NumReapplied = 0;
+    for (const FSyOperation& Operation : OperationsToReapply)
+    {
+        if (!OperationIdIndex.Contains(Operation.OperationId) && RecordOperationInternal(Operation))
+        {
+            ++NumReapplied;
+        }
+    }
+    if (NumReapplied > 0)
+    {
+        UE_LOG(LogSyStateManager, Log, TEXT("Re-recorded %d operation(s) recorded while the async load was in flight."), NumReapplied);
+    }
+    return bLoaded;
+}
+
+bool USyStateManagerSubsystem::SaveLogMappedAsync(const FOnStateLogAsyncComplete& OnComplete)
+{
+    if (bAsyncPersistenceInProgress)
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("SaveLogMappedAsync: another async save/load is in progress."));
+        return false;
+    }
+
+    // 写入会替换映射中的文件：先解码全部目标（同时释放映射）
+    MaterializeAllTargets();
+
+    // 游戏线程只做拷贝，之后日志的修改不会影响本次写入
+    TSharedRef<FSyStateLogFileData> Data = MakeShared<FSyStateLogFileData>();
+    Data->Records = ModificationLog;
+    BuildSavedCheckpoints(Data->Checkpoints);
+    AdvanceExpiryGameClock();
+    Data->ExpiryGameClockSeconds = ExpiryGameClockSeconds;
+
+    bAsyncPersistenceInProgress = true;
+    const double StartTime = FPlatformTime::Seconds();
+    TWeakObjectPtr<USyStateManagerSubsystem> WeakThis(this);
+
+    PendingAsyncTask = Async(EAsyncExecution::ThreadPool, [Data, FilePath = GetLogFilePath(), WeakThis, OnComplete, StartTime]()
+    {
+        const bool bSuccess = FSyStateLogFile::Write(FilePath, *Data);
+        const int32 NumRecords = Data->Records.Num();
+
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, OnComplete, bSuccess, NumRecords, StartTime]()
+        {
+            if (USyStateManagerSubsystem* StateManager = WeakThis.Get())
+            {
+                StateManager->bAsyncPersistenceInProgress = false;
+            }
+
+            UE_LOG(LogSyStateManager, Log, TEXT("%s Async write of %d records to the mapped log file finished in %.2f ms."), 
+                bSuccess ? TEXT("✅") : TEXT("❌"), NumRecords, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+            OnComplete.ExecuteIfBound(bSuccess);
+        });
+    });
+
+    return true;
+}
+
+void USyStateManagerSubsystem::ApplyLoadedLog(FSyStateLogFileData&& Data)
+{
+    // 一次性替换：之前的日志、检查点与尚未解码的目标整体失效
+    ReleaseMappedLog();
+    ModificationLog = MoveTemp(Data.Records);
+    RestoreCheckpoints(Data.Checkpoints);
+    RestoreExpiryGameClock(Data.ExpiryGameClockSeconds);
+    RebuildIndicesAndSnapshots();
+
+    UE_LOG(LogSyStateManager, Log, TEXT("State Manager Log replaced: %d records, %d checkpoint(s)."), 
+        ModificationLog.Num(), Checkpoints.Num());
+}
+
+void USyStateManagerSubsystem::RebuildIndicesAndSnapshots()
+{
+    FSyStateManagerBatchScope BatchScope(this);
+    const double StartTime = FPlatformTime::Seconds();
+
+    // 替换前已有快照的目标也要重算（可能已经没有任何记录）
+    TSet<FSyStateTargetKey> AffectedTargets;
+    SnapshotCache.GetKeys(AffectedTargets);
+
+    TargetIndex.Reset();
+    OperationIdIndex.Reset();
+    StateTagIndex.Reset();
+    SourceTagIndex.Reset();
+    SourceEntityIndex.Reset();
+    WorkingSnapshots.Reset();
+    DirtySnapshotTargets.Reset();
+    PendingCompactionTargets.Reset();
+    ResetExpiries();
+
+    // 整个日志被替换：按新日志重建载荷池
+    PayloadPool.Reset();
+
+    for (int32 Index = 0; Index < ModificationLog.Num(); ++Index)
+    {
+        PayloadPool.InternRecord(ModificationLog[Index]);
+        const FSyStateModificationRecord& Record = ModificationLog[Index];
+        const FSyStateTargetKey TargetKey = FSyStateTargetKey::FromOperationTarget(Record.Operation.Target);
+        if (TargetKey.IsValid())
+        {
+            TargetIndex.FindOrAdd(TargetKey).Add(Index);
+            AffectedTargets.Add(TargetKey);
+        }
+        if (Record.Operation.OperationId.IsValid())
+        {
+            OperationIdIndex.Add(Record.Operation.OperationId, Index);
+        }
+        UpdateQueryIndices(Record, INDEX_NONE, Index);
+        ScheduleExpiry(Record);
+    }
+
+    for (const TPair<FSyStateTargetKey, TArray<FSyStateCheckpointEntry>>& Pair : Checkpoints)
+    {
+        AffectedTargets.Add(Pair.Key);
+    }
+
+    const double IndexEndTime = FPlatformTime::Seconds();
+
+    // 各目标的聚合互不依赖（只读日志与索引），并行计算；发布与版本号分配在游戏线程按顺序完成
+    const TArray<FSyStateTargetKey> Targets = AffectedTargets.Array();
+    TArray<TMap<FGameplayTag, TArray<FInstancedStruct>>> AggregatedMaps;
+    AggregatedMaps.SetNum(Targets.Num());
+    ParallelFor(Targets.Num(), [this, &Targets, &AggregatedMaps](int32 TargetIndexInBatch)
+    {
+        AggregateTargetParams(Targets[TargetIndexInBatch], AggregatedMaps[TargetIndexInBatch]);
+    });
+
+    const double AggregateEndTime = FPlatformTime::Seconds();
+
+    TSet<FGameplayTag> ChangedTypeTags;
+    for (int32 i = 0; i < Targets.Num(); ++i)
+    {
+        const FSyStateTargetKey& TargetKey = Targets[i];
+        PublishRecalculatedSnapshot(TargetKey, MoveTemp(AggregatedMaps[i]));
+        if (TargetKey.Scope == ESyStateTargetScope::Type)
+        {
+            ChangedTypeTags.Add(TargetKey.TypeTag);
+        }
+
+        // 每个目标通知一次（批处理提交时派发）
+        PendingTargetNotifications.FindOrAdd(TargetKey).Target = TargetKey;
+    }
+    if (ChangedTypeTags.Num() > 0)
     {
-        OnStateModificationChanged.Broadcast(NewRecord);
+        RefreshEffectiveTypeSnapshots(ChangedTypeTags);
     }
 
-    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("✅ Operation recorded. RecordId: %s, OperationId: %s, Target: %s"), 
-        *NewRecord.RecordId.ToString(), *Operation.OperationId.ToString(), *Operation.Target.TargetTypeTag.ToString());
-    return true;
+    const double EndTime = FPlatformTime::Seconds();
+    LastRebuildTimeMs = static_cast<float>((EndTime - StartTime) * 1000.0);
+
+    UE_LOG(LogSyStateManager, Log, TEXT("⏱️ Rebuilt %d records across %d target(s) in %.2f ms (indices %.2f ms, parallel aggregation %.2f ms, publish %.2f ms)."), 
+        ModificationLog.Num(), Targets.Num(), LastRebuildTimeMs,
+        (IndexEndTime - StartTime) * 1000.0, (AggregateEndTime - IndexEndTime) * 1000.0, (EndTime - AggregateEndTime) * 1000.0);
 }
 
-bool USyStateManagerSubsystem::UnloadOperation(const FGuid& OperationIdToUnload)
+// ===== 内存映射读档 =====
+
+bool USyStateManagerSubsystem::LoadLogMapped()
 {
-    if (!OperationIdToUnload.IsValid())
+    if (bAsyncPersistenceInProgress)
     {
-        UE_LOG(LogSyStateManager, Warning, TEXT("UnloadOperation called with invalid GUID."));
+        UE_LOG(LogSyStateManager, Warning, TEXT("LoadLogMapped: an async save/load is in progress."));
         return false;
     }
 
-    // 使用索引快速查找
-    const int32* FoundIndexPtr = OperationIdIndex.Find(OperationIdToUnload);
-    if (!FoundIndexPtr)
+    const FString FilePath = GetLogFilePath();
+    ReleaseMappedLog();
+    TUniquePtr<FSyStateMappedLogFile> MappedFile = FSyStateMappedLogFile::Open(FilePath);
+    if (!MappedFile)
     {
-        UE_LOG(LogSyStateManager, Log, TEXT("UnloadOperation: Operation with ID %s not found in log."), *OperationIdToUnload.ToString());
-        return false;
+        // 旧版本文件或平台不支持映射：退化为完整读取
+        FSyStateLogFileData Data;
+        if (!FSyStateLogFile::Read(FilePath, Data))
+        {
+            UE_LOG(LogSyStateManager, Log, TEXT("LoadLogMapped: no readable state log file at: %s"), *FilePath);
+            return false;
+        }
+        ApplyLoadedLog(MoveTemp(Data));
+        return true;
     }
 
-    int32 FoundIndex = *FoundIndexPtr;
-    if (!ModificationLog.IsValidIndex(FoundIndex))
+    FSyStateManagerBatchScope BatchScope(this);
+    const double StartTime = FPlatformTime::Seconds();
+
+    // 已经有读取方的目标立即解码：已有快照、订阅者，以及已缓存层级快照的整条祖先链
+    TSet<FSyStateTargetKey> EagerTargets;
+    SnapshotCache.GetKeys(EagerTargets);
+    for (const TPair<FSyStateTargetKey, TArray<FSubscriberInfo>>& Pair : TargetSubscribers)
     {
-        UE_LOG(LogSyStateManager, Error, TEXT("UnloadOperation: Invalid index %d for operation ID %s"), FoundIndex, *OperationIdToUnload.ToString());
-        OperationIdIndex.Remove(OperationIdToUnload);
-        return false;
+        EagerTargets.Add(Pair.Key);
+    }
+    for (const TPair<FGameplayTag, FSyStateSnapshotPtr>& Pair : EffectiveTypeSnapshotCache)
+    {
+        for (const FGameplayTag& AncestorTag : GetTypeAncestry(Pair.Key))
+        {
+            EagerTargets.Add(FSyStateTargetKey::FromType(AncestorTag));
+        }
     }
 
-    // 保存副本用于广播
-    FSyStateModificationRecord RecordCopy = ModificationLog[FoundIndex];
-    FGameplayTag TargetTag = RecordCopy.Operation.Target.TargetTypeTag;
-    
-    // 从日志中移除（使用 RemoveAtSwap 提高效率）
-    ModificationLog.RemoveAtSwap(FoundIndex);
-    
-    // 更新索引 - 由于使用了 RemoveAtSwap，需要更新被交换的元素的索引
-    if (ModificationLog.IsValidIndex(FoundIndex))
+    // 先替换为空日志：旧快照全部清空并登记通知
+    ModificationLog.Reset();
+    Checkpoints.Reset();
+    RebuildIndicesAndSnapshots();
+
+    // 尚未解码的记录按写入时的游戏时钟计算到期时刻
+    RestoreExpiryGameClock(MappedFile->GetExpiryGameClockSeconds());
+
+    const int64 FileSize = MappedFile->GetFileSize();
+    MappedLogFile = MoveTemp(MappedFile);
+    const TArray<FSyStateLogFileTargetEntry>& Directory = MappedLogFile->GetDirectory();
+    LazyTargets.Reserve(Directory.Num());
+    int32 NumFileRecords = 0;
+    for (int32 DirectoryIndex = 0; DirectoryIndex < Directory.Num(); ++DirectoryIndex)
     {
-        // 被交换到当前位置的记录需要更新索引
-        const FSyStateModificationRecord& SwappedRecord = ModificationLog[FoundIndex];
-        
-        // 更新操作ID索引
-        if (SwappedRecord.Operation.OperationId.IsValid())
+        if (Directory[DirectoryIndex].Target.IsValid())
         {
-            OperationIdIndex.Add(SwappedRecord.Operation.OperationId, FoundIndex);
+            LazyTargets.Add(Directory[DirectoryIndex].Target, DirectoryIndex);
+            NumFileRecords += Directory[DirectoryIndex].NumRecords;
         }
-        
-        // 更新目标类型索引
-        if (SwappedRecord.Operation.Target.TargetTypeTag.IsValid())
+    }
+    const int32 NumFileTargets = LazyTargets.Num();
+
+    TSet<FGameplayTag> ChangedTypeTags;
+    for (const FSyStateTargetKey& TargetKey : EagerTargets)
+    {
+        if (MaterializeTarget(TargetKey))
         {
-            TArray<int32>* IndicesPtr = TargetTypeIndex.Find(SwappedRecord.Operation.Target.TargetTypeTag);
-            if (IndicesPtr)
+            PendingTargetNotifications.FindOrAdd(TargetKey).Target = TargetKey;
+            if (TargetKey.Scope == ESyStateTargetScope::Type)
             {
-                int32 OldIndex = IndicesPtr->Find(ModificationLog.Num()); // 原来的最后一个索引
-                if (OldIndex != INDEX_NONE)
-                {
-                    (*IndicesPtr)[OldIndex] = FoundIndex;
-                }
+                ChangedTypeTags.Add(TargetKey.TypeTag);
             }
         }
     }
-    
-    // 从索引中移除被卸载的操作
-    OperationIdIndex.Remove(OperationIdToUnload);
-    
-    if (TargetTag.IsValid())
+    if (ChangedTypeTags.Num() > 0)
     {
-        TArray<int32>* IndicesPtr = TargetTypeIndex.Find(TargetTag);
-        if (IndicesPtr)
-        {
-            IndicesPtr->Remove(FoundIndex);
-        }
-        
-        // 重新计算该 TargetTag 的聚合快照
-        RecalculateSnapshotForTarget(TargetTag);
-        
-        GlobalVersion++;
-        
-        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("🔄 Recalculated snapshot for target tag: %s after unload"), 
-            *TargetTag.ToString());
+        RefreshEffectiveTypeSnapshots(ChangedTypeTags);
     }
-    
-    UE_LOG(LogSyStateManager, Log, TEXT("✅ Unloaded operation with ID: %s"), *OperationIdToUnload.ToString());
-    
-    // 广播变更
-    if (OnStateModificationChanged.IsBound())
+    if (LazyTargets.Num() == 0)
     {
-        OnStateModificationChanged.Broadcast(RecordCopy);
+        ReleaseMappedLog();
     }
-    
+
+    LastRebuildTimeMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+    UE_LOG(LogSyStateManager, Log, TEXT("⏱️ Mapped state log %s (%lld bytes, %d records in %d target(s)) in %.2f ms; %d target(s) decoded eagerly, %d deferred."), 
+        *FilePath, FileSize, NumFileRecords, NumFileTargets, LastRebuildTimeMs,
+        NumFileTargets - LazyTargets.Num(), LazyTargets.Num());
     return true;
 }
 
-// TODO: 替换为标准过滤规则，现在没用到所以懒得整
-int32 USyStateManagerSubsystem::UnloadOperationsBySource(const FSyOperationSource& SourceToMatch)
+bool USyStateManagerSubsystem::MaterializeTarget(const FSyStateTargetKey& TargetKey)
 {
-    TArray<FSyStateModificationRecord> RecordsToBroadcast;
-    TSet<FGameplayTag> AffectedTargetTags; // 收集受影响的目标类型
-    int32 RemovedCount = 0;
-
-    // Use RemoveAllSwap with predicate, collecting copies for broadcast
-    RemovedCount = ModificationLog.RemoveAllSwap([
-        &](const FSyStateModificationRecord& Record) -> bool 
-        {
-            if (bool bMatch = (Record.Operation.Source.SourceTypeTag == SourceToMatch.SourceTypeTag))
-            {   
-                RecordsToBroadcast.Add(Record); // Add copy before potential removal
-                if (Record.Operation.Target.TargetTypeTag.IsValid())
-                {
-                    AffectedTargetTags.Add(Record.Operation.Target.TargetTypeTag); // 记录受影响的目标
-                }
-                return true; // Mark for removal
-            }
-            return false; 
-        });
+    int32 DirectoryIndex = INDEX_NONE;
+    if (!LazyTargets.RemoveAndCopyValue(TargetKey, DirectoryIndex))
+    {
+        return false;
+    }
 
-    if (RemovedCount > 0)
+    const FSyStateLogFileTargetEntry& Entry = MappedLogFile->GetDirectory()[DirectoryIndex];
+    TArray<FSyStateModificationRecord> Records;
+    TArray<int32> RecordSequence;
+    TArray<FSyStateCheckpointEntry> CheckpointEntries;
+    if (MappedLogFile->ReadTarget(Entry, Records, RecordSequence, CheckpointEntries))
     {
-        UE_LOG(LogSyStateManager, Log, TEXT("Unloaded %d operations matching source (Tag: %s)."), 
-            RemovedCount, 
-            *SourceToMatch.SourceTypeTag.ToString());
+        if (CheckpointEntries.Num() > 0)
+        {
+            Checkpoints.Add(TargetKey, MoveTemp(CheckpointEntries));
+        }
 
-        // 重建索引并重新计算受影响目标的快照
-        OperationIdIndex.Empty();
-        TargetTypeIndex.Empty();
-        for (int32 i = 0; i < ModificationLog.Num(); ++i)
+        ModificationLog.Reserve(ModificationLog.Num() + Records.Num());
+        TArray<int32>& TargetIndices = TargetIndex.FindOrAdd(TargetKey);
+        for (int32 RecordIndex = 0; RecordIndex < Records.Num(); ++RecordIndex)
         {
-            const FSyStateModificationRecord& Record = ModificationLog[i];
-            if (Record.Operation.OperationId.IsValid())
-            {
-                OperationIdIndex.Add(Record.Operation.OperationId, i);
-            }
-            if (Record.Operation.Target.TargetTypeTag.IsValid())
+            if (RecordSequence[RecordIndex] != INDEX_NONE)
             {
-                TargetTypeIndex.FindOrAdd(Record.Operation.Target.TargetTypeTag).Add(i);
+                MappedRecordSequence.Add(Records[RecordIndex].RecordId, RecordSequence[RecordIndex]);
             }
-        }
-        
-        // 重新计算所有受影响目标的聚合快照
-        for (const FGameplayTag& AffectedTag : AffectedTargetTags)
-        {
-            RecalculateSnapshotForTarget(AffectedTag);
-        }
-        
-        GlobalVersion++;
 
-        // Broadcast the change for each removed record using the unified delegate
-        if (OnStateModificationChanged.IsBound())
-        {
-            for (const FSyStateModificationRecord& RemovedRecord : RecordsToBroadcast)
+            const int32 NewIndex = ModificationLog.Add(MoveTemp(Records[RecordIndex]));
+            PayloadPool.InternRecord(ModificationLog[NewIndex]);
+            const FSyStateModificationRecord& NewRecord = ModificationLog[NewIndex];
+            TargetIndices.Add(NewIndex);
+            if (NewRecord.Operation.OperationId.IsValid())
             {
-                 OnStateModificationChanged.Broadcast(RemovedRecord);
+                OperationIdIndex.Add(NewRecord.Operation.OperationId, NewIndex);
             }
+            UpdateQueryIndices(NewRecord, INDEX_NONE, NewIndex);
+            ScheduleExpiry(NewRecord);
         }
+
+        RecalculateSnapshotForTarget(TargetKey);
+
+        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("Materialized %d records for target: %s"), Records.Num(), *TargetKey.ToString());
     }
     else
     {
-        UE_LOG(LogSyStateManager, Log, TEXT("UnloadOperationsBySource: No operations found matching source (Tag: %s)."), 
-            *SourceToMatch.SourceTypeTag.ToString());
+        UE_LOG(LogSyStateManager, Error, TEXT("Failed to decode records for target %s from mapped state log."), *TargetKey.ToString());
     }
 
-    return RemovedCount;
+    if (LazyTargets.Num() == 0)
+    {
+        RestoreMappedRecordOrder();
+        ReleaseMappedLog();
+    }
+    return true;
 }
 
-FSyStateParameterSet USyStateManagerSubsystem::GetAggregatedModifications(const FGameplayTag& TargetFilterTag /* TODO: 添加 SourceFilterTag */) const
+void USyStateManagerSubsystem::MaterializeAllTargets()
 {
-    // ===== 直接返回预聚合快照 =====
-    if (TargetFilterTag.IsValid())
+    if (LazyTargets.Num() == 0)
     {
-        // 查找预聚合的快照
-        const FSyStateParameterSet* Snapshot = AggregatedCache.Find(TargetFilterTag);
-        if (Snapshot)
-        {
-            UE_LOG(LogSyStateManager, VeryVerbose, TEXT("⚡ Returning pre-aggregated snapshot for target tag: %s"), 
-                *TargetFilterTag.ToString());
-            return *Snapshot;
-        }
-        
-        // 快照不存在，说明还没有该目标类型的操作记录
-        UE_LOG(LogSyStateManager, VeryVerbose, TEXT("No snapshot found for target tag: %s, returning empty set"), 
-            *TargetFilterTag.ToString());
-        return FSyStateParameterSet();
+        return;
     }
 
-    // 没有目标过滤时，手动聚合所有记录（保持向后兼容）
-    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("No target filter provided, manually aggregating all records..."));
-    
-    FSyStateParameterSet AggregatedResult;
-    TMap<FGameplayTag, TArray<FInstancedStruct>> AggregatedParamsMap;
-    
-    for (const FSyStateModificationRecord& Record : ModificationLog)
+    const double StartTime = FPlatformTime::Seconds();
+    TArray<FSyStateTargetKey> Targets;
+    LazyTargets.GetKeys(Targets);
+    for (const FSyStateTargetKey& TargetKey : Targets)
     {
-        AggregateRecordModifications(Record, AggregatedParamsMap);
+        MaterializeTarget(TargetKey);
     }
-    
-    AggregatedResult = AggregatedParamsMap;
-    return AggregatedResult;
-}
-
-// 辅助方法：聚合单个记录的修改
-void USyStateManagerSubsystem::AggregateRecordModifications(
-    const FSyStateModificationRecord& Record,
-    TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const
-{
-    for (const auto& Pair : Record.Operation.Modifier.StateModifications.GetParametersAsMap())
-    {
-        const FGameplayTag& StateTag = Pair.Key;
-        const TArray<FInstancedStruct>& ParamsToMerge = Pair.Value;
-
-        TArray<FInstancedStruct>& ExistingParams = OutAggregatedMap.FindOrAdd(StateTag);
-
-        for (const FInstancedStruct& SourceStruct : ParamsToMerge)
-        {
-            if (!SourceStruct.IsValid()) continue;
-
-            const UScriptStruct* StructType = SourceStruct.GetScriptStruct();
-            if (!StructType) continue;
-
-            FInstancedStruct* TargetStructPtr = ExistingParams.FindByPredicate(
-                [&StructType](const FInstancedStruct& ExistingStruct)
-                {
-                    return ExistingStruct.IsValid() && ExistingStruct.GetScriptStruct() == StructType;
-                });
-
-            if (TargetStructPtr)
-            {
-                const UScriptStruct* ListBaseType = FSyListParameterBase::StaticStruct();
 
-                if (StructType && StructType->IsChildOf(ListBaseType) && TargetStructPtr->GetScriptStruct()->IsChildOf(ListBaseType))
-                {
-                    FSyListParameterBase* TargetListBase = TargetStructPtr->GetMutablePtr<FSyListParameterBase>();
-                    const FSyListParameterBase* SourceListBase = SourceStruct.GetPtr<FSyListParameterBase>();
-
-                    if (TargetListBase && SourceListBase)
-                    {
-                        const TArray<FInstancedStruct>& ItemsToAggregate = SourceListBase->GetListItemsInternal();
-                        TargetListBase->AggregateItemsInternal(ItemsToAggregate);
-                    }
-                    else
-                    {
-                        UE_LOG(LogSyStateManager, Warning, TEXT("Failed to get FSyListParameterBase pointers for aggregation for type: %s. Falling back to overwrite."), *StructType->GetName());
-                        *TargetStructPtr = SourceStruct;
-                    }
-                }
-                else
-                {
-                    *TargetStructPtr = SourceStruct;
-                }
-            }
-            else
-            {
-                ExistingParams.Add(SourceStruct);
-            }
-        }
-    }
+    UE_LOG(LogSyStateManager, Verbose, TEXT("Materialized %d deferred target(s) in %.2f ms."), 
+        Targets.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
 }
 
-void USyStateManagerSubsystem::RecalculateSnapshotForTarget(const FGameplayTag& TargetTag)
+void USyStateManagerSubsystem::RestoreMappedRecordOrder()
 {
-    if (!TargetTag.IsValid())
+    if (MappedRecordSequence.Num() == 0)
     {
         return;
     }
 
-    // 清空现有快照
-    FSyStateParameterSet& Snapshot = AggregatedCache.FindOrAdd(TargetTag);
-    Snapshot.ClearAllStateParams();
+    // 文件记录按写入时的位置排序；读档后新记录的操作排在其后，相互之间保持原有顺序
+    TArray<int64> SortKeys;
+    TArray<int32> Order;
+    SortKeys.Reserve(ModificationLog.Num());
+    Order.Reserve(ModificationLog.Num());
+    for (int32 Index = 0; Index < ModificationLog.Num(); ++Index)
+    {
+        const int32* Sequence = MappedRecordSequence.Find(ModificationLog[Index].RecordId);
+        SortKeys.Add(Sequence ? *Sequence : static_cast<int64>(MAX_int32) + 1 + Index);
+        Order.Add(Index);
+    }
+    MappedRecordSequence.Empty();
+    Algo::StableSortBy(Order, [&SortKeys](int32 Index) { return SortKeys[Index]; });
 
-    // 使用索引获取该目标类型的所有记录
-    const TArray<int32>* IndicesPtr = TargetTypeIndex.Find(TargetTag);
-    if (!IndicesPtr || IndicesPtr->Num() == 0)
+    TArray<int32> NewIndices;
+    NewIndices.SetNumUninitialized(Order.Num());
+    TArray<FSyStateModificationRecord> OrderedLog;
+    OrderedLog.Reserve(Order.Num());
+    for (int32 OldIndex : Order)
     {
-        // 没有相关记录，快照保持为空
-        CacheVersions.Add(TargetTag, GlobalVersion);
-        UE_LOG(LogSyStateManager, Verbose, TEXT("Recalculated empty snapshot for target tag: %s"), *TargetTag.ToString());
-        return;
+        NewIndices[OldIndex] = OrderedLog.Add(MoveTemp(ModificationLog[OldIndex]));
     }
+    ModificationLog = MoveTemp(OrderedLog);
 
-    // 重新聚合所有相关记录
-    TMap<FGameplayTag, TArray<FInstancedStruct>> AggregatedMap;
-    for (int32 Index : *IndicesPtr)
+    // 目标索引保持列表内的时间顺序，只替换位置；查询索引按新位置升序
+    for (TPair<FSyStateTargetKey, TArray<int32>>& Pair : TargetIndex)
     {
-        if (ModificationLog.IsValidIndex(Index))
+        for (int32& Index : Pair.Value)
         {
-            AggregateRecordModifications(ModificationLog[Index], AggregatedMap);
+            Index = NewIndices[Index];
         }
     }
+    for (TPair<FGuid, int32>& Pair : OperationIdIndex)
+    {
+        Pair.Value = NewIndices[Pair.Value];
+    }
+    auto RemapQueryIndex = [&NewIndices](auto& IndexMap)
+    {
+        for (auto& Pair : IndexMap)
+        {
+            for (int32& Index : Pair.Value)
+            {
+                Index = NewIndices[Index];
+            }
+            Pair.Value.Sort();
+        }
+    };
+    RemapQueryIndex(StateTagIndex);
+    RemapQueryIndex(SourceTagIndex);
+    RemapQueryIndex(SourceEntityIndex);
+}
 
-    // 更新快照
-    Snapshot = AggregatedMap;
-    CacheVersions.Add(TargetTag, GlobalVersion);
-
-    UE_LOG(LogSyStateManager, Verbose, TEXT("✅ Recalculated snapshot for target tag: %s with %d records"), 
-        *TargetTag.ToString(), IndicesPtr->Num());
+void USyStateManagerSubsystem::ReleaseMappedLog()
+{
+    LazyTargets.Empty();
+    MappedRecordSequence.Empty();
+    MappedLogFile.Reset();
 }
 
-const TArray<FSyStateModificationRecord>& USyStateManagerSubsystem::GetAllModifications_Simple() const
+FString USyStateManagerSubsystem::GetLogFilePath()
 {
-    return ModificationLog;
+    return FPaths::ProjectSavedDir() / TEXT("SaveGames") / (SaveSlotName + TEXT(".sylog"));
 }
 
-bool USyStateManagerSubsystem::SaveLog()
+void USyStateManagerSubsystem::SetPersistenceMode(ESyStatePersistenceMode NewMode)
 {
-    // 创建或获取 SaveGame 对象
-    USyStateManagerSaveGame* SaveGameObject = nullptr;
-    if (UGameplayStatics::DoesSaveGameExist(SaveSlotName, UserIndex))
+    if (PersistenceMode == NewMode)
     {
-        SaveGameObject = Cast<USyStateManagerSaveGame>(UGameplayStatics::LoadGameFromSlot(SaveSlotName, UserIndex));
+        return;
     }
-    
-    // 如果不存在或加载失败，创建一个新的
-    if (!SaveGameObject)
+
+    PersistenceMode = NewMode;
+    if (NewMode == ESyStatePersistenceMode::Journal)
     {
-        SaveGameObject = Cast<USyStateManagerSaveGame>(UGameplayStatics::CreateSaveGameObject(USyStateManagerSaveGame::StaticClass()));
-        if (!SaveGameObject)
+        // 日志文件只记录快照之后的增量：已有运行时数据时先写入当前完整状态；
+        // 日志为空时（通常随后调用 LoadLog）沿用磁盘上已有的快照与日志文件
+        Journal = MakeUnique<FSyStateJournal>(GetJournalFilePath());
+        if (ModificationLog.Num() > 0 || Checkpoints.Num() > 0)
         {
-            UE_LOG(LogSyStateManager, Error, TEXT("Failed to create SaveGameObject!"));
-            return false;
+            CompactJournal();
         }
     }
+    else if (Journal)
+    {
+        // 切换方式不等于存档：尚未 SaveLog 的增量丢弃，需要保留时先调用 SaveLog
+        Journal->DiscardPending();
+        Journal.Reset();
+    }
 
-    // 将当前的日志数据复制到 SaveGame 对象中
-    SaveGameObject->SavedModificationLog = ModificationLog;
-    SaveGameObject->SaveGameVersion = TEXT("1.0"); // 更新版本号（如果需要）
-
-    // 保存到磁盘
-    bool bSuccess = UGameplayStatics::SaveGameToSlot(SaveGameObject, SaveSlotName, UserIndex);
+    UE_LOG(LogSyStateManager, Log, TEXT("State persistence mode set to %s."), 
+        NewMode == ESyStatePersistenceMode::Journal ? TEXT("Journal") : TEXT("SaveGame"));
+}
 
-    if (bSuccess)
+bool USyStateManagerSubsystem::FlushJournal()
+{
+    if (!Journal)
     {
-        UE_LOG(LogSyStateManager, Log, TEXT("State Manager Log saved successfully to slot: %s"), *SaveSlotName);
+        return false;
     }
-    else
+
+    if (!Journal->Flush())
     {
-        UE_LOG(LogSyStateManager, Error, TEXT("Failed to save State Manager Log to slot: %s"), *SaveSlotName);
+        return false;
     }
 
-    return bSuccess;
+    // 合并会写 SaveGame 槽位：异步存档 / 读档正在工作线程读写同一槽位时留到之后的写入
+    if (Journal->GetFileSize() >= JournalCompactionThresholdBytes && !bAsyncPersistenceInProgress)
+    {
+        return CompactJournal();
+    }
+    return true;
 }
 
-bool USyStateManagerSubsystem::LoadLog()
+bool USyStateManagerSubsystem::CompactJournal()
 {
-    // 检查存档是否存在
-    if (UGameplayStatics::DoesSaveGameExist(SaveSlotName, UserIndex))
+    if (!Journal)
     {
-        // 加载存档对象
-        USyStateManagerSaveGame* LoadedSaveGame = Cast<USyStateManagerSaveGame>(UGameplayStatics::LoadGameFromSlot(SaveSlotName, UserIndex));
+        return false;
+    }
 
-        if (LoadedSaveGame)
-        {
-            // 从存档对象恢复日志数据
-            // 这里直接覆盖当前的 ModificationLog。如果需要合并或更复杂的逻辑，在此处修改。
-            ModificationLog = LoadedSaveGame->SavedModificationLog;
-            UE_LOG(LogSyStateManager, Log, TEXT("State Manager Log loaded successfully from slot: %s. %d records loaded."), 
-                *SaveSlotName, ModificationLog.Num());
-            
-            // TODO: 加载后可能需要重新广播事件或通知相关系统状态已恢复？
-            // 这取决于下游系统的设计。
-            
-            return true;
-        }
-        else
-        {
-            UE_LOG(LogSyStateManager, Error, TEXT("Failed to load State Manager Log from slot: %s (Cast Failed)"), *SaveSlotName);
-        }
+    const int64 JournalBytes = Journal->GetFileSize() + Journal->GetNumPendingBytes();
+
+    // 先写快照再删日志：两步之间崩溃时，回放会跳过快照中已存在的操作
+    if (!WriteSaveGameSnapshot())
+    {
+        return false;
     }
-    else
+
+    if (!Journal->Reset())
     {
-        UE_LOG(LogSyStateManager, Log, TEXT("No existing save game found for State Manager Log in slot: %s. Starting with an empty log."), *SaveSlotName);
+        UE_LOG(LogSyStateManager, Warning, TEXT("Failed to delete state journal after writing the snapshot: %s"), *Journal->GetFilePath());
+        return false;
     }
 
-    // 如果加载失败或存档不存在，确保日志是空的
-    ModificationLog.Empty();
-    return false;
+    UE_LOG(LogSyStateManager, Log, TEXT("🗜️ Compacted state journal (%lld bytes) into snapshot slot: %s"), JournalBytes, *SaveSlotName);
+    return true;
 }
 
-void USyStateManagerSubsystem::AddRecordAndBroadcast(const FSyStateModificationRecord& Record)
+FString USyStateManagerSubsystem::GetJournalFilePath()
 {
-    ModificationLog.Add(Record);
-    // Broadcast using the unified delegate
-    if (OnStateModificationChanged.IsBound())
-    {
-        OnStateModificationChanged.Broadcast(Record);
-    }
+    return FPaths::ProjectSavedDir() / TEXT("SaveGames") / (SaveSlotName + TEXT(".journal"));
 }
 
 bool USyStateManagerSubsystem::ValidateOperation(const FSyOperation& Operation) const
@@ -539,9 +2565,14 @@ bool USyStateManagerSubsystem::ValidateOperation(const FSyOperation& Operation)
         UE_LOG(LogSyStateManager, Warning, TEXT("ValidateOperation failed: OperationId is invalid."));
         return false;
     }
-    if (!Operation.Target.TargetTypeTag.IsValid())
+    if (!FSyStateTargetKey::FromOperationTarget(Operation.Target).IsValid())
     {        
-        UE_LOG(LogSyStateManager, Warning, TEXT("ValidateOperation failed: TargetTypeTag is invalid for OpId: %s."), *Operation.OperationId.ToString());
+        UE_LOG(LogSyStateManager, Warning, TEXT("ValidateOperation failed: Target has no valid TargetTypeTag, TargetAlias or TargetEntityId for OpId: %s."), *Operation.OperationId.ToString());
+        return false;
+    }
+    if (Operation.Expiry.IsSet() && Operation.Expiry.DurationSeconds < 0.0f)
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("ValidateOperation failed: negative expiry duration %.2f for OpId: %s."), Operation.Expiry.DurationSeconds, *Operation.OperationId.ToString());
         return false;
     }
     // Add more validation as needed (e.g., check source, modifier)
@@ -555,51 +2586,93 @@ void USyStateManagerSubsystem::SubscribeToTargetType(
     UObject* Subscriber,
     FOnStateModificationChangedNative Delegate)
 {
-    if (!TargetTypeTag.IsValid())
+    if (!Delegate.IsBound())
     {
-        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTargetType: Invalid TargetTypeTag"));
+        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTargetType: Delegate not bound"));
         return;
     }
-    
-    if (!Subscriber)
+
+    AddSubscriber(FSyStateTargetKey::FromType(TargetTypeTag), FSubscriberInfo(Subscriber, MoveTemp(Delegate)));
+}
+
+void USyStateManagerSubsystem::SubscribeToTargetType(
+    FGameplayTag TargetTypeTag, 
+    UObject* Subscriber,
+    FOnTargetStateChangedNative Delegate)
+{
+    if (!Delegate.IsBound())
     {
-        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTargetType: Null Subscriber"));
+        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTargetType: Delegate not bound"));
         return;
     }
-    
+
+    AddSubscriber(FSyStateTargetKey::FromType(TargetTypeTag), FSubscriberInfo(Subscriber, MoveTemp(Delegate)));
+}
+
+void USyStateManagerSubsystem::SubscribeToTarget(
+    const FSyStateTargetKey& TargetKey,
+    UObject* Subscriber,
+    FOnTargetStateChangedNative Delegate)
+{
     if (!Delegate.IsBound())
     {
-        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTargetType: Delegate not bound"));
+        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTarget: Delegate not bound"));
+        return;
+    }
+
+    AddSubscriber(TargetKey, FSubscriberInfo(Subscriber, MoveTemp(Delegate)));
+}
+
+void USyStateManagerSubsystem::AddSubscriber(const FSyStateTargetKey& TargetKey, FSubscriberInfo&& Info)
+{
+    UObject* Subscriber = Info.Subscriber.Get();
+    if (!TargetKey.IsValid())
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTarget: Invalid target key"));
+        return;
+    }
+    
+    if (!Subscriber)
+    {
+        UE_LOG(LogSyStateManager, Warning, TEXT("SubscribeToTarget: Null Subscriber"));
         return;
     }
+
+    // 订阅者随后读取快照或等待变化通知，目标需要已解码
+    MaterializeTarget(TargetKey);
     
-    TArray<FSubscriberInfo>& Subscribers = TargetTypeSubscribers.FindOrAdd(TargetTypeTag);
+    TArray<FSubscriberInfo>& Subscribers = TargetSubscribers.FindOrAdd(TargetKey);
     
     // 检查是否已经订阅
-    for (const FSubscriberInfo& Info : Subscribers)
+    for (const FSubscriberInfo& Existing : Subscribers)
     {
-        if (Info.Subscriber == Subscriber)
+        if (Existing.Subscriber == Subscriber)
         {
-            UE_LOG(LogSyStateManager, Verbose, TEXT("Subscriber %s already subscribed to target type: %s"), 
-                *Subscriber->GetName(), *TargetTypeTag.ToString());
+            UE_LOG(LogSyStateManager, Verbose, TEXT("Subscriber %s already subscribed to target: %s"), 
+                *Subscriber->GetName(), *TargetKey.ToString());
             return;
         }
     }
     
-    Subscribers.Add(FSubscriberInfo(Subscriber, Delegate));
+    Subscribers.Add(MoveTemp(Info));
     
-    UE_LOG(LogSyStateManager, Log, TEXT("✅ Subscriber %s subscribed to target type: %s"), 
-        *Subscriber->GetName(), *TargetTypeTag.ToString());
+    UE_LOG(LogSyStateManager, Log, TEXT("✅ Subscriber %s subscribed to target: %s"), 
+        *Subscriber->GetName(), *TargetKey.ToString());
 }
 
 void USyStateManagerSubsystem::UnsubscribeFromTargetType(FGameplayTag TargetTypeTag, UObject* Subscriber)
 {
-    if (!TargetTypeTag.IsValid() || !Subscriber)
+    UnsubscribeFromTarget(FSyStateTargetKey::FromType(TargetTypeTag), Subscriber);
+}
+
+void USyStateManagerSubsystem::UnsubscribeFromTarget(const FSyStateTargetKey& TargetKey, UObject* Subscriber)
+{
+    if (!TargetKey.IsValid() || !Subscriber)
     {
         return;
     }
     
-    TArray<FSubscriberInfo>* SubscribersPtr = TargetTypeSubscribers.Find(TargetTypeTag);
+    TArray<FSubscriberInfo>* SubscribersPtr = TargetSubscribers.Find(TargetKey);
     if (!SubscribersPtr)
     {
         return;
@@ -612,13 +2685,13 @@ void USyStateManagerSubsystem::UnsubscribeFromTargetType(FGameplayTag TargetType
     
     if (RemovedCount > 0)
     {
-        UE_LOG(LogSyStateManager, Log, TEXT("Unsubscribed %s from target type: %s"), 
-            *Subscriber->GetName(), *TargetTypeTag.ToString());
+        UE_LOG(LogSyStateManager, Log, TEXT("Unsubscribed %s from target: %s"), 
+            *Subscriber->GetName(), *TargetKey.ToString());
         
-        // 如果该目标类型没有订阅者了，移除整个条目
+        // 如果该目标没有订阅者了，移除整个条目
         if (SubscribersPtr->Num() == 0)
         {
-            TargetTypeSubscribers.Remove(TargetTypeTag);
+            TargetSubscribers.Remove(TargetKey);
         }
     }
 }
@@ -631,9 +2704,9 @@ void USyStateManagerSubsystem::UnsubscribeAll(UObject* Subscriber)
     }
     
     int32 TotalRemovedCount = 0;
-    TArray<FGameplayTag> EmptyTags;
+    TArray<FSyStateTargetKey> EmptyKeys;
     
-    for (auto& Pair : TargetTypeSubscribers)
+    for (auto& Pair : TargetSubscribers)
     {
         int32 RemovedCount = Pair.Value.RemoveAll([Subscriber](const FSubscriberInfo& Info)
         {
@@ -644,14 +2717,14 @@ void USyStateManagerSubsystem::UnsubscribeAll(UObject* Subscriber)
         
         if (Pair.Value.Num() == 0)
         {
-            EmptyTags.Add(Pair.Key);
+            EmptyKeys.Add(Pair.Key);
         }
     }
     
     // 移除空的订阅列表
-    for (const FGameplayTag& Tag : EmptyTags)
+    for (const FSyStateTargetKey& Key : EmptyKeys)
     {
-        TargetTypeSubscribers.Remove(Tag);
+        TargetSubscribers.Remove(Key);
     }
     
     if (TotalRemovedCount > 0)
@@ -661,15 +2734,15 @@ void USyStateManagerSubsystem::UnsubscribeAll(UObject* Subscriber)
     }
 }
 
-void USyStateManagerSubsystem::BroadcastToSubscribers(const FSyStateModificationRecord& Record)
+void USyStateManagerSubsystem::BroadcastToSubscribers(const FSyTargetStateChange& Change)
 {
-    const FGameplayTag& TargetTag = Record.Operation.Target.TargetTypeTag;
-    if (!TargetTag.IsValid())
+    const FSyStateTargetKey& TargetKey = Change.Target;
+    if (!TargetKey.IsValid())
     {
         return;
     }
     
-    TArray<FSubscriberInfo>* SubscribersPtr = TargetTypeSubscribers.Find(TargetTag);
+    TArray<FSubscriberInfo>* SubscribersPtr = TargetSubscribers.Find(TargetKey);
     if (!SubscribersPtr || SubscribersPtr->Num() == 0)
     {
         return;
@@ -683,31 +2756,42 @@ void USyStateManagerSubsystem::BroadcastToSubscribers(const FSyStateModification
     
     if (InvalidCount > 0)
     {
-        UE_LOG(LogSyStateManager, Verbose, TEXT("Cleaned up %d invalid subscribers for target type: %s"), 
-            InvalidCount, *TargetTag.ToString());
+        UE_LOG(LogSyStateManager, Verbose, TEXT("Cleaned up %d invalid subscribers for target: %s"), 
+            InvalidCount, *TargetKey.ToString());
     }
     
-    // 广播给有效的订阅者
+    // 广播给有效的订阅者（拷贝列表：回调中可能增删订阅）
+    const TArray<FSubscriberInfo> Subscribers = *SubscribersPtr;
     int32 BroadcastCount = 0;
-    for (const FSubscriberInfo& Info : *SubscribersPtr)
+    for (const FSubscriberInfo& Info : Subscribers)
     {
-        if (Info.IsValid() && Info.Delegate.IsBound())
+        if (!Info.Subscriber.IsValid())
+        {
+            continue;
+        }
+
+        if (Info.ChangeDelegate.IsBound())
+        {
+            Info.ChangeDelegate.Execute(Change);
+            BroadcastCount++;
+        }
+        else if (Info.Delegate.IsBound())
         {
-            Info.Delegate.Execute(Record);
+            Info.Delegate.Execute(Change.LastRecord);
             BroadcastCount++;
         }
     }
     
-    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("📢 Broadcasted to %d subscribers for target type: %s"), 
-        BroadcastCount, *TargetTag.ToString());
+    UE_LOG(LogSyStateManager, VeryVerbose, TEXT("📢 Broadcasted to %d subscribers for target: %s"), 
+        BroadcastCount, *TargetKey.ToString());
 }
 
 void USyStateManagerSubsystem::CleanupInvalidSubscribers()
 {
     int32 TotalCleaned = 0;
-    TArray<FGameplayTag> EmptyTags;
+    TArray<FSyStateTargetKey> EmptyKeys;
     
-    for (auto& Pair : TargetTypeSubscribers)
+    for (auto& Pair : TargetSubscribers)
     {
         int32 CleanedCount = Pair.Value.RemoveAll([](const FSubscriberInfo& Info)
         {
@@ -718,13 +2802,13 @@ void USyStateManagerSubsystem::CleanupInvalidSubscribers()
         
         if (Pair.Value.Num() == 0)
         {
-            EmptyTags.Add(Pair.Key);
+            EmptyKeys.Add(Pair.Key);
         }
     }
     
-    for (const FGameplayTag& Tag : EmptyTags)
+    for (const FSyStateTargetKey& Key : EmptyKeys)
     {
-        TargetTypeSubscribers.Remove(Tag);
+        TargetSubscribers.Remove(Key);
     }
     
     if (TotalCleaned > 0)
@@ -0,0 +1,290 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "State/SyStateUpdateSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "Async/ParallelFor.h"
+#include "Logging/LogMacros.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSyStateUpdate, Log, All);
+
+void USyStateUpdateSubsystem::Deinitialize()
+{
+    UnregisterTickFunction();
+    Entries.Empty();
+    EntryIndices.Empty();
+    PendingIndices.Empty();
+    DeferredRegistrations.Empty();
+    NumRemovedEntries = 0;
+
+    Super::Deinitialize();
+}
+
+void USyStateUpdateSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    RegisterTickFunction(InWorld);
+}
+
+bool USyStateUpdateSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USyStateUpdateSubsystem::RegisterComponent(USyStateComponent* Component)
+{
+    if (!Component || EntryIndices.Contains(Component))
+    {
+        return;
+    }
+
+    if (bIsUpdating)
+    {
+        // 批量处理中（例如在变化事件回调里生成实体）：Entries 扩容会使正在使用的条目引用失效，处理结束后再加入
+        DeferredRegistrations.AddUnique(Component);
+        return;
+    }
+    AddEntry(Component);
+}
+
+void USyStateUpdateSubsystem::UnregisterComponent(USyStateComponent* Component)
+{
+    if (DeferredRegistrations.RemoveSingleSwap(Component, EAllowShrinking::No) > 0)
+    {
+        return;
+    }
+
+    int32 EntryIndex = INDEX_NONE;
+    if (!EntryIndices.RemoveAndCopyValue(Component, EntryIndex))
+    {
+        return;
+    }
+
+    if (bIsUpdating)
+    {
+        // 批量处理中（例如在变化事件回调里销毁实体）：先置空，处理结束后再移除
+        Entries[EntryIndex].Component.Reset();
+        ++NumRemovedEntries;
+        return;
+    }
+    RemoveEntryAt(EntryIndex);
+}
+
+bool USyStateUpdateSubsystem::RequestUpdate(USyStateComponent* Component)
+{
+    const int32* EntryIndex = EntryIndices.Find(Component);
+    if (!EntryIndex || !UpdateTickFunction.IsTickFunctionRegistered())
+    {
+        return false;
+    }
+
+    FEntry& Entry = Entries[*EntryIndex];
+    if (!Entry.bPending)
+    {
+        Entry.bPending = true;
+        PendingIndices.Add(*EntryIndex);
+    }
+    return true;
+}
+
+void USyStateUpdateSubsystem::FlushPendingUpdates()
+{
+    if (bIsUpdating || PendingIndices.Num() == 0)
+    {
+        return;
+    }
+
+    // 处理期间 Entries 不增不减（注册 / 注销均延后），条目下标与引用保持有效
+    bIsUpdating = true;
+
+    // 先移出待处理列表：事件回调中产生的新请求留到下一次处理
+    TArray<int32> Batch = MoveTemp(PendingIndices);
+    PendingIndices.Reset();
+
+    // 1. 游戏线程：取快照并比较差异
+    TArray<int32> ParallelBatch;
+    TArray<int32> GameThreadBatch;
+    for (const int32 EntryIndex : Batch)
+    {
+        FEntry& Entry = Entries[EntryIndex];
+        Entry.bPending = false;
+        Entry.bHasChange = false;
+
+        USyStateComponent* Component = Entry.Component.Get();
+        if (!Component)
+        {
+            // 组件未经注销即被销毁：处理结束后移除
+            if (EntryIndices.Remove(Entry.Key) > 0)
+            {
+                ++NumRemovedEntries;
+            }
+            continue;
+        }
+        if (!Component->PrepareSnapshotSync(Entry.Request))
+        {
+            continue;
+        }
+        (Component->CanApplySnapshotSyncInParallel() ? ParallelBatch : GameThreadBatch).Add(EntryIndex);
+    }
+
+    // 2. 应用差异、重算有效状态并取出变化：每个实体只访问自己的分层容器（组件在第 1 步已确认有效）
+    auto ApplyEntry = [this](int32 EntryIndex)
+    {
+        FEntry& Entry = Entries[EntryIndex];
+        USyStateComponent* Component = Entry.Component.GetEvenIfUnreachable();
+        Component->ApplySnapshotSync(Entry.Request);
+        Entry.bHasChange = Component->ConsumeEffectiveStateChange(Entry.Change);
+    };
+
+    ParallelFor(ParallelBatch.Num(), [&ParallelBatch, &ApplyEntry](int32 BatchIndex)
+    {
+        ApplyEntry(ParallelBatch[BatchIndex]);
+    }, ParallelBatch.Num() < MinParallelBatchSize ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+    for (const int32 EntryIndex : GameThreadBatch)
+    {
+        ApplyEntry(EntryIndex);
+    }
+
+    // 3. 游戏线程：派发变化事件（回调中可能注销其它实体，已注销的条目被置空）
+    // 回调执行期间不持有条目引用：变化先移到局部变量，回调结束后按下标重新取条目
+    for (TArray<int32>* ProcessedBatch : { &ParallelBatch, &GameThreadBatch })
+    {
+        for (const int32 EntryIndex : *ProcessedBatch)
+        {
+            FSyEffectiveStateChange Change;
+            USyStateComponent* Component = nullptr;
+            {
+                FEntry& Entry = Entries[EntryIndex];
+                Entry.Request.Reset();
+                if (Entry.bHasChange)
+                {
+                    Change = MoveTemp(Entry.Change);
+                    Component = Entry.Component.Get();
+                }
+                Entry.Change = FSyEffectiveStateChange();
+                Entry.bHasChange = false;
+            }
+
+            if (Component)
+            {
+                Component->DispatchEffectiveStateChange(Change);
+            }
+        }
+    }
+
+    UE_LOG(LogSyStateUpdate, VeryVerbose, TEXT("Batched state update: %d requested, %d applied in parallel, %d on game thread."),
+        Batch.Num(), ParallelBatch.Num(), GameThreadBatch.Num());
+
+    bIsUpdating = false;
+    RemoveUnregisteredEntries();
+
+    // 批量处理中注册的组件
+    TArray<TWeakObjectPtr<USyStateComponent>> Registrations = MoveTemp(DeferredRegistrations);
+    DeferredRegistrations.Reset();
+    for (const TWeakObjectPtr<USyStateComponent>& Component : Registrations)
+    {
+        if (USyStateComponent* ComponentPtr = Component.Get())
+        {
+            RegisterComponent(ComponentPtr);
+        }
+    }
+}
+
+void USyStateUpdateSubsystem::RegisterTickFunction(UWorld& InWorld)
+{
+    if (UpdateTickFunction.IsTickFunctionRegistered() || !InWorld.PersistentLevel)
+    {
+        return;
+    }
+
+    // 晚于 StateManager 的派发 Tick（默认 TG_PostUpdateWork），同一帧内完成同步
+    UpdateTickFunction.Owner = this;
+    UpdateTickFunction.bCanEverTick = true;
+    UpdateTickFunction.bStartWithTickEnabled = true;
+    UpdateTickFunction.bTickEvenWhenPaused = true;
+    UpdateTickFunction.TickGroup = TG_LastDemotable;
+    UpdateTickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+}
+
+void USyStateUpdateSubsystem::UnregisterTickFunction()
+{
+    if (UpdateTickFunction.IsTickFunctionRegistered())
+    {
+        UpdateTickFunction.UnRegisterTickFunction();
+    }
+}
+
+void USyStateUpdateSubsystem::AddEntry(USyStateComponent* Component)
+{
+    check(!bIsUpdating);
+
+    const int32 EntryIndex = Entries.AddDefaulted();
+    Entries[EntryIndex].Component = Component;
+    Entries[EntryIndex].Key = Component;
+    EntryIndices.Add(Component, EntryIndex);
+}
+
+void USyStateUpdateSubsystem::RemoveEntryAt(int32 EntryIndex)
+{
+    if (Entries[EntryIndex].bPending)
+    {
+        PendingIndices.RemoveSingleSwap(EntryIndex, EAllowShrinking::No);
+    }
+
+    const int32 LastIndex = Entries.Num() - 1;
+    Entries.RemoveAtSwap(EntryIndex, 1, EAllowShrinking::No);
+    if (EntryIndex == LastIndex)
+    {
+        return;
+    }
+
+    // 末尾条目被移到 EntryIndex
+    FEntry& MovedEntry = Entries[EntryIndex];
+    if (int32* MovedIndex = EntryIndices.Find(MovedEntry.Key))
+    {
+        *MovedIndex = EntryIndex;
+    }
+    if (MovedEntry.bPending)
+    {
+        PendingIndices[PendingIndices.IndexOfByKey(LastIndex)] = EntryIndex;
+    }
+}
+
+void USyStateUpdateSubsystem::RemoveUnregisteredEntries()
+{
+    if (NumRemovedEntries == 0)
+    {
+        return;
+    }
+
+    // 从后向前：被交换过来的末尾条目已检查过
+    for (int32 EntryIndex = Entries.Num() - 1; EntryIndex >= 0; --EntryIndex)
+    {
+        FEntry& Entry = Entries[EntryIndex];
+        if (!Entry.Component.IsValid())
+        {
+            EntryIndices.Remove(Entry.Key);
+            RemoveEntryAt(EntryIndex);
+        }
+    }
+    NumRemovedEntries = 0;
+}
+
+void FSyStateUpdateTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+    if (Owner)
+    {
+        Owner->FlushPendingUpdates();
+    }
+}
+
+FString FSyStateUpdateTickFunction::DiagnosticMessage()
+{
+    return TEXT("FSyStateUpdateTickFunction");
+}
+
+FName FSyStateUpdateTickFunction::DiagnosticContext(bool bDetailed)
+{
+    return FName(TEXT("SyStateUpdate"));
+}
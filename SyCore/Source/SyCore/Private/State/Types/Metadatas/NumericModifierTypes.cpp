@@ -0,0 +1,266 @@
+#include "State/Types/Metadatas/NumericModifierTypes.h"
+#include "State/Types/Metadatas/BasicMetadataValueTypes.h"
+#include "Math/VectorRegister.h"
+
+namespace SyNumericModifier
+{
+    enum class EReduceOp : uint8
+    {
+        Sum,
+        Product,
+        Min,
+        Max
+    };
+
+    template<EReduceOp Op>
+    FORCEINLINE float CombineScalar(float A, float B)
+    {
+        if constexpr (Op == EReduceOp::Sum) { return A + B; }
+        else if constexpr (Op == EReduceOp::Product) { return A * B; }
+        else if constexpr (Op == EReduceOp::Min) { return FMath::Min(A, B); }
+        else { return FMath::Max(A, B); }
+    }
+
+    template<EReduceOp Op>
+    FORCEINLINE VectorRegister4Float CombineVector(const VectorRegister4Float& A, const VectorRegister4Float& B)
+    {
+        if constexpr (Op == EReduceOp::Sum) { return VectorAdd(A, B); }
+        else if constexpr (Op == EReduceOp::Product) { return VectorMultiply(A, B); }
+        else if constexpr (Op == EReduceOp::Min) { return VectorMin(A, B); }
+        else { return VectorMax(A, B); }
+    }
+
+    /** 对连续的 float 通道做归约：4 路向量累加，剩余元素标量处理 */
+    template<EReduceOp Op>
+    float Reduce(const TArray<float>& Values, float Identity)
+    {
+        const float* Data = Values.GetData();
+        const int32 Num = Values.Num();
+        int32 Index = 0;
+        float Result = Identity;
+
+        if (Num >= 4)
+        {
+            VectorRegister4Float Accumulator = VectorLoad(Data);
+            for (Index = 4; Index + 4 <= Num; Index += 4)
+            {
+                Accumulator = CombineVector<Op>(Accumulator, VectorLoad(Data + Index));
+            }
+
+            alignas(16) float Lanes[4];
+            VectorStoreAligned(Accumulator, Lanes);
+            Result = CombineScalar<Op>(CombineScalar<Op>(Lanes[0], Lanes[1]), CombineScalar<Op>(Lanes[2], Lanes[3]));
+        }
+
+        for (; Index < Num; ++Index)
+        {
+            Result = CombineScalar<Op>(Result, Data[Index]);
+        }
+        return Result;
+    }
+
+    /** 读取 FSyFloatValue / FSyIntValue 的数值 */
+    bool ReadNumericValue(const FInstancedStruct& Param, ESyNumericValueType& OutValueType, float& OutValue)
+    {
+        const UScriptStruct* StructType = Param.GetScriptStruct();
+        if (StructType == FSyFloatValue::StaticStruct())
+        {
+            OutValueType = ESyNumericValueType::Float;
+            OutValue = Param.Get<FSyFloatValue>().Value;
+            return true;
+        }
+        if (StructType == FSyIntValue::StaticStruct())
+        {
+            OutValueType = ESyNumericValueType::Int;
+            OutValue = static_cast<float>(Param.Get<FSyIntValue>().Value);
+            return true;
+        }
+        return false;
+    }
+
+    int32 FindStackIndex(const TArray<FInstancedStruct>& Params, ESyNumericValueType ValueType)
+    {
+        return Params.IndexOfByPredicate([ValueType](const FInstancedStruct& Param)
+        {
+            return Param.GetScriptStruct() == FSyNumericModifierStack::StaticStruct()
+                && Param.Get<FSyNumericModifierStack>().ValueType == ValueType;
+        });
+    }
+
+    /** 查找或创建修饰栈；新建时以已有的数值（覆盖写入的值）作为基础值 */
+    int32 FindOrAddStackIndex(TArray<FInstancedStruct>& Params, ESyNumericValueType ValueType)
+    {
+        const int32 ExistingIndex = FindStackIndex(Params, ValueType);
+        if (ExistingIndex != INDEX_NONE)
+        {
+            return ExistingIndex;
+        }
+
+        FSyNumericModifierStack NewStack;
+        NewStack.ValueType = ValueType;
+        const UScriptStruct* ValueStruct = NewStack.GetValueStruct();
+        if (const FInstancedStruct* ExistingValue = Params.FindByPredicate([ValueStruct](const FInstancedStruct& Param) { return Param.GetScriptStruct() == ValueStruct; }))
+        {
+            ESyNumericValueType ExistingType;
+            float ExistingNumber = 0.0f;
+            if (ReadNumericValue(*ExistingValue, ExistingType, ExistingNumber))
+            {
+                NewStack.SetBase(ExistingNumber);
+            }
+        }
+        return Params.Add(FInstancedStruct::Make(NewStack));
+    }
+
+    /** 把修饰栈的求值结果写为对应的数值参数（替换已有的同类型数值） */
+    void WriteResolvedValue(TArray<FInstancedStruct>& Params, int32 StackIndex, float FallbackBase = 0.0f)
+    {
+        const FSyNumericModifierStack& Stack = Params[StackIndex].Get<FSyNumericModifierStack>();
+        const float Result = Stack.Evaluate(FallbackBase);
+        const UScriptStruct* ValueStruct = Stack.GetValueStruct();
+
+        FInstancedStruct ResolvedValue = Stack.ValueType == ESyNumericValueType::Int
+            ? FInstancedStruct::Make(FSyIntValue(FMath::RoundToInt(Result)))
+            : FInstancedStruct::Make(FSyFloatValue(Result));
+
+        if (FInstancedStruct* ExistingValue = Params.FindByPredicate([ValueStruct](const FInstancedStruct& Param) { return Param.GetScriptStruct() == ValueStruct; }))
+        {
+            *ExistingValue = MoveTemp(ResolvedValue);
+        }
+        else
+        {
+            Params.Add(MoveTemp(ResolvedValue));
+        }
+    }
+}
+
+void FSyNumericModifierStack::AddModifier(const FSyNumericModifier& Modifier)
+{
+    switch (Modifier.Op)
+    {
+    case ESyModifierOp::Override: SetBase(Modifier.Value); break;
+    case ESyModifierOp::Add:      Addends.Add(Modifier.Value); break;
+    case ESyModifierOp::Multiply: Multipliers.Add(Modifier.Value); break;
+    case ESyModifierOp::Min:      UpperBounds.Add(Modifier.Value); break;
+    case ESyModifierOp::Max:      LowerBounds.Add(Modifier.Value); break;
+    case ESyModifierOp::Clamp:
+        LowerBounds.Add(Modifier.Value);
+        UpperBounds.Add(Modifier.ClampMax);
+        break;
+    }
+}
+
+void FSyNumericModifierStack::Append(const FSyNumericModifierStack& Other)
+{
+    if (Other.bHasBase)
+    {
+        SetBase(Other.BaseValue);
+    }
+    Addends.Append(Other.Addends);
+    Multipliers.Append(Other.Multipliers);
+    LowerBounds.Append(Other.LowerBounds);
+    UpperBounds.Append(Other.UpperBounds);
+}
+
+float FSyNumericModifierStack::Evaluate(float FallbackBase) const
+{
+    using namespace SyNumericModifier;
+
+    const float Base = bHasBase ? BaseValue : FallbackBase;
+    float Result = (Base + Reduce<EReduceOp::Sum>(Addends, 0.0f)) * Reduce<EReduceOp::Product>(Multipliers, 1.0f);
+    if (LowerBounds.Num() > 0)
+    {
+        Result = FMath::Max(Result, Reduce<EReduceOp::Max>(LowerBounds, -MAX_FLT));
+    }
+    if (UpperBounds.Num() > 0)
+    {
+        Result = FMath::Min(Result, Reduce<EReduceOp::Min>(UpperBounds, MAX_FLT));
+    }
+    return Result;
+}
+
+const UScriptStruct* FSyNumericModifierStack::GetValueStruct(ESyNumericValueType InValueType)
+{
+    return InValueType == ESyNumericValueType::Int ? FSyIntValue::StaticStruct() : FSyFloatValue::StaticStruct();
+}
+
+bool FSyNumericModifierStack::MergeParam(TArray<FInstancedStruct>& ExistingParams, const FInstancedStruct& SourceStruct, const TArray<FInstancedStruct>& SourceParams)
+{
+    using namespace SyNumericModifier;
+
+    const UScriptStruct* StructType = SourceStruct.GetScriptStruct();
+    if (StructType == FSyNumericModifier::StaticStruct())
+    {
+        const FSyNumericModifier& Modifier = SourceStruct.Get<FSyNumericModifier>();
+        const int32 StackIndex = FindOrAddStackIndex(ExistingParams, Modifier.ValueType);
+        ExistingParams[StackIndex].GetMutable<FSyNumericModifierStack>().AddModifier(Modifier);
+        WriteResolvedValue(ExistingParams, StackIndex);
+        return true;
+    }
+
+    if (StructType == FSyNumericModifierStack::StaticStruct())
+    {
+        const FSyNumericModifierStack& OtherStack = SourceStruct.Get<FSyNumericModifierStack>();
+        const int32 StackIndex = FindOrAddStackIndex(ExistingParams, OtherStack.ValueType);
+        ExistingParams[StackIndex].GetMutable<FSyNumericModifierStack>().Append(OtherStack);
+        WriteResolvedValue(ExistingParams, StackIndex);
+        return true;
+    }
+
+    ESyNumericValueType ValueType;
+    float Number = 0.0f;
+    if (!ReadNumericValue(SourceStruct, ValueType, Number))
+    {
+        return false;
+    }
+
+    // 来源中有同类型的修饰栈：该数值只是其求值输出，基础值已由修饰栈携带
+    if (FindStackIndex(SourceParams, ValueType) != INDEX_NONE)
+    {
+        return true;
+    }
+
+    // 覆盖写入的数值：已有修饰栈时作为其基础值
+    const int32 StackIndex = FindStackIndex(ExistingParams, ValueType);
+    if (StackIndex == INDEX_NONE)
+    {
+        return false;
+    }
+    ExistingParams[StackIndex].GetMutable<FSyNumericModifierStack>().SetBase(Number);
+    WriteResolvedValue(ExistingParams, StackIndex);
+    return true;
+}
+
+bool FSyNumericModifierStack::HasUnbasedStack(const TArray<FInstancedStruct>& Params)
+{
+    return Params.ContainsByPredicate([](const FInstancedStruct& Param)
+    {
+        return Param.GetScriptStruct() == FSyNumericModifierStack::StaticStruct()
+            && !Param.Get<FSyNumericModifierStack>().bHasBase;
+    });
+}
+
+void FSyNumericModifierStack::ResolveWithFallback(TArray<FInstancedStruct>& Params, const TArray<FInstancedStruct>& FallbackValues)
+{
+    using namespace SyNumericModifier;
+
+    for (int32 StackIndex = 0; StackIndex < Params.Num(); ++StackIndex)
+    {
+        if (Params[StackIndex].GetScriptStruct() != FSyNumericModifierStack::StaticStruct()
+            || Params[StackIndex].Get<FSyNumericModifierStack>().bHasBase)
+        {
+            continue;
+        }
+
+        const ESyNumericValueType StackValueType = Params[StackIndex].Get<FSyNumericModifierStack>().ValueType;
+        for (const FInstancedStruct& FallbackValue : FallbackValues)
+        {
+            ESyNumericValueType ValueType;
+            float FallbackBase = 0.0f;
+            if (ReadNumericValue(FallbackValue, ValueType, FallbackBase) && ValueType == StackValueType)
+            {
+                WriteResolvedValue(Params, StackIndex, FallbackBase);
+                break;
+            }
+        }
+    }
+}
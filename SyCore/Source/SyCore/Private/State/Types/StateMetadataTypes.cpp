@@ -18,6 +18,17 @@ void USyStateMetadataBase::ApplyModification(const FInstancedStruct& Modificatio
     ValidateAndProcessParams(ModificationParams, TEXT("ApplyModification"));
 }
 
+void USyStateMetadataBase::ResetForReuse()
+{
+    StateTag = FGameplayTag::EmptyTag;
+
+    const FInstancedStruct DefaultValue = GetClass()->GetDefaultObject<USyStateMetadataBase>()->GetValueStruct();
+    if (DefaultValue.IsValid())
+    {
+        SetValueStruct(DefaultValue);
+    }
+}
+
 void USyStateMetadataBase::SetValueStruct_Implementation(const FInstancedStruct& InValue)
 {
     if (InValue.IsValid() && InValue.GetScriptStruct() == GetValueDataType())
@@ -1,6 +1,5 @@
 #include "State/Types/StateParameterTypes.h"
-#include "DS_TagMetadata.h"
-#include "State/Types/StateMetadataTypes.h"
+#include "State/StateTagSchema.h"
 
 /**
  * PostSerialize - 序列化后处理
@@ -34,26 +33,11 @@ void FSyStateParams::PostSerialize(const FArchive& Ar)
 		return;
 	}
 
-	// 获取 Tag 的元数据
-	TArray<UO_TagMetadata*> AllMetadata = UDS_TagMetadata::GetTagMetadata(Tag);
-	if (AllMetadata.Num() == 0)
-	{
-		ClearParams();
-		return;
-	}
-
-	// 过滤出 StateMetadata
-	TArray<USyStateMetadataBase*> StateMetadataList;
-	for (UO_TagMetadata* Metadata : AllMetadata)
-	{
-		if (USyStateMetadataBase* StateMetadata = Cast<USyStateMetadataBase>(Metadata))
-		{
-			StateMetadataList.Add(StateMetadata);
-		}
-	}
+	// 获取 Tag 的元数据结构描述
+	const TSharedRef<const FSyStateTagSchema> Schema = FSyStateTagSchemaCache::Get().FindOrBuild(Tag);
 
 	// 如果没有 StateMetadata，清空参数数组
-	if (StateMetadataList.Num() == 0)
+	if (Schema->Slots.Num() == 0)
 	{
 		ClearParams();
 		return;
@@ -61,14 +45,14 @@ void FSyStateParams::PostSerialize(const FArchive& Ar)
 
 	// 更新参数数组
 	TArray<FInstancedStruct> NewParams;
-	NewParams.Reserve(StateMetadataList.Num());
+	NewParams.Reserve(Schema->Slots.Num());
 
-	for (USyStateMetadataBase* StateMetadata : StateMetadataList)
+	for (const FSyStateTagSchema::FSlot& Slot : Schema->Slots)
 	{
-		if (StateMetadata && StateMetadata->GetValueDataType())
+		if (Slot.ValueType)
 		{
 			FInstancedStruct NewInstance;
-			NewInstance.InitializeAs(StateMetadata->GetValueDataType());
+			NewInstance.InitializeAs(Slot.ValueType);
 			if (NewInstance.IsValid())
 			{
 				NewParams.Add(NewInstance);
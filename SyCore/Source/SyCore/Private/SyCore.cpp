@@ -1,18 +1,27 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SyCore.h"
+#include "State/StateTagSchema.h"
+#include "State/StateMetadataPool.h"
+#include "State/StateSharedLayer.h"
 
 #define LOCTEXT_NAMESPACE "FSyCoreModule"
 
 void FSyCoreModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	FSyStateTagSchemaCache::Initialize();
+	FSyStateMetadataPool::Initialize();
+	FSySharedStateLayerCache::Initialize();
 }
 
 void FSyCoreModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FSySharedStateLayerCache::Shutdown();
+	FSyStateMetadataPool::Shutdown();
+	FSyStateTagSchemaCache::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
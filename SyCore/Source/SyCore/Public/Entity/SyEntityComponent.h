@@ -10,6 +10,7 @@
 class USyIdentityComponent;
 class USyMessageComponent;
 class USyStateComponent;
+struct FSyEffectiveStateChange;
 
 /**
  * SyEntityComponent - 实体核心组件
@@ -170,7 +171,7 @@ private:
     void UnregisterFromRegistry();
     void BindComponentDelegates(); // 绑定所有组件的委托
     
-    void HandleLocalStateDataChanged(); // StateComponent 内部事件处理
+    void HandleLocalStateDataChanged(const FSyEffectiveStateChange& Change); // StateComponent 内部事件处理
     void HandleEntityIdReady(); // IdentityComponent ID生成事件处理
     
     /** 按阶段顺序初始化所有 Sy 组件 */
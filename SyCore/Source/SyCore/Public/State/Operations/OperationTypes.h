@@ -145,6 +145,51 @@ struct SYCORE_API FSyOperationModifier
     }
 };
 
+/**
+ * ESyOperationExpiryClock - 操作有效期的计时方式
+ */
+UENUM(BlueprintType)
+enum class ESyOperationExpiryClock : uint8
+{
+    /** 永久有效，直到被显式卸载 */
+    None        UMETA(DisplayName = "Never Expires"),
+
+    /** 游戏时间：暂停时停止计时，受时间膨胀影响；游戏时钟随存档保存，读档后继续计算剩余时间 */
+    GameTime    UMETA(DisplayName = "Game Time"),
+
+    /** 现实时间：从记录时间戳（UTC）起计时，跨存档保持 */
+    RealTime    UMETA(DisplayName = "Real Time"),
+};
+
+/**
+ * FSyOperationExpiry - 操作有效期
+ *
+ * 设置后，StateManager 在有效期结束时自动卸载该操作（例如 "商店关闭 10 分钟"）。
+ */
+USTRUCT(BlueprintType)
+struct SYCORE_API FSyOperationExpiry
+{
+    GENERATED_BODY()
+
+    /** 默认构造函数（永久有效） */
+    FSyOperationExpiry() = default;
+
+    /** 从计时方式和时长构造 */
+    FSyOperationExpiry(ESyOperationExpiryClock InClock, float InDurationSeconds)
+        : Clock(InClock), DurationSeconds(InDurationSeconds) {}
+
+    /** 计时方式 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SyOperation|Expiry")
+    ESyOperationExpiryClock Clock = ESyOperationExpiryClock::None;
+
+    /** 有效时长（秒） */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SyOperation|Expiry", meta = (ClampMin = "0", Units = "s", EditCondition = "Clock != ESyOperationExpiryClock::None"))
+    float DurationSeconds = 0.0f;
+
+    /** 是否设置了有效期 */
+    bool IsSet() const { return Clock != ESyOperationExpiryClock::None; }
+};
+
 /**
  * FSyOperation - 操作
  * 
@@ -180,4 +225,8 @@ struct SYCORE_API FSyOperation
     /** 操作ID */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SyOperation")
     FGuid OperationId;
+
+    /** 可选的有效期，到期后由 StateManager 自动卸载 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SyOperation")
+    FSyOperationExpiry Expiry;
 };
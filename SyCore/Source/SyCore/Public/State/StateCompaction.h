@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "StructUtils/InstancedStruct.h"
+#include "State/Operations/OperationTypes.h"
+#include "StateCompaction.generated.h"
+
+/**
+ * @brief 检查点中的单个折叠值
+ * 被后续记录覆盖的参数值连同其贡献者移入检查点，检查点按时间顺序存放：
+ * 同一 (状态标签, 参数类型) 可以有多个贡献者的值，聚合时较新的覆盖较早的。
+ * 覆盖它的记录被卸载时，聚合结果回退到仍存在的最新贡献者的值。
+ */
+USTRUCT(BlueprintType)
+struct SYCORE_API FSyStateCheckpointEntry
+{
+    GENERATED_BODY()
+
+    /** 状态标签 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Checkpoint")
+    FGameplayTag StateTag;
+
+    /** 折叠后的参数值（非列表类型） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Checkpoint")
+    FInstancedStruct Value;
+
+    /** 提供此值的操作ID，卸载该操作时此值一并移除 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Checkpoint")
+    FGuid ContributorOperationId;
+
+    FSyStateCheckpointEntry() = default;
+
+    FSyStateCheckpointEntry(const FGameplayTag& InStateTag, FInstancedStruct&& InValue, const FGuid& InContributorOperationId)
+        : StateTag(InStateTag)
+        , Value(MoveTemp(InValue))
+        , ContributorOperationId(InContributorOperationId)
+    {}
+};
+
+/**
+ * @brief 单个目标的检查点（用于存档）
+ */
+USTRUCT()
+struct SYCORE_API FSyStateTargetCheckpoint
+{
+    GENERATED_BODY()
+
+    /** 检查点所属目标（只使用路由相关字段） */
+    UPROPERTY(VisibleAnywhere, Category="Checkpoint")
+    FSyOperationTarget Target;
+
+    /** 折叠值 */
+    UPROPERTY(VisibleAnywhere, Category="Checkpoint")
+    TArray<FSyStateCheckpointEntry> Entries;
+};
+
+/**
+ * @brief 一次日志压缩的统计结果
+ */
+USTRUCT(BlueprintType)
+struct SYCORE_API FSyStateCompactionStats
+{
+    GENERATED_BODY()
+
+    /** 处理的目标数量 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    int32 TargetsProcessed = 0;
+
+    /** 检查的记录数量 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    int32 RecordsScanned = 0;
+
+    /** 至少有一个参数被折叠的记录数量 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    int32 RecordsCompacted = 0;
+
+    /** 参数被全部折叠、只保留存根（仍可按操作ID / 来源卸载）的记录数量 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    int32 RecordsFolded = 0;
+
+    /** 被折叠的参数值数量 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    int32 ValuesFolded = 0;
+
+    /** 估算回收的内存（字节，已扣除检查点增长） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    int64 BytesReclaimed = 0;
+
+    /** 累计耗时（毫秒，增量压缩为各帧耗时之和） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Compaction")
+    double DurationMs = 0.0;
+};
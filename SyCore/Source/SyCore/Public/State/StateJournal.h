@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "State/StateModificationRecord.h"
+
+/**
+ * FSyStateJournal - StateManager 操作日志的追加式二进制日志文件（预写日志）
+ *
+ * 记录 / 卸载发生时把条目序列化到内存缓冲，Flush 时只把缓冲追加到文件末尾，
+ * 存档代价与上次写入后的增量成正比。完整状态由快照（SaveGame 槽位）保存，
+ * 写入快照后调用 Reset 清空日志文件。
+ *
+ * 文件格式：
+ *   Header: uint32 Magic, uint32 Version
+ *   Entry:  uint8 Type, int32 PayloadSize, uint8[PayloadSize] Payload, uint32 Crc32(Payload)
+ * 回放遇到不完整或校验失败的条目时停止（崩溃时最后一条可能只写了一半）。
+ */
+class SYCORE_API FSyStateJournal
+{
+public:
+	enum class EEntryType : uint8
+	{
+		/** 新增记录，载荷为完整的 FSyStateModificationRecord */
+		Record = 1,
+
+		/** 卸载操作，载荷为 OperationId */
+		Unload = 2,
+	};
+
+	explicit FSyStateJournal(const FString& InFilePath);
+
+	/** 追加一条新增记录到缓冲 */
+	void AppendRecord(const FSyStateModificationRecord& Record);
+
+	/** 追加一条卸载到缓冲 */
+	void AppendUnload(const FGuid& OperationId);
+
+	/** 缓冲中尚未写入文件的条目数量 */
+	int32 GetNumPendingEntries() const { return NumPendingEntries; }
+
+	/** 缓冲中尚未写入文件的字节数 */
+	int32 GetNumPendingBytes() const { return PendingBytes.Num(); }
+
+	/**
+	 * @brief 把缓冲的条目追加写入文件（文件不存在时先写文件头）
+	 * @return 写入成功返回 true；失败时缓冲保留，下次 Flush 重试
+	 */
+	bool Flush();
+
+	/** 丢弃缓冲中尚未写入的条目 */
+	void DiscardPending();
+
+	/**
+	 * @brief 删除日志文件并丢弃缓冲（已把完整状态写入快照后调用）
+	 * @return 删除成功（或文件本不存在）返回 true
+	 */
+	bool Reset();
+
+	/** 日志文件当前大小（字节），文件不存在时为 0 */
+	int64 GetFileSize() const;
+
+	/**
+	 * @brief 截掉日志文件末尾无法回放的部分（Replay 遇到不完整或校验失败的条目后调用）
+	 * @param ValidSize 保留的字节数（Replay 输出的 OutValidSize）
+	 * @return 截断成功（或无需截断）返回 true
+	 * @note 不截断时之后 Flush 追加的条目都排在损坏数据之后，下次回放无法读到。
+	 */
+	bool TruncateTo(int64 ValidSize);
+
+	/**
+	 * @brief 读取日志文件并按顺序回放到记录数组上
+	 * @param InOutLog 快照中加载的记录（输入），回放后的记录（输出，保持时间顺序）
+	 * @param OutNumApplied 实际生效的条目数量
+	 * @param OutUnloadedOperationIds 回放中卸载的全部 OperationId（包括快照中找不到的），
+	 *        调用方据此清理这些操作在检查点等记录之外的数据
+	 * @param OutValidSize 最后一个完整条目之后的文件偏移；小于文件大小时说明末尾有无法回放的数据，
+	 *        调用方应以此调用 TruncateTo
+	 * @return 文件不存在或回放完成返回 true；文件头无效返回 false
+	 * @note 回放是幂等的：已存在的 OperationId 不会重复添加，找不到的卸载会被忽略，
+	 *       因此写入快照后、删除日志前崩溃也不会产生重复记录。
+	 */
+	bool Replay(TArray<FSyStateModificationRecord>& InOutLog, int32& OutNumApplied, TArray<FGuid>& OutUnloadedOperationIds, int64& OutValidSize) const;
+
+	/** 日志文件路径 */
+	const FString& GetFilePath() const { return FilePath; }
+
+private:
+	void AppendEntry(EEntryType Type, TArray<uint8>& Payload);
+
+	FString FilePath;
+
+	/** 尚未写入文件的已编码条目 */
+	TArray<uint8> PendingBytes;
+
+	int32 NumPendingEntries = 0;
+};
@@ -0,0 +1,148 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "State/StateModificationRecord.h"
+#include "State/StateCompaction.h"
+#include "State/StateTargetKey.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * FSyStateLogFileData - 一份完整的操作日志快照（记录 + 检查点）
+ */
+struct SYCORE_API FSyStateLogFileData
+{
+	TArray<FSyStateModificationRecord> Records;
+	TArray<FSyStateTargetCheckpoint> Checkpoints;
+
+	/** 写入时的有效期游戏时钟（秒） */
+	double ExpiryGameClockSeconds = 0.0;
+};
+
+/**
+ * FSyStateLogFileTargetEntry - 日志文件目录中的单个目标
+ */
+struct SYCORE_API FSyStateLogFileTargetEntry
+{
+	/** 目标路由键 */
+	FSyStateTargetKey Target;
+
+	/** 数据块在文件中的偏移 */
+	int64 Offset = 0;
+
+	/** 数据块在文件中的大小 */
+	int32 StoredSize = 0;
+
+	/** 数据块解压后的大小 */
+	int32 UncompressedSize = 0;
+
+	/** 数据块是否压缩 */
+	bool bCompressed = false;
+
+	/** 该目标的记录数量 */
+	int32 NumRecords = 0;
+
+	/** 所在文件的格式版本（决定数据块布局） */
+	uint32 FileVersion = 0;
+};
+
+/**
+ * FSyStateLogFile - 压缩的二进制日志快照文件
+ *
+ * 编解码只读写传入的数据，不访问 StateManager，可在工作线程调用。
+ *
+ * 文件格式（版本 5，按目标分块）：
+ *   uint32 Magic, uint32 Version, int32 NumTargets, int64 DirectoryOffset
+ *   Blocks:    每个目标一个独立压缩的数据块（按属性名序列化）：
+ *              Records..., Payloads..., 每条记录的载荷下标..., 每条记录在写入时日志中的位置..., CheckpointEntries...
+ *   Directory: 每个目标的路由键、数据块偏移、大小与记录数量，之后是写入时的有效期游戏时钟（double）
+ * 按目标分块使读取方可以只解码需要的目标（见 FSyStateMappedLogFile）。
+ * 块内内容相同的修改载荷只写一次，读取后的记录仍共享同一个载荷。
+ * 记录在日志中的位置使读取方可以恢复写入时的全局顺序。
+ * 仍可读取版本 4（无游戏时钟）、版本 3（无记录位置）、版本 2（无载荷表）与版本 1（整体压缩）的文件。
+ */
+struct SYCORE_API FSyStateLogFile
+{
+	/**
+	 * @brief 序列化、压缩并写入文件（先写临时文件再替换，写入中断不会破坏旧文件）
+	 * @param FilePath 目标文件路径
+	 * @param Data 要写入的数据；记录按目标分块，同一目标内保持原有顺序
+	 * @return 写入成功返回 true
+	 */
+	static bool Write(const FString& FilePath, const FSyStateLogFileData& Data);
+
+	/**
+	 * @brief 读取并解码整个文件
+	 * @param FilePath 文件路径
+	 * @param OutData 读取到的数据（记录恢复为写入时的顺序；版本 3 及更早的文件按目标分组）
+	 * @return 读取成功返回 true；文件不存在或格式无效返回 false
+	 */
+	static bool Read(const FString& FilePath, FSyStateLogFileData& OutData);
+
+	/**
+	 * @brief 解析文件头与目录（不解码任何数据块）
+	 * @param FileData 文件内容
+	 * @param FileSize 文件大小
+	 * @param OutDirectory 目录
+	 * @param OutExpiryGameClockSeconds 写入时的有效期游戏时钟（版本 4 及更早的文件为 0）
+	 * @return 是版本 2 文件且目录有效时返回 true
+	 */
+	static bool ReadDirectory(const uint8* FileData, int64 FileSize, TArray<FSyStateLogFileTargetEntry>& OutDirectory, double& OutExpiryGameClockSeconds);
+
+	/**
+	 * @brief 解码单个目标的数据块
+	 * @param FileData 文件内容
+	 * @param FileSize 文件大小
+	 * @param Entry 目录中的目标
+	 * @param OutRecords 该目标的记录（追加）
+	 * @param OutRecordSequence 每条记录在写入时日志中的位置（与 OutRecords 一一对应地追加；旧版本文件为 INDEX_NONE）
+	 * @param OutCheckpointEntries 该目标的检查点
+	 * @return 解码成功返回 true
+	 */
+	static bool ReadTargetBlock(const uint8* FileData, int64 FileSize, const FSyStateLogFileTargetEntry& Entry,
+		TArray<FSyStateModificationRecord>& OutRecords, TArray<int32>& OutRecordSequence, TArray<FSyStateCheckpointEntry>& OutCheckpointEntries);
+};
+
+/**
+ * FSyStateMappedLogFile - 内存映射的日志文件
+ *
+ * 打开时只解析目录，各目标的数据块在首次需要时才从映射内存中解码，
+ * 未被访问的目标不产生任何反序列化开销。
+ */
+class SYCORE_API FSyStateMappedLogFile
+{
+public:
+	~FSyStateMappedLogFile();
+
+	/**
+	 * @brief 映射文件并解析目录
+	 * @param FilePath 文件路径
+	 * @return 成功返回映射对象；文件不存在、平台不支持映射或不是版本 2 文件时返回空
+	 */
+	static TUniquePtr<FSyStateMappedLogFile> Open(const FString& FilePath);
+
+	/** 文件目录 */
+	const TArray<FSyStateLogFileTargetEntry>& GetDirectory() const { return Directory; }
+
+	/** 解码目录中的一个目标（参数见 FSyStateLogFile::ReadTargetBlock） */
+	bool ReadTarget(const FSyStateLogFileTargetEntry& Entry, TArray<FSyStateModificationRecord>& OutRecords, TArray<int32>& OutRecordSequence, TArray<FSyStateCheckpointEntry>& OutCheckpointEntries) const;
+
+	/** 映射的文件大小 */
+	int64 GetFileSize() const { return FileSize; }
+
+	/** 写入时的有效期游戏时钟（秒） */
+	double GetExpiryGameClockSeconds() const { return ExpiryGameClockSeconds; }
+
+private:
+	FSyStateMappedLogFile() = default;
+
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;
+	const uint8* FileData = nullptr;
+	int64 FileSize = 0;
+	TArray<FSyStateLogFileTargetEntry> Directory;
+	double ExpiryGameClockSeconds = 0.0;
+};
@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include <atomic>
+
+class UO_TagMetadata;
+class USyStateMetadataBase;
+
+/** 元数据对象池统计 */
+struct FSyStateMetadataPoolStats
+{
+	/** 池中没有空闲对象、新建的数量 */
+	int64 NumCreated = 0;
+
+	/** 从池中复用的数量 */
+	int64 NumReused = 0;
+
+	/** 归还到池中的数量 */
+	int64 NumReleased = 0;
+
+	/** 归还时池已满（或对象不可复用）而交给 GC 的数量 */
+	int64 NumDiscarded = 0;
+
+	/** 当前池中的空闲对象数量 */
+	int32 NumPooled = 0;
+};
+
+/**
+ * FSyStateMetadataPool - 按类复用的状态元数据对象池
+ *
+ * FSyStateCategories 在某个值类型出现时从池中取出对象，类型消失（如 Buff 卸载）时归还，
+ * 避免频繁切换的状态反复 NewObject 并把旧对象留给 GC。容器只归还自己从池中取出的对象，
+ * 经 SetLayer 等接口传入的外部对象不会入池。
+ * 归还的对象在下一帧才会被复用（复用时 ResetForReuse 重置）：本帧内已取得的元数据指针仍保持原值，
+ * 但 C++ 调用方不应跨帧持有状态变化前取得的指针。经 GetStateLayer / GetEffectiveStateCategories
+ * 交给蓝图的集合会被标记，之后移除的对象交给 GC 而不入池，蓝图缓存的指针不会指向其它实体的状态。
+ * 只在游戏线程复用，其它线程的请求直接新建 / 交给 GC。由 FSyCoreModule 在启动 / 关闭时创建和销毁。
+ */
+class SYCORE_API FSyStateMetadataPool : public FGCObject
+{
+public:
+	/** 获取对象池实例（模块启动后可用） */
+	static FSyStateMetadataPool& Get();
+
+	static void Initialize();
+	static void Shutdown();
+
+	/**
+	 * @brief 取出一个指定类的元数据对象（池中没有时新建于 TransientPackage）
+	 * @param MetadataClass 元数据类（USyStateMetadataBase 子类）
+	 */
+	USyStateMetadataBase* Acquire(UClass* MetadataClass);
+
+	/**
+	 * @brief 归还由 Acquire 取出的元数据对象，下一帧起可被复用
+	 * @param Metadata 要归还的对象；非 TransientPackage 下的对象不会入池
+	 */
+	void Release(UO_TagMetadata* Metadata);
+
+	/** 释放全部空闲对象（交给 GC） */
+	void Trim();
+
+	/** 设置每个类最多保留的空闲对象数量 */
+	void SetMaxPooledPerClass(int32 InMaxPooledPerClass);
+
+	/** 获取统计 */
+	FSyStateMetadataPoolStats GetStats() const;
+
+	//~ Begin FGCObject Interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FSyStateMetadataPool"); }
+	//~ End FGCObject Interface
+
+private:
+	FSyStateMetadataPool() = default;
+
+	/** 单个类的空闲对象 */
+	struct FFreeList
+	{
+		/** 可复用的对象 */
+		TArray<TObjectPtr<USyStateMetadataBase>> Ready;
+
+		/** 本帧归还的对象（PendingFrame 之后的帧移入 Ready） */
+		TArray<TObjectPtr<USyStateMetadataBase>> Pending;
+		uint64 PendingFrame = 0;
+
+		int32 Num() const { return Ready.Num() + Pending.Num(); }
+
+		/** 之前帧归还的对象移入 Ready */
+		void PromotePending();
+	};
+
+	/** 元数据类 -> 空闲对象（空闲对象持有类的引用，键不需要单独追踪） */
+	TMap<const UClass*, FFreeList> FreeLists;
+
+	int32 MaxPooledPerClass = 256;
+
+	/** 统计计数（新建 / 丢弃可能发生在其它线程） */
+	std::atomic<int64> NumCreated { 0 };
+	std::atomic<int64> NumReused { 0 };
+	std::atomic<int64> NumReleased { 0 };
+	std::atomic<int64> NumDiscarded { 0 };
+
+	static FSyStateMetadataPool* Instance;
+};
@@ -8,6 +8,22 @@
 #include "State/Operations/OperationTypes.h" // 引入 FSyOperation 的定义
 #include "StateModificationRecord.generated.h"
 
+/**
+ * @brief 记录的状态修改载荷（只读，可被多条记录共享）
+ * 由 FSyStatePayloadPool 按内容驻留：内容相同的载荷只保存一份。
+ */
+struct SYCORE_API FSyStatePayload
+{
+    /** 状态修改 */
+    FSyStateParameterSet Parameters;
+
+    /** 内容哈希 */
+    uint64 Hash = 0;
+
+    /** 重复合并结果不变（不含列表与数值修饰），聚合时可跳过紧邻的相同载荷 */
+    bool bIdempotent = false;
+};
+
 /**
  * @brief 状态修改记录
  * 封装一个已被状态管理器记录的操作 (FSyOperation) 及其相关元数据。
@@ -26,10 +42,23 @@ struct SYCORE_API FSyStateModificationRecord
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Record", meta=(Comment="此记录被创建的时间戳"))
     FDateTime Timestamp;
 
+    /**
+     * 记录时 StateManager 的有效期游戏时钟（秒），只对游戏时间有效期的操作设置。
+     * 游戏时钟随存档保存，到期时刻由此计算，读档后继续计算剩余时间；负值表示未知（旧存档），读档时重新计时。
+     */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Record", meta=(Comment="记录时的有效期游戏时钟"))
+    double ExpiryGameClockSeconds = -1.0;
+
     /** 实际发生并被记录的操作的完整数据 */
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Record", meta=(Comment="实际发生并被记录的操作的完整数据"))
     FSyOperation Operation;
 
+    /**
+     * 共享的修改载荷（由 StateManager 驻留）。
+     * 设置后 Operation.Modifier.StateModifications 为空，读取修改请使用 GetStateModifications()。
+     */
+    TSharedPtr<const FSyStatePayload> Payload;
+
     // 默认构造函数
     FSyStateModificationRecord()
         : RecordId(FGuid::NewGuid()), // 创建时自动生成ID
@@ -43,6 +72,30 @@ struct SYCORE_API FSyStateModificationRecord
           Operation(InOperation) // 直接拷贝操作数据
     {}
 
+    /** 本记录的状态修改（优先读取共享载荷） */
+    const FSyStateParameterSet& GetStateModifications() const
+    {
+        return Payload.IsValid() ? Payload->Parameters : Operation.Modifier.StateModifications;
+    }
+
+    /** 把共享载荷拷回 Operation，之后记录不再引用共享载荷 */
+    void InlinePayload()
+    {
+        if (Payload.IsValid())
+        {
+            Operation.Modifier.StateModifications = Payload->Parameters;
+            Payload.Reset();
+        }
+    }
+
+    /** 载荷内联后的副本（蓝图、存档等按属性读取记录的场合使用） */
+    FSyStateModificationRecord WithInlinePayload() const
+    {
+        FSyStateModificationRecord Copy(*this);
+        Copy.InlinePayload();
+        return Copy;
+    }
+
     // TODO: [拓展] 可以考虑添加额外的元数据，例如：
     // - 操作是被哪个系统或流程发起的？(FGameplayTag SourceSystemTag?)
     // - 操作执行的结果状态？(ESyOperationResult ResultStatus?) - 但这会增加StateManager的职责，需要谨慎考虑
@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "State/StateModificationRecord.h"
+
+/**
+ * FSyStatePayloadPool - 按内容驻留的状态修改载荷池
+ *
+ * 流程节点反复提交的操作往往携带完全相同的修改（如 "Interactable = true" 加同一份交互列表）。
+ * 记录入池后只引用共享的只读载荷，内容相同的载荷只保存一份；池只持有弱引用，
+ * 最后一条引用载荷的记录移除后载荷即释放。
+ */
+class SYCORE_API FSyStatePayloadPool
+{
+public:
+	/**
+	 * @brief 创建载荷（计算内容哈希，不入池，可在工作线程调用）
+	 * @param Parameters 状态修改
+	 */
+	static TSharedRef<const FSyStatePayload> MakePayload(FSyStateParameterSet&& Parameters);
+
+	/**
+	 * @brief 驻留载荷：池中已有内容相同的载荷时返回池中的载荷，否则登记并返回传入的载荷
+	 * @param Payload 要驻留的载荷
+	 */
+	TSharedRef<const FSyStatePayload> Intern(const TSharedRef<const FSyStatePayload>& Payload);
+
+	/**
+	 * @brief 使记录引用驻留的载荷；内联的修改移入载荷后从 Operation 中清空
+	 * @param Record 要驻留的记录
+	 */
+	void InternRecord(FSyStateModificationRecord& Record);
+
+	/** 移除已释放的载荷 */
+	void Trim();
+
+	/** 清空池（已驻留的载荷仍由引用它的记录持有） */
+	void Reset();
+
+	/** 池中登记的载荷数量（含尚未清理的已释放载荷） */
+	int32 Num() const { return Entries.Num(); }
+
+private:
+	/** 内容哈希 -> 载荷 */
+	TMultiMap<uint64, TWeakPtr<const FSyStatePayload>> Entries;
+
+	/** 登记数量超过此值时清理一次已释放的载荷 */
+	int32 TrimThreshold = 256;
+};
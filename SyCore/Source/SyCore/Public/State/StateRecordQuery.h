@@ -0,0 +1,168 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Misc/DateTime.h"
+#include "State/StateModificationRecord.h"
+
+/**
+ * FSyStateRecordQuery - 修改记录查询条件
+ *
+ * 所有条件为"与"关系，未设置的条件不参与筛选。
+ */
+struct SYCORE_API FSyStateRecordQuery
+{
+	/** 记录修改了此状态标签（精确匹配） */
+	FGameplayTag StateTag;
+
+	/** 记录的来源类型标签（精确匹配） */
+	FGameplayTag SourceTag;
+
+	/** 记录的来源实体ID */
+	FGuid SourceEntityId;
+
+	/** 时间范围 [MinTimestamp, MaxTimestamp]（UTC） */
+	FDateTime MinTimestamp = FDateTime::MinValue();
+	FDateTime MaxTimestamp = FDateTime::MaxValue();
+
+	FSyStateRecordQuery() = default;
+
+	static FSyStateRecordQuery ByStateTag(const FGameplayTag& InStateTag)
+	{
+		FSyStateRecordQuery Query;
+		Query.StateTag = InStateTag;
+		return Query;
+	}
+
+	static FSyStateRecordQuery BySourceTag(const FGameplayTag& InSourceTag)
+	{
+		FSyStateRecordQuery Query;
+		Query.SourceTag = InSourceTag;
+		return Query;
+	}
+
+	static FSyStateRecordQuery BySourceEntity(const FGuid& InSourceEntityId)
+	{
+		FSyStateRecordQuery Query;
+		Query.SourceEntityId = InSourceEntityId;
+		return Query;
+	}
+
+	/** 限定时间范围 */
+	FSyStateRecordQuery& InTimeRange(const FDateTime& InMin, const FDateTime& InMax)
+	{
+		MinTimestamp = InMin;
+		MaxTimestamp = InMax;
+		return *this;
+	}
+
+	/** 检查单条记录是否满足全部条件 */
+	bool Matches(const FSyStateModificationRecord& Record) const;
+};
+
+/**
+ * FSyStateRecordView - 查询结果视图
+ *
+ * 不拷贝记录：持有日志与候选索引的视图，迭代时按条件过滤。
+ * 视图在 StateManager 的日志被修改（记录 / 卸载 / 加载）后失效，请勿跨帧保存。
+ * 日志中的记录引用共享载荷，读取修改请使用 Record.GetStateModifications()。
+ *
+ * 用法:
+ * for (const FSyStateModificationRecord& Record : StateManager->QueryRecords(FSyStateRecordQuery::ByStateTag(Tag)))
+ * {
+ *     ...
+ * }
+ */
+class SYCORE_API FSyStateRecordView
+{
+public:
+	class FIterator
+	{
+	public:
+		FIterator(const FSyStateRecordView& InView, int32 InPosition)
+			: View(InView), Position(InPosition)
+		{
+			SkipNonMatching();
+		}
+
+		const FSyStateModificationRecord& operator*() const { return View.GetRecordAt(Position); }
+		const FSyStateModificationRecord* operator->() const { return &View.GetRecordAt(Position); }
+
+		FIterator& operator++()
+		{
+			++Position;
+			SkipNonMatching();
+			return *this;
+		}
+
+		bool operator!=(const FIterator& Other) const { return Position != Other.Position; }
+		bool operator==(const FIterator& Other) const { return Position == Other.Position; }
+
+		/** 当前记录在 ModificationLog 中的位置 */
+		int32 GetLogIndex() const { return View.GetLogIndexAt(Position); }
+
+	private:
+		void SkipNonMatching()
+		{
+			while (Position < View.NumCandidates() && !View.Query.Matches(View.GetRecordAt(Position)))
+			{
+				++Position;
+			}
+		}
+
+		const FSyStateRecordView& View;
+		int32 Position;
+	};
+
+	/** 遍历整个日志 */
+	FSyStateRecordView(TConstArrayView<FSyStateModificationRecord> InLog, const FSyStateRecordQuery& InQuery)
+		: Log(InLog), Query(InQuery), bUseCandidates(false)
+	{}
+
+	/** 只遍历索引给出的候选记录 */
+	FSyStateRecordView(TConstArrayView<FSyStateModificationRecord> InLog, TConstArrayView<int32> InCandidates, const FSyStateRecordQuery& InQuery)
+		: Log(InLog), Candidates(InCandidates), Query(InQuery), bUseCandidates(true)
+	{}
+
+	FIterator begin() const { return FIterator(*this, 0); }
+	FIterator end() const { return FIterator(*this, NumCandidates()); }
+
+	/** 是否没有任何匹配记录 */
+	bool IsEmpty() const { return !(begin() != end()); }
+
+	/** 统计匹配记录数量（需要遍历） */
+	int32 Num() const
+	{
+		int32 Count = 0;
+		for (FIterator It = begin(); It != end(); ++It)
+		{
+			++Count;
+		}
+		return Count;
+	}
+
+	/** 在候选集中需要检查的记录数量上限 */
+	int32 NumCandidates() const { return bUseCandidates ? Candidates.Num() : Log.Num(); }
+
+	/** 拷贝匹配记录（仅用于蓝图等必须持有结果的场景；修改载荷内联到 Operation 中） */
+	TArray<FSyStateModificationRecord> ToArray() const
+	{
+		TArray<FSyStateModificationRecord> Result;
+		for (const FSyStateModificationRecord& Record : *this)
+		{
+			Result.Add(Record.WithInlinePayload());
+		}
+		return Result;
+	}
+
+private:
+	int32 GetLogIndexAt(int32 Position) const { return bUseCandidates ? Candidates[Position] : Position; }
+	const FSyStateModificationRecord& GetRecordAt(int32 Position) const { return Log[GetLogIndexAt(Position)]; }
+
+	TConstArrayView<FSyStateModificationRecord> Log;
+	TConstArrayView<int32> Candidates;
+	FSyStateRecordQuery Query;
+	bool bUseCandidates;
+};
@@ -0,0 +1,80 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "StructUtils/InstancedStruct.h"
+#include "UObject/GCObject.h"
+#include "State/Types/StateContainerTypes.h"
+#include "State/StateValueArena.h"
+
+/**
+ * FSySharedStateLayer - 多个容器共享的只读状态层
+ *
+ * 由相同的初始化数据构建一次，内容之后不再修改。
+ * 非紧凑存储时内容为元数据对象（State），紧凑存储时为值结构体（Values）。
+ */
+struct SYCORE_API FSySharedStateLayer
+{
+	/** 构建该层的参数（用于判断内容是否相同） */
+	TMap<FGameplayTag, TArray<FInstancedStruct>> Params;
+
+	/** Params 的内容哈希 */
+	uint32 Hash = 0;
+
+	/** 是否为紧凑存储构建 */
+	bool bPackedValues = false;
+
+	/** 非紧凑存储：元数据对象 */
+	FSyStateCategories State;
+
+	/** 紧凑存储：值结构体 */
+	FSyStateValueArena Values;
+};
+
+/**
+ * FSySharedStateLayerCache - 共享状态层的驻留表
+ *
+ * 按参数内容的哈希查找已有的共享层，内容相同（逐值比较）时直接复用，
+ * 否则用调用方提供的函数构建新层。表中只保存弱引用，最后一个容器释放后共享层随之销毁。
+ * 只在游戏线程使用。由 FSyCoreModule 在启动 / 关闭时创建和销毁。
+ */
+class SYCORE_API FSySharedStateLayerCache : public FGCObject
+{
+public:
+	/** 获取驻留表实例（模块启动后可用） */
+	static FSySharedStateLayerCache& Get();
+
+	static void Initialize();
+	static void Shutdown();
+
+	/**
+	 * @brief 查找内容相同的共享层，没有时构建并登记
+	 * @param Params 参数（状态标签 -> 值）
+	 * @param bPackedValues 是否为紧凑存储
+	 * @param BuildLayer 构建函数：根据 Params 填充 State 或 Values
+	 */
+	TSharedRef<const FSySharedStateLayer> FindOrAdd(const TMap<FGameplayTag, TArray<FInstancedStruct>>& Params, bool bPackedValues, TFunctionRef<void(FSySharedStateLayer&)> BuildLayer);
+
+	/** 当前存活的共享层数量 */
+	int32 Num() const;
+
+	/** 计算参数内容的哈希（与标签顺序无关） */
+	static uint32 HashParams(const TMap<FGameplayTag, TArray<FInstancedStruct>>& Params);
+
+	//~ Begin FGCObject Interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FSySharedStateLayerCache"); }
+	//~ End FGCObject Interface
+
+private:
+	FSySharedStateLayerCache() = default;
+
+	static bool ParamsIdentical(const TMap<FGameplayTag, TArray<FInstancedStruct>>& A, const TMap<FGameplayTag, TArray<FInstancedStruct>>& B);
+
+	/** 内容哈希 -> 共享层（弱引用，查找时清理已销毁的项） */
+	TMap<uint32, TArray<TWeakPtr<FSySharedStateLayer>>> Layers;
+
+	static FSySharedStateLayerCache* Instance;
+};
@@ -0,0 +1,68 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "StructUtils/InstancedStruct.h"
+#include "Templates/SharedPointer.h"
+#include "State/Types/StateParameterTypes.h"
+
+/**
+ * FSyStateSnapshotEntry - 快照条目
+ *
+ * 单个状态标签聚合后的参数。条目创建后不可变，
+ * 未发生变化的条目会在新旧快照之间共享（结构共享），
+ * 因此比较两个快照时只需比较条目指针。
+ */
+struct SYCORE_API FSyStateSnapshotEntry
+{
+	/** 聚合后的参数数组 */
+	TArray<FInstancedStruct> Params;
+
+	/** 该条目最后一次变化时的版本号 */
+	int32 Version = 0;
+
+	FSyStateSnapshotEntry() = default;
+	FSyStateSnapshotEntry(TArray<FInstancedStruct>&& InParams, int32 InVersion)
+		: Params(MoveTemp(InParams)), Version(InVersion) {}
+};
+
+using FSyStateSnapshotEntryRef = TSharedRef<const FSyStateSnapshotEntry>;
+
+/**
+ * FSyStateSnapshot - 目标聚合快照（只读、引用计数、带版本）
+ *
+ * 由 USyStateManagerSubsystem 生成并共享给所有订阅同一目标的组件，
+ * 组件通过引用读取，不再为每个组件拷贝完整的 FSyStateParameterSet。
+ */
+struct SYCORE_API FSyStateSnapshot
+{
+	/** 快照版本号（每次生成新快照时递增） */
+	int32 Version = 0;
+
+	/** 状态标签 -> 共享的快照条目 */
+	TMap<FGameplayTag, FSyStateSnapshotEntryRef> Entries;
+
+	/** 查找指定状态标签的聚合参数，不存在时返回 nullptr */
+	const TArray<FInstancedStruct>* FindParams(const FGameplayTag& StateTag) const
+	{
+		const FSyStateSnapshotEntryRef* Entry = Entries.Find(StateTag);
+		return Entry ? &(*Entry)->Params : nullptr;
+	}
+
+	/** 转换为 FSyStateParameterSet（会拷贝参数，仅用于兼容旧接口） */
+	FSyStateParameterSet ToParameterSet() const;
+
+	/**
+	 * @brief 比较两个快照，找出发生变化和被移除的状态标签。
+	 * @param NewSnapshot 新快照（可为空，表示没有任何状态）
+	 * @param OldSnapshot 旧快照（可为空，表示之前没有应用过快照）
+	 * @param OutChangedTags 新增或内容变化的标签
+	 * @param OutRemovedTags 在新快照中已不存在的标签
+	 */
+	static void Diff(const FSyStateSnapshot* NewSnapshot, const FSyStateSnapshot* OldSnapshot,
+		TArray<FGameplayTag>& OutChangedTags, TArray<FGameplayTag>& OutRemovedTags);
+};
+
+using FSyStateSnapshotPtr = TSharedPtr<const FSyStateSnapshot>;
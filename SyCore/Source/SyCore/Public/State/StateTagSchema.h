@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "UObject/GCObject.h"
+#include "Misc/ScopeRWLock.h"
+
+class USyStateMetadataBase;
+struct FPropertyChangedEvent;
+
+/**
+ * FSyStateTagSchema - 一个状态标签的元数据结构描述
+ *
+ * 由 UDS_TagMetadata 中该标签的模板解析而来：期望的元数据类及其值类型（GetValueDataType）。
+ * 状态更新只按此表查找，不再逐次查询模板、Cast 并调用蓝图原生事件。
+ */
+struct SYCORE_API FSyStateTagSchema
+{
+	struct FSlot
+	{
+		/** 元数据类 */
+		TObjectPtr<UClass> MetadataClass;
+
+		/** 该元数据管理的值类型（可能为空） */
+		TObjectPtr<UScriptStruct> ValueType;
+	};
+
+	/** 按模板顺序排列的元数据槽位（只包含 USyStateMetadataBase 子类） */
+	TArray<FSlot> Slots;
+};
+
+/**
+ * FSyStateTagSchemaCache - 状态标签结构描述缓存
+ *
+ * 每个标签首次使用时解析一次；标签树变化、编辑器中修改标签元数据或蓝图重编译时整体失效。
+ * 返回的描述是不可变的共享对象，失效后已取得的描述仍然可用。
+ * 由 FSyCoreModule 在启动 / 关闭时创建和销毁。
+ */
+class SYCORE_API FSyStateTagSchemaCache : public FGCObject
+{
+public:
+	/** 获取缓存实例（模块启动后可用） */
+	static FSyStateTagSchemaCache& Get();
+
+	static void Initialize();
+	static void Shutdown();
+
+	/**
+	 * @brief 查找标签的结构描述，尚未解析时解析并缓存
+	 * @param StateTag 状态标签
+	 */
+	TSharedRef<const FSyStateTagSchema> FindOrBuild(const FGameplayTag& StateTag);
+
+	/** 使全部缓存失效 */
+	void Invalidate();
+
+	//~ Begin FGCObject Interface
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override { return TEXT("FSyStateTagSchemaCache"); }
+	//~ End FGCObject Interface
+
+private:
+	FSyStateTagSchemaCache();
+	virtual ~FSyStateTagSchemaCache() override;
+
+	static TSharedRef<FSyStateTagSchema> BuildSchema(const FGameplayTag& StateTag);
+
+#if WITH_EDITOR
+	void HandleObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
+	void HandleObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap);
+#endif
+
+	/** 状态标签 -> 结构描述（序列化可能发生在加载线程，读写加锁） */
+	TMap<FGameplayTag, TSharedRef<FSyStateTagSchema>> Schemas;
+	mutable FRWLock SchemasLock;
+
+	FDelegateHandle TagTreeChangedHandle;
+#if WITH_EDITOR
+	FDelegateHandle PropertyChangedHandle;
+	FDelegateHandle ObjectsReplacedHandle;
+#endif
+
+	static FSyStateTagSchemaCache* Instance;
+};
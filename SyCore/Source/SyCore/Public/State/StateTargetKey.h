@@ -0,0 +1,144 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "State/Operations/OperationTypes.h"
+
+/**
+ * ESyStateTargetScope - 操作目标的路由范围
+ *
+ * 同一实体可能同时接收三种范围的状态，合并时优先级 Type < Alias < Entity。
+ */
+enum class ESyStateTargetScope : uint8
+{
+	/** 按目标类型标签路由（影响该类型的所有实体） */
+	Type = 0,
+
+	/** 按别名路由 */
+	Alias = 1,
+
+	/** 按实体ID路由（只影响一个实体） */
+	Entity = 2,
+
+	Num
+};
+
+/**
+ * FSyStateTargetKey - StateManager 内部的目标路由键
+ *
+ * 记录索引、聚合快照与订阅者都按此键分组。
+ * 操作的路由规则：有效的 TargetEntityId 优先，其次 TargetAlias，最后 TargetTypeTag。
+ */
+struct SYCORE_API FSyStateTargetKey
+{
+	ESyStateTargetScope Scope = ESyStateTargetScope::Type;
+	FGameplayTag TypeTag;
+	FName Alias;
+	FGuid EntityId;
+
+	FSyStateTargetKey() = default;
+
+	static FSyStateTargetKey FromType(const FGameplayTag& InTypeTag)
+	{
+		FSyStateTargetKey Key;
+		Key.Scope = ESyStateTargetScope::Type;
+		Key.TypeTag = InTypeTag;
+		return Key;
+	}
+
+	static FSyStateTargetKey FromAlias(FName InAlias)
+	{
+		FSyStateTargetKey Key;
+		Key.Scope = ESyStateTargetScope::Alias;
+		Key.Alias = InAlias;
+		return Key;
+	}
+
+	static FSyStateTargetKey FromEntity(const FGuid& InEntityId)
+	{
+		FSyStateTargetKey Key;
+		Key.Scope = ESyStateTargetScope::Entity;
+		Key.EntityId = InEntityId;
+		return Key;
+	}
+
+	/** 根据操作目标计算路由键（Entity > Alias > Type） */
+	static FSyStateTargetKey FromOperationTarget(const FSyOperationTarget& Target)
+	{
+		if (Target.HasValidId())
+		{
+			return FromEntity(Target.TargetEntityId);
+		}
+		if (Target.HasValidAlias())
+		{
+			return FromAlias(Target.TargetAlias);
+		}
+		return FromType(Target.TargetTypeTag);
+	}
+
+	/** 转换为只包含路由字段的操作目标（FromOperationTarget 的逆运算，用于存档） */
+	FSyOperationTarget ToOperationTarget() const
+	{
+		FSyOperationTarget Target;
+		switch (Scope)
+		{
+		case ESyStateTargetScope::Entity: Target.TargetEntityId = EntityId; break;
+		case ESyStateTargetScope::Alias:  Target.TargetAlias = Alias; break;
+		default:                          Target.TargetTypeTag = TypeTag; break;
+		}
+		return Target;
+	}
+
+	bool IsValid() const
+	{
+		switch (Scope)
+		{
+		case ESyStateTargetScope::Type:   return TypeTag.IsValid();
+		case ESyStateTargetScope::Alias:  return Alias != NAME_None;
+		case ESyStateTargetScope::Entity: return EntityId.IsValid();
+		default:                          return false;
+		}
+	}
+
+	FString ToString() const
+	{
+		switch (Scope)
+		{
+		case ESyStateTargetScope::Type:   return FString::Printf(TEXT("Type:%s"), *TypeTag.ToString());
+		case ESyStateTargetScope::Alias:  return FString::Printf(TEXT("Alias:%s"), *Alias.ToString());
+		case ESyStateTargetScope::Entity: return FString::Printf(TEXT("Entity:%s"), *EntityId.ToString());
+		default:                          return TEXT("Invalid");
+		}
+	}
+
+	bool operator==(const FSyStateTargetKey& Other) const
+	{
+		if (Scope != Other.Scope)
+		{
+			return false;
+		}
+		switch (Scope)
+		{
+		case ESyStateTargetScope::Type:   return TypeTag == Other.TypeTag;
+		case ESyStateTargetScope::Alias:  return Alias == Other.Alias;
+		case ESyStateTargetScope::Entity: return EntityId == Other.EntityId;
+		default:                          return true;
+		}
+	}
+
+	bool operator!=(const FSyStateTargetKey& Other) const { return !(*this == Other); }
+
+	friend uint32 GetTypeHash(const FSyStateTargetKey& Key)
+	{
+		uint32 Hash = ::GetTypeHash(static_cast<uint8>(Key.Scope));
+		switch (Key.Scope)
+		{
+		case ESyStateTargetScope::Type:   return HashCombine(Hash, GetTypeHash(Key.TypeTag));
+		case ESyStateTargetScope::Alias:  return HashCombine(Hash, GetTypeHash(Key.Alias));
+		case ESyStateTargetScope::Entity: return HashCombine(Hash, GetTypeHash(Key.EntityId));
+		default:                          return Hash;
+		}
+	}
+};
@@ -0,0 +1,126 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "StructUtils/InstancedStruct.h"
+
+/**
+ * FSyStateValueArena - 按状态标签存放值结构体的紧凑存储
+ *
+ * 值（FSyBoolValue / FSyFloatValue ...）直接构造在一块连续内存中，每个标签对应一段槽位，
+ * 槽位记录值类型与偏移。与每个值一个元数据 UObject 相比，没有对象头、名称与 GC 追踪，
+ * 读取也不需要经过蓝图原生事件构造 FInstancedStruct。
+ *
+ * 同一标签以相同的类型布局重写时原地拷贝；布局变化时在末尾重新分配，
+ * 废弃空间超过一半时整体压缩。内存增长时值按位搬移（与 TArray 对元素的假设一致）。
+ */
+class SYCORE_API FSyStateValueArena
+{
+public:
+	FSyStateValueArena() = default;
+	FSyStateValueArena(const FSyStateValueArena& Other);
+	FSyStateValueArena(FSyStateValueArena&& Other) = default;
+	FSyStateValueArena& operator=(const FSyStateValueArena& Other);
+	FSyStateValueArena& operator=(FSyStateValueArena&& Other);
+	~FSyStateValueArena();
+
+	/**
+	 * @brief 设置标签的全部值（替换原有的值）
+	 * @param StateTag 状态标签
+	 * @param Values 值，无效的 FInstancedStruct 会被跳过
+	 */
+	void SetValues(const FGameplayTag& StateTag, TConstArrayView<FInstancedStruct> Values);
+
+	/**
+	 * @brief 移除标签及其全部值
+	 * @return 标签存在时返回 true
+	 */
+	bool RemoveTag(const FGameplayTag& StateTag);
+
+	/** 是否包含该标签（值可以为空） */
+	bool Contains(const FGameplayTag& StateTag) const { return Ranges.Contains(StateTag); }
+
+	/**
+	 * @brief 查找标签下指定类型的值
+	 * @return 值的地址，下次修改前有效；找不到返回 nullptr
+	 */
+	const void* FindValue(const FGameplayTag& StateTag, const UScriptStruct* ValueType) const;
+
+	template<typename T>
+	const T* Find(const FGameplayTag& StateTag) const
+	{
+		return static_cast<const T*>(FindValue(StateTag, T::StaticStruct()));
+	}
+
+	/**
+	 * @brief 以 FInstancedStruct 形式取出标签的全部值（拷贝）
+	 * @return 标签存在时返回 true
+	 */
+	bool GetValues(const FGameplayTag& StateTag, TArray<FInstancedStruct>& OutValues) const;
+
+	/** 取出全部标签 */
+	void GetTags(TArray<FGameplayTag>& OutTags) const { Ranges.GenerateKeyArray(OutTags); }
+
+	/** 标签数量 */
+	int32 Num() const { return Ranges.Num(); }
+
+	bool IsEmpty() const { return Ranges.IsEmpty(); }
+
+	/** 清空全部值 */
+	void Reset();
+
+	/** 占用的堆内存 */
+	SIZE_T GetAllocatedSize() const;
+
+	/** 报告值类型与值中引用的对象（由持有者的 AddReferencedObjects 调用） */
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
+private:
+	struct FSlot
+	{
+		/** 值类型 */
+		TObjectPtr<UScriptStruct> ValueType;
+
+		/** 在 Memory 中的偏移 */
+		int32 Offset = 0;
+	};
+
+	struct FRange
+	{
+		int32 FirstSlot = 0;
+		int32 NumSlots = 0;
+	};
+
+	/** 状态标签 -> 槽位区间 */
+	TMap<FGameplayTag, FRange> Ranges;
+
+	/** 槽位（已废弃的区间留在原处直到压缩） */
+	TArray<FSlot> Slots;
+
+	/** 值存放的内存 */
+	TArray<uint8, TAlignedHeapAllocator<16>> Memory;
+
+	/** 已废弃的字节数与槽位数 */
+	int32 WastedBytes = 0;
+	int32 WastedSlots = 0;
+
+	uint8* GetValuePtr(const FSlot& Slot) { return Memory.GetData() + Slot.Offset; }
+	const uint8* GetValuePtr(const FSlot& Slot) const { return Memory.GetData() + Slot.Offset; }
+
+	/** 在末尾为一个值分配并初始化空间，返回偏移 */
+	int32 AllocateValue(const UScriptStruct* ValueType);
+
+	/** 析构区间内的值并计入废弃空间 */
+	void ReleaseRange(const FRange& Range);
+
+	/** 区间内的值类型是否与 Values 中的有效值逐个一致 */
+	bool MatchesLayout(const FRange& Range, TConstArrayView<FInstancedStruct> Values) const;
+
+	/** 重新排布全部存活的值，丢弃废弃空间 */
+	void Compact();
+
+	/** 从 Other 拷贝全部值（当前必须为空） */
+	void CopyFrom(const FSyStateValueArena& Other);
+};
@@ -0,0 +1,112 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "State/Types/StateContainerTypes.h"
+
+/**
+ * FSyStateValueHandle - 单个状态值的类型化读取句柄
+ *
+ * 标签与值类型只解析一次，之后每次读取只比较容器版本号：版本未变时直接返回缓存的地址。
+ * - 紧凑存储（bUsePackedValueStorage）：缓存值结构体在 FSyStateValueArena 中的地址，不拷贝
+ * - 元数据对象存储：版本变化时拷贝一次值到句柄内，之后按引用读取
+ * 用于每帧读取的状态（如速度倍率）。句柄不能比提供容器的组件活得更久；
+ * 绕过容器直接修改元数据对象不会递增版本号，句柄读到的仍是旧值。
+ *
+ * 用法：
+ *   SpeedHandle = StateComponent->MakeStateValueHandle<FSyFloatValue>(SpeedTag);
+ *   const float Multiplier = SpeedHandle.Get(FSyFloatValue(1.0f)).Value;
+ */
+template<typename T>
+class FSyStateValueHandle
+{
+public:
+	FSyStateValueHandle() = default;
+
+	FSyStateValueHandle(const FSyLayeredStateContainer& InContainer, const FGameplayTag& InStateTag)
+		: Container(&InContainer)
+		, StateTag(InStateTag)
+	{
+	}
+
+	/** 拷贝后重新解析（缓存的地址可能指向源句柄内的值） */
+	FSyStateValueHandle(const FSyStateValueHandle& Other)
+		: Container(Other.Container)
+		, StateTag(Other.StateTag)
+	{
+	}
+
+	FSyStateValueHandle& operator=(const FSyStateValueHandle& Other)
+	{
+		Container = Other.Container;
+		StateTag = Other.StateTag;
+		ValuePtr = nullptr;
+		bResolved = false;
+		return *this;
+	}
+
+	/**
+	 * @brief 读取当前生效的值
+	 * @return 值的地址，容器下次修改前有效；没有该值时返回 nullptr
+	 */
+	const T* Get() const
+	{
+		if (!Container)
+		{
+			return nullptr;
+		}
+		if (!bResolved || ResolvedVersion != Container->GetVersion())
+		{
+			Resolve();
+		}
+		return ValuePtr;
+	}
+
+	/** 读取当前生效的值，没有该值时返回 DefaultValue */
+	const T& Get(const T& DefaultValue) const
+	{
+		const T* Value = Get();
+		return Value ? *Value : DefaultValue;
+	}
+
+	/** 是否已绑定到容器 */
+	bool IsBound() const { return Container != nullptr; }
+
+	const FGameplayTag& GetStateTag() const { return StateTag; }
+
+	/** 解除绑定 */
+	void Reset()
+	{
+		Container = nullptr;
+		StateTag = FGameplayTag();
+		ValuePtr = nullptr;
+		bResolved = false;
+	}
+
+private:
+	void Resolve() const
+	{
+		ResolvedVersion = Container->GetVersion();
+		bResolved = true;
+
+		if (Container->UsesPackedValueStorage())
+		{
+			ValuePtr = static_cast<const T*>(Container->FindEffectivePackedValue(StateTag, T::StaticStruct()));
+			return;
+		}
+		ValuePtr = Container->GetEffectiveValue(StateTag, CachedValue) ? &CachedValue : nullptr;
+	}
+
+	const FSyLayeredStateContainer* Container = nullptr;
+	FGameplayTag StateTag;
+
+	/** 解析结果：紧凑存储中的值或 CachedValue */
+	mutable const T* ValuePtr = nullptr;
+
+	/** 元数据对象存储时拷贝出的值 */
+	mutable T CachedValue;
+
+	mutable uint32 ResolvedVersion = 0;
+	mutable bool bResolved = false;
+};
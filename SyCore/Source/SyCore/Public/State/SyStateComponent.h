@@ -5,14 +5,48 @@
 #include "GameplayTagContainer.h"
 #include "Entity/SyEntityComponent.h"
 #include "State/StateModificationRecord.h" // 包含 FSyStateModificationRecord
+#include "State/StateSnapshot.h"
+#include "State/StateTargetKey.h"
 #include "Foundation/ISyComponentInterface.h"
 #include "Types/StateContainerTypes.h"
+#include "State/Types/StateMetadataTypes.h"
+#include "State/StateValueHandle.h"
 #include "SyStateComponent.generated.h"
 
 // 前向声明
 class USyStateManagerSubsystem;
+class USyStateUpdateSubsystem;
+struct FSyTargetStateChange;
 struct FSyStateParameterSet; 
 
+/**
+ * FSyStateSyncRequest - 一次快照同步的输入（游戏线程收集）
+ *
+ * 各路由范围的新快照与受影响的状态标签，由 USyStateComponent::PrepareSnapshotSync 填充，
+ * 之后 ApplySnapshotSync 只读取本结构与组件自身的分层容器。
+ */
+struct FSyStateSyncRequest
+{
+    /** 各范围（类型 / 别名 / 实体）的最新快照 */
+    FSyStateSnapshotPtr NewSnapshots[(int32)ESyStateTargetScope::Num];
+
+    /** 新增、修改或被移除的状态标签 */
+    TSet<FGameplayTag> DirtyTags;
+
+    /** 首次同步：Persistent 层先整体清空再重建 */
+    bool bFirstSync = false;
+
+    void Reset()
+    {
+        for (FSyStateSnapshotPtr& Snapshot : NewSnapshots)
+        {
+            Snapshot.Reset();
+        }
+        DirtyTags.Reset();
+        bFirstSync = false;
+    }
+};
+
 /**
  * SyStateComponent - 实体状态组件
  * 职责：
@@ -54,11 +88,22 @@ public:
 
     /**
      * @brief 获取最终生效的状态集合 (所有层级合并后的结果)
-     * @return 一个包含最终生效状态的 FSyStateCategories 副本。
-     * @note 使用缓存机制，性能已优化
+     * @return 缓存的最终状态的常量引用，状态下次变化前有效。
+     * @note 只读取个别标签时使用 FindEffectiveStateMetadata / GetEffectiveStateValue，不需要合并全部标签
      */
     UFUNCTION(BlueprintPure, Category = "SyState|Access", meta=(DisplayName="Get Effective State Categories"))
-    FSyStateCategories GetEffectiveStateCategories() const;
+    const FSyStateCategories& GetEffectiveStateCategories() const;
+
+    /**
+     * @brief 获取指定标签最终生效的第一个指定类型的元数据（按层级从高到低查找，不拷贝状态）
+     * @param StateTag 状态标签
+     * @return 找到的元数据对象，找不到返回 nullptr
+     */
+    template<typename T = USyStateMetadataBase>
+    T* FindEffectiveStateMetadata(const FGameplayTag& StateTag) const
+    {
+        return LayeredState.FindEffectiveStateMetadata<T>(StateTag);
+    }
 
     /**
      * @brief 获取分层状态容器的直接访问
@@ -79,7 +124,7 @@ public:
 
     /**
      * @brief 获取指定标签最终生效的第一个特定类型的元数据值。
-     * @tparam T 期望获取的元数据内部值的类型 (e.g., bool, float, FVector)。
+     * @tparam T 期望获取的元数据内部值的类型 (e.g., FSyBoolValue, FSyFloatValue)。
      * @param StateTag 要查找的状态标签。
      * @param OutValue 如果找到且类型匹配，则填充值。
      * @return 如果成功找到并获取到正确类型的值，返回 true。
@@ -87,6 +132,18 @@ public:
     template<typename T>
     bool GetEffectiveStateValue(FGameplayTag StateTag, T& OutValue) const;
 
+    /**
+     * @brief 创建单个状态值的读取句柄（每帧读取时使用，版本未变时不再查找与拷贝）
+     * @tparam T 值类型 (e.g., FSyFloatValue)
+     * @param StateTag 状态标签
+     * @note 句柄不能比本组件活得更久
+     */
+    template<typename T>
+    FSyStateValueHandle<T> MakeStateValueHandle(const FGameplayTag& StateTag) const
+    {
+        return FSyStateValueHandle<T>(LayeredState, StateTag);
+    }
+
     // --- 配置 ---
     /**
      * @brief 实体状态的初始化数据。
@@ -132,21 +189,97 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SyState|Config", meta=(DisplayName="Enable Global Sync"))
     bool bEnableGlobalSync = true;
 
-    // TODO: [拓展] 本地状态变更事件 
-    /** 当本地状态数据实际发生变化时广播。
+    /**
+     * @brief 运行时以紧凑值结构体保存各层状态，不为每个值创建元数据 UObject（大量实体的关卡使用）
+     * 元数据对象只在读取 GetStateLayer / GetEffectiveStateCategories / FindEffectiveStateMetadata 时按需生成，
+     * 逻辑代码应使用 GetEffectiveStateValue / GetEffectiveStateParam 读取。初始化前设置有效。
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SyState|Config", meta=(DisplayName="Use Packed Value Storage"))
+    bool bUsePackedValueStorage = false;
+
+    /**
+     * @brief 初始化数据相同的实体共享同一份 Default 层（写时复制）
+     * 关卡中大量摆放同一蓝图时只构建一次默认状态；某个实体写入 Default 层时才拷贝出私有的一份。
+     * 默认关闭：元数据对象存储下 FindEffectiveStateMetadata 等返回的对象可能属于共享层，
+     * 直接修改会同时改变所有共享该层的实体。只在逻辑代码不修改返回的元数据对象时开启。
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SyState|Config", meta=(DisplayName="Share Default Layer"))
+    bool bShareDefaultLayer = false;
+
+    /**
+     * @brief StateManager 使用延迟通知时，收到的变化交给 USyStateUpdateSubsystem 在帧末与其它实体一起批量同步
+     * 紧凑存储（bUsePackedValueStorage）的实体在工作线程中并行应用，事件仍在游戏线程派发。
+     * StateManager 为立即通知模式时始终立即同步。
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SyState|Config", meta=(DisplayName="Use Batched State Update"))
+    bool bUseBatchedStateUpdate = true;
+
+    /** 当本地状态数据实际发生变化时广播（不携带变化内容，只关心部分标签时请使用下面的按标签事件）。
      *  注意：这与 StateManager 的记录事件不同，这个事件表示本地状态数据已被修改。
-     *  参数可以设计为传递变化的具体 StateTag 和对应的 Metadata 对象，或者更简单的只通知"状态已变"。
-     *  为了简化，我们先定义一个无参数的委托。
      */
     DECLARE_MULTICAST_DELEGATE(FOnEffectiveStateChanged);
     FOnEffectiveStateChanged OnEffectiveStateChanged;
 
+    /** 有效状态变化时广播，携带变化的标签与层级；只修改被更高层遮盖的标签不会触发 */
+    DECLARE_MULTICAST_DELEGATE_OneParam(FOnEffectiveStateTagsChanged, const FSyEffectiveStateChange& /*Change*/);
+    FOnEffectiveStateTagsChanged OnEffectiveStateTagsChanged;
+
+    /** 单个状态标签的有效状态变化事件 */
+    DECLARE_MULTICAST_DELEGATE_OneParam(FOnStateTagChanged, const FGameplayTag& /*StateTag*/);
+
+    /**
+     * @brief 获取某个状态标签的变化事件，只在该标签的有效状态可能改变时广播
+     * @param StateTag 关心的状态标签（精确匹配）
+     */
+    FOnStateTagChanged& OnStateTagChanged(const FGameplayTag& StateTag);
+
+    /**
+     * @brief 移除某个对象在所有按标签事件上的绑定
+     * @param UserObject 绑定时使用的对象
+     */
+    void RemoveStateTagListeners(const void* UserObject);
+
 protected:
     //~ Begin UActorComponent Interface
     virtual void BeginPlay() override;
     virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     //~ End UActorComponent Interface
 
+    //~ Begin UObject Interface
+    static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+    //~ End UObject Interface
+
+    /** 按 bShareDefaultLayer 以共享或私有方式设置 Default 层 */
+    void ApplyDefaultLayer(const FSyStateParameterSet& InitData);
+
+    // --- 批量同步（由 USyStateUpdateSubsystem 调用） ---
+    friend class USyStateUpdateSubsystem;
+
+    /**
+     * @brief 取本实体相关的最新快照并与上次应用的快照比较（游戏线程）
+     * @param OutRequest 需要同步的快照与状态标签
+     * @return 有需要应用的变化时返回 true
+     */
+    bool PrepareSnapshotSync(FSyStateSyncRequest& OutRequest);
+
+    /**
+     * @brief 把快照变化写入 Persistent 层（不广播）
+     * @note 只访问本组件的分层容器；CanApplySnapshotSyncInParallel 为 true 时可在工作线程中调用
+     */
+    void ApplySnapshotSync(const FSyStateSyncRequest& Request);
+
+    /** 紧凑存储不创建元数据对象，同步可在工作线程中进行 */
+    bool CanApplySnapshotSyncInParallel() const { return LayeredState.UsesPackedValueStorage(); }
+
+    /** 取出累积的有效状态变化（可在工作线程中调用） */
+    bool ConsumeEffectiveStateChange(FSyEffectiveStateChange& OutChange) { return LayeredState.ConsumeEffectiveChanges(OutChange); }
+
+    /**
+     * @brief 把一次有效状态变化广播给各类监听者（游戏线程）
+     * @param Change 变化内容；全部标签变化时 ChangedTags 会被清空
+     */
+    void DispatchEffectiveStateChange(FSyEffectiveStateChange& Change);
+
     /** 分层状态容器 - 使用层级系统管理状态
      *  - Default 层：初始化数据
      *  - Persistent 层：从 StateManager 同步的全局状态
@@ -165,15 +298,33 @@ private:
     UPROPERTY(Transient)
     TObjectPtr<USyEntityComponent> EntityComponent;
 
+    /** 已注册的批量同步子系统（未启用批量同步时为空） */
+    UPROPERTY(Transient)
+    TObjectPtr<USyStateUpdateSubsystem> StateUpdateSubsystem;
+
     /** 标记状态组件是否已完全初始化（包括默认数据和全局同步） */
     bool bIsFullyInitialized = false;
 
+    /** 最近一次应用到 Persistent 层的共享快照，按路由范围（类型 / 别名 / 实体）存放 */
+    FSyStateSnapshotPtr AppliedSnapshots[(int32)ESyStateTargetScope::Num];
+
+    /** 是否已经从 StateManager 同步过一次 */
+    bool bHasSyncedSnapshots = false;
+
+    /** 按标签的变化事件（共享引用：广播过程中新增订阅不会使正在广播的委托失效） */
+    TMap<FGameplayTag, TSharedRef<FOnStateTagChanged>> StateTagListeners;
+
+    /**
+     * @brief 取出 LayeredState 累积的变化并广播给各类监听者
+     * @param bAllTags 视为全部标签都已变化（初始广播）
+     */
+    void BroadcastEffectiveStateChanges(bool bAllTags = false);
+
     /**
-     * @brief 处理从 StateManager 接收到的新状态修改记录。
-     * @param NewRecord 新记录。
+     * @brief 处理从 StateManager 接收到的合并变化通知（每个派发周期一次）。
+     * @param Change 本目标在该周期内的合并变化。
      */
-    UFUNCTION()
-    void HandleStateModificationChanged(const FSyStateModificationRecord& ChangedRecord);
+    void HandleTargetStateChanged(const FSyTargetStateChange& Change);
 
     /**
      * @brief 尝试连接到 StateManager 并订阅事件。
@@ -186,34 +337,28 @@ private:
     void DisconnectFromStateManager();
 
     /**
-     * @brief 应用聚合后的状态修改到本地状态。
-     *        内部会调用 FSyStateCategories 的 ApplyStateModifications 方法。
+     * @brief 将 StateManager 中本实体相关的最新快照同步到 Persistent 层。
+     *        按 类型（含父类型） < 别名 < 实体ID 的优先级合并，只更新发生变化或被移除的状态标签。
+     * @return 如果 Persistent 层发生了变化，返回 true。
      */
-    void ApplyAggregatedModifications();
+    bool ApplyAggregatedModifications();
+
+    /**
+     * @brief 获取本实体在各路由范围下的目标键（未配置的范围返回无效键）
+     * @param OutKeys 按 ESyStateTargetScope 索引的目标键
+     */
+    void GetStateTargetKeys(FSyStateTargetKey (&OutKeys)[(int32)ESyStateTargetScope::Num]) const;
 
     /**
      * @brief 查找并缓存关联的EntityComponent
      */
     void FindAndCacheEntityComponent();
-
-    // TODO: [拓展] 可能需要一个 Entity ID (FGuid) 来更精确地匹配 StateManager 中的目标。
-    // 这个 ID 可以由外部系统设置，或者自动生成。
-    // UPROPERTY(...) FGuid EntityId;
 };
 
 // Template implementation for GetEffectiveStateValue
 template<typename T>
 bool USyStateComponent::GetEffectiveStateValue(FGameplayTag StateTag, T& OutValue) const
 {
-    FInstancedStruct ParamStruct;
-    if (GetEffectiveStateParam(StateTag, ParamStruct))
-    {
-        if (const T* ValuePtr = ParamStruct.GetPtr<T>())
-        {
-            OutValue = *ValuePtr;
-            return true;
-        }
-        // Optional: Log type mismatch warning?
-    }
-    return false;
+    // 只查找胜出层中该标签的值，不合并其余标签（紧凑存储时直接读取值结构体）
+    return LayeredState.GetEffectiveValue(StateTag, OutValue);
 }
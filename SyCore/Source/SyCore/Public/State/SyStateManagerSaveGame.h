@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/SaveGame.h"
 #include "StateModificationRecord.h" // 包含记录的定义
+#include "StateCompaction.h"
 #include "SyStateManagerSaveGame.generated.h"
 
 /**
@@ -20,6 +21,14 @@ public:
     UPROPERTY(VisibleAnywhere, Category = Basic)
     TArray<FSyStateModificationRecord> SavedModificationLog;
 
+    /** 日志压缩产生的各目标检查点（1.1 起） */
+    UPROPERTY(VisibleAnywhere, Category = Basic)
+    TArray<FSyStateTargetCheckpoint> SavedCheckpoints;
+
+    /** 保存时的有效期游戏时钟（秒），读档后游戏时间有效期从这里继续计时（1.2 起） */
+    UPROPERTY(VisibleAnywhere, Category = Basic)
+    double SavedExpiryGameClockSeconds = 0.0;
+
     /** 存档标识符 (可选，用于版本控制或识别) */
     UPROPERTY(VisibleAnywhere, Category = Basic)
     FString SaveGameVersion = TEXT("1.0");
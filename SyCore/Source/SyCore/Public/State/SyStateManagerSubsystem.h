@@ -7,16 +7,28 @@
 #include "Delegates/DelegateCombinations.h"
 #include "State/StateModificationRecord.h"
 #include "State/Types/StateParameterTypes.h"
+#include "State/StateSnapshot.h"
+#include "State/StateTargetKey.h"
+#include "State/StateRecordQuery.h"
+#include "State/StateCompaction.h"
+#include "State/StateJournal.h"
+#include "State/StateLogFile.h"
+#include "State/StatePayloadPool.h"
+#include "Async/Future.h"
 #include "GameplayTagContainer.h"
 #include "Templates/Function.h"
 #include "Kismet/GameplayStatics.h"
 #include "GameFramework/SaveGame.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Engine/World.h"
 #include "State/Operations/OperationTypes.h" // Needed for FSyOperationSource in new functions
 #include "SyStateManagerSubsystem.generated.h"
 
 // Forward declaration FSyOperation
 struct FSyOperation;
+class USaveGame;
+class USyStateManagerSaveGame;
 
 /**
  * @brief 状态修改记录发生变化（添加或移除）时的委托
@@ -28,6 +40,78 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateModificationChanged, const F
 // 普通委托 - 用于 C++ 智能订阅（支持 Bind 和 Execute）
 DECLARE_DELEGATE_OneParam(FOnStateModificationChangedNative, const FSyStateModificationRecord&);
 
+// 动态单播委托 - 异步存档 / 读档完成
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnStateLogAsyncComplete, bool, bSuccess);
+
+// 动态多播委托 - 日志压缩完成
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnStateLogCompacted, const FSyStateCompactionStats&, Stats);
+
+class USyStateManagerSubsystem;
+
+/**
+ * @brief 通知派发模式
+ */
+UENUM(BlueprintType)
+enum class ESyStateNotificationMode : uint8
+{
+    /** 立即派发：每次记录/卸载（或最外层批处理提交）后同步通知订阅者 */
+    Immediate UMETA(DisplayName = "Immediate"),
+
+    /** 延迟派发：只标记脏目标，每帧在指定 TickGroup 中统一派发一次 */
+    Deferred UMETA(DisplayName = "Deferred (Per Frame)")
+};
+
+/**
+ * @brief 一次派发中单个目标的合并变化
+ *        同一目标在一次派发周期内的多条记录会合并为一个通知。
+ */
+struct FSyTargetStateChange
+{
+    /** 发生变化的目标（类型 / 别名 / 实体） */
+    FSyStateTargetKey Target;
+
+    /** 本周期内所有相关记录涉及的状态标签（并集） */
+    FGameplayTagContainer ChangedStateTags;
+
+    /** 本周期内该目标的最后一条变化记录 */
+    FSyStateModificationRecord LastRecord;
+
+    /** 本周期内该目标合并的记录数量 */
+    int32 NumRecords = 0;
+};
+
+/**
+ * @brief 操作日志的持久化方式
+ */
+UENUM(BlueprintType)
+enum class ESyStatePersistenceMode : uint8
+{
+    /** 每次 SaveLog 把完整日志写入 SaveGame 槽位 */
+    SaveGame UMETA(DisplayName = "Save Game (Full Log)"),
+
+    /** 记录 / 卸载追加到二进制日志文件，SaveLog 只写入增量，日志文件过大时合并为 SaveGame 快照 */
+    Journal UMETA(DisplayName = "Journal (Append Only)")
+};
+
+// 普通委托 - 合并后的目标变化通知（每个派发周期每个目标一次）
+DECLARE_DELEGATE_OneParam(FOnTargetStateChangedNative, const FSyTargetStateChange&);
+
+/**
+ * @brief 延迟通知模式下，在指定 TickGroup 中派发待处理通知的 Tick 函数
+ *        增量日志压缩与操作到期检查也在此 Tick 中执行。
+ */
+struct FSyStateManagerFlushTickFunction : public FTickFunction
+{
+    /** 所属的状态管理器 */
+    USyStateManagerSubsystem* Owner = nullptr;
+
+    //~ Begin FTickFunction Interface
+    virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+    virtual FString DiagnosticMessage() override;
+    virtual FName DiagnosticContext(bool bDetailed) override;
+    //~ End FTickFunction Interface
+};
+
 /**
  * @brief 状态管理器子系统 (Game Instance Subsystem)
  * 负责记录和移除状态变更操作意图 (FSyOperation) 并广播相关事件。
@@ -45,6 +129,10 @@ public:
     virtual void Deinitialize() override;
     //~ End USubsystem Interface
 
+    //~ Begin UObject Interface
+    static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+    //~ End UObject Interface
+
     // --- Recording Operations --- 
 
     /**
@@ -74,24 +162,213 @@ public:
     UFUNCTION(BlueprintCallable, Category="State Management", meta=(DisplayName="Unload Operations by Source"))
     virtual int32 UnloadOperationsBySource(const FSyOperationSource& SourceToMatch);
 
+    // --- Batching ---
+
+    /**
+     * @brief 开启一个批处理。批处理期间的记录/卸载会立即修改日志与索引，
+     *        但快照重算与事件通知会延迟到最外层 CommitBatch 时统一执行。
+     * @note 支持嵌套，必须与 CommitBatch 成对调用。C++ 中推荐使用 FSyStateManagerBatchScope。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Batch")
+    void BeginBatch();
+
+    /**
+     * @brief 提交批处理。最外层提交时：重算受影响目标的快照，每个受影响目标只通知订阅者一次，
+     *        然后按记录顺序广播 OnStateModificationChanged。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Batch")
+    void CommitBatch();
+
+    /**
+     * @brief 设置通知派发模式
+     * @param NewMode 新模式。切换为 Immediate 时会立即派发所有待处理通知。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Notification")
+    void SetNotificationMode(ESyStateNotificationMode NewMode);
+
+    /** 获取当前通知派发模式 */
+    UFUNCTION(BlueprintPure, Category="State Management|Notification")
+    ESyStateNotificationMode GetNotificationMode() const { return NotificationMode; }
+
+    /**
+     * @brief 设置延迟模式下派发通知所在的 TickGroup（默认 TG_PostUpdateWork）
+     * @param NewTickGroup 新的 TickGroup
+     */
+    void SetDeferredFlushTickGroup(ETickingGroup NewTickGroup);
+
+    /**
+     * @brief 立即派发所有待处理的延迟通知（例如存档前需要状态同步完成时）
+     * @note 批处理中调用无效。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Notification")
+    void FlushDeferredNotifications();
+
+    /** 当前是否处于批处理中 */
+    UFUNCTION(BlueprintPure, Category="State Management|Batch")
+    bool IsInBatch() const { return BatchDepth > 0; }
+
+    /**
+     * @brief 批量记录操作意图。等价于在一个批处理内逐个调用 RecordOperation。
+     * @param Operations 要记录的操作列表
+     * @return 成功记录的操作数量
+     */
+    int32 RecordOperations(TArrayView<const FSyOperation> Operations);
+
+    /**
+     * @brief 批量卸载操作意图。等价于在一个批处理内逐个调用 UnloadOperation。
+     * @param OperationIds 要卸载的操作 ID 列表
+     * @return 成功卸载的操作数量
+     */
+    int32 UnloadOperations(TArrayView<const FGuid> OperationIds);
+
+    /** RecordOperations 的蓝图版本 */
+    UFUNCTION(BlueprintCallable, Category="State Management|Batch", meta=(DisplayName="Record Operations"))
+    int32 K2_RecordOperations(const TArray<FSyOperation>& Operations) { return RecordOperations(Operations); }
+
+    /** UnloadOperations 的蓝图版本 */
+    UFUNCTION(BlueprintCallable, Category="State Management|Batch", meta=(DisplayName="Unload Operations by IDs"))
+    int32 K2_UnloadOperations(const TArray<FGuid>& OperationIds) { return UnloadOperations(OperationIds); }
+
     // --- Querying Operations --- 
 
     /**
      * @brief 获取聚合后的状态修改参数集
-     * @param TargetFilterTag 用于筛选操作的目标类型标签。只有 Target.TargetTypeTag 与此匹配的操作才会被考虑。
+     * @param TargetFilterTag 用于筛选操作的目标类型标签。只有按类型路由（未指定 TargetEntityId / TargetAlias）
+     *                        且 Target.TargetTypeTag 与此匹配的操作才会被考虑。
      *                        如果传入无效 Tag，则不进行目标类型筛选。
      * @return 一个 FSyStateParameterSet，包含了所有通过筛选的操作记录中 Modifier 的 StateModifications 的聚合结果。
+     * @note 内存映射读档后会先在入口处解码需要的目标（内部细节，接口保持 const）。
      */
     UFUNCTION(BlueprintCallable, Category="State Management", meta=(DisplayName="Get Aggregated Modifications"))
     virtual FSyStateParameterSet GetAggregatedModifications(const FGameplayTag& TargetFilterTag /* TODO: 添加 SourceFilterTag */) const;
 
     /**
-     * @brief 获取所有已记录的修改 (简单版本)
+     * @brief 获取指定目标类型的共享聚合快照（C++ 使用，无拷贝）
+     * @param TargetTypeTag 目标类型标签
+     * @return 只读快照的共享指针；该目标从未有过记录时返回空指针
+     * @note 快照不可变，状态变化时会生成新版本快照，未变化的标签条目在新旧版本间共享。
+     *       批处理期间返回的是上一次提交后的快照。
+     *       内存映射读档后目标尚未解码时先解码（追加日志、重建该目标的索引与快照），因此不是 const 接口。
+     */
+    FSyStateSnapshotPtr GetSnapshot(const FGameplayTag& TargetTypeTag)
+    {
+        return GetSnapshot(FSyStateTargetKey::FromType(TargetTypeTag));
+    }
+
+    /**
+     * @brief 获取指定目标（类型 / 别名 / 实体ID）的共享聚合快照
+     * @param TargetKey 目标路由键
+     * @return 只读快照的共享指针；该目标从未有过记录时返回空指针
+     */
+    FSyStateSnapshotPtr GetSnapshot(const FSyStateTargetKey& TargetKey);
+
+    /**
+     * @brief 获取目标类型的层级有效快照：按 根 -> 自身 的顺序合并该类型及其所有父标签的快照。
+     *        例如针对 Entity.NPC 的操作也会出现在 Entity.NPC.Merchant 的有效快照中。
+     * @param TargetTypeTag 目标类型标签
+     * @return 只读快照；祖先链上都没有记录时返回空指针
+     * @note 结果预先计算并缓存，仅在祖先链上某个类型的快照变化时重建，读取为 O(1)。
+     *       只有一个祖先有记录时直接复用该快照，不产生拷贝。内存映射读档后先解码整条祖先链。
+     */
+    FSyStateSnapshotPtr GetEffectiveTypeSnapshot(const FGameplayTag& TargetTypeTag);
+
+    // --- Versioned Reads ---
+
+    /** 当前全局版本号（每发布一个新快照递增），读取方记录后可作为 GetSnapshotIfChanged 的起点 */
+    UFUNCTION(BlueprintPure, Category="State Management|Version")
+    int32 GetCurrentVersion() const { return GlobalVersion; }
+
+    /**
+     * @brief 仅当目标的快照在指定版本之后变化过时返回快照
+     * @param TargetKey 目标路由键
+     * @param SinceVersion 调用方上次读取时的版本号（快照版本或 GetCurrentVersion）
+     * @return 快照版本大于 SinceVersion 时返回快照；未变化或该目标从未有过快照时返回空指针
+     */
+    FSyStateSnapshotPtr GetSnapshotIfChanged(const FSyStateTargetKey& TargetKey, int32 SinceVersion);
+
+    /**
+     * @brief 获取目标在指定版本时生效的快照（调试 / 回滚用）
+     * @param TargetKey 目标路由键
+     * @param Version 全局版本号
+     * @param OutSnapshot 该版本时生效的快照；当时该目标没有任何状态时为空指针
+     * @return 历史覆盖该版本时返回 true；该版本的快照已被淘汰时返回 false
+     * @note 每个目标保留最近若干个快照（SetSnapshotHistoryLength，默认 16）。历史快照之间共享未变化的条目，
+     *       保留历史只增加条目表的指针，不会拷贝参数。
+     */
+    bool GetSnapshotAtVersion(const FSyStateTargetKey& TargetKey, int32 Version, FSyStateSnapshotPtr& OutSnapshot);
+
+    /**
+     * @brief 蓝图版本：目标类型的快照在指定版本之后变化过时输出聚合结果
+     * @param TargetTypeTag 目标类型标签
+     * @param SinceVersion 调用方上次读取时的版本号
+     * @param OutModifications 聚合结果（仅在返回 true 时有效）
+     * @param OutVersion 快照的版本号，下次调用时作为 SinceVersion
+     * @return 有变化返回 true
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Version", meta=(DisplayName="Get Aggregated Modifications If Changed"))
+    bool K2_GetAggregatedModificationsIfChanged(FGameplayTag TargetTypeTag, int32 SinceVersion, FSyStateParameterSet& OutModifications, int32& OutVersion);
+
+    /**
+     * @brief 蓝图版本：目标类型在指定版本时的聚合结果
+     * @param TargetTypeTag 目标类型标签
+     * @param Version 全局版本号
+     * @param OutModifications 聚合结果
+     * @return 历史覆盖该版本时返回 true
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Version", meta=(DisplayName="Get Aggregated Modifications At Version"))
+    bool K2_GetAggregatedModificationsAtVersion(FGameplayTag TargetTypeTag, int32 Version, FSyStateParameterSet& OutModifications);
+
+    /**
+     * @brief 设置每个目标保留的历史快照数量（含当前快照）
+     * @param NewLength 数量；0 表示不保留历史（GetSnapshotAtVersion 只能回答当前快照生效期间的版本）
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Version")
+    void SetSnapshotHistoryLength(int32 NewLength);
+
+    /**
+     * @brief 获取所有已记录的修改 (简单版本，C++ 使用)
      * @return 日志中所有记录的常量引用。
+     * @note 已驻留的记录的修改保存在共享载荷中，Operation.Modifier.StateModifications 为空，
+     *       请通过 FSyStateModificationRecord::GetStateModifications 读取。
+     *       蓝图无法调用 GetStateModifications，因此本接口不暴露给蓝图，蓝图请使用 GetAllModificationsExpanded。
+     *       内存映射读档后先在入口处解码全部目标（内部细节，接口保持 const）。
      */
-    UFUNCTION(BlueprintPure, Category="State Management", meta=(DisplayName="Get All Modifications (Simple)"))
     virtual const TArray<FSyStateModificationRecord>& GetAllModifications_Simple() const;
 
+    /**
+     * @brief 获取所有已记录的修改的副本，修改载荷内联到 Operation 中（蓝图读取完整日志使用）
+     * @return 日志中所有记录的副本（拷贝每条记录的修改，开销与日志大小成正比）
+     */
+    UFUNCTION(BlueprintPure, Category="State Management", meta=(DisplayName="Get All Modifications (Expanded)"))
+    TArray<FSyStateModificationRecord> GetAllModificationsExpanded() const;
+
+    /**
+     * @brief 按条件查询修改记录（C++ 使用，不拷贝记录）
+     *        优先使用 状态标签 / 来源标签 / 来源实体 的倒排索引中候选最少的一个，再按其余条件过滤。
+     * @param Query 查询条件
+     * @return 匹配记录的只读视图，日志被修改后失效
+     * @note 内存映射读档后先解码全部目标，因此不是 const 接口。
+     */
+    FSyStateRecordView QueryRecords(const FSyStateRecordQuery& Query);
+
+    /**
+     * @brief QueryRecords 的蓝图版本（会拷贝匹配的记录）
+     * @param StateTag 修改了此状态标签的记录（无效则不过滤）
+     * @param SourceTag 来源类型标签（无效则不过滤）
+     * @param SourceEntityId 来源实体ID（无效则不过滤）
+     * @param MinTimestamp 最早时间（UTC）
+     * @param MaxTimestamp 最晚时间（UTC），不大于 MinTimestamp 时不限制时间
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Query", meta=(DisplayName="Query Records"))
+    TArray<FSyStateModificationRecord> K2_QueryRecords(FGameplayTag StateTag, FGameplayTag SourceTag, FGuid SourceEntityId, FDateTime MinTimestamp, FDateTime MaxTimestamp);
+
+    /**
+     * @brief 将一组参数按聚合规则合并到已有参数中（列表类型追加，数值修饰累积，其余类型覆盖）
+     * @param ExistingParams 已有参数（输出）
+     * @param ParamsToMerge 要合并的参数
+     */
+    static void MergeStateParams(TArray<FInstancedStruct>& ExistingParams, const TArray<FInstancedStruct>& ParamsToMerge);
+
     // --- Events --- 
 
     /** 当状态修改被记录或卸载时广播（全局事件，用于蓝图或需要监听所有变更的场景）
@@ -112,6 +389,37 @@ public:
         FGameplayTag TargetTypeTag, 
         UObject* Subscriber,
         FOnStateModificationChangedNative Delegate);
+
+    /**
+     * @brief 订阅特定目标类型的合并变化通知（C++ 使用）
+     *        每个派发周期每个目标只回调一次，并携带本周期内变化的状态标签并集。
+     * @param TargetTypeTag 要订阅的目标类型标签
+     * @param Subscriber 订阅者对象
+     * @param Delegate 回调委托
+     */
+    void SubscribeToTargetType(
+        FGameplayTag TargetTypeTag, 
+        UObject* Subscriber,
+        FOnTargetStateChangedNative Delegate);
+
+    /**
+     * @brief 订阅指定目标（类型 / 别名 / 实体ID）的合并变化通知（C++ 使用）
+     *        携带 TargetEntityId 或 TargetAlias 的操作只会通知对应键的订阅者。
+     * @param TargetKey 目标路由键
+     * @param Subscriber 订阅者对象
+     * @param Delegate 回调委托
+     */
+    void SubscribeToTarget(
+        const FSyStateTargetKey& TargetKey,
+        UObject* Subscriber,
+        FOnTargetStateChangedNative Delegate);
+
+    /**
+     * @brief 取消订阅指定目标
+     * @param TargetKey 目标路由键
+     * @param Subscriber 订阅者对象
+     */
+    void UnsubscribeFromTarget(const FSyStateTargetKey& TargetKey, UObject* Subscriber);
     
     /**
      * @brief 取消订阅特定目标类型的状态修改
@@ -144,6 +452,152 @@ public:
     UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
     bool LoadLog();
 
+    /**
+     * @brief SaveLog 的异步版本：写入同一 SaveGame 槽位。游戏线程只拷贝记录与检查点，
+     *        载荷内联、序列化与经 ISaveGameSystem 写盘在工作线程执行
+     * @param OnComplete 完成回调（游戏线程）
+     * @return 已开始返回 true；已有异步存档 / 读档进行中时返回 false
+     * @note Journal 模式下与 SaveLog 相同，只同步追加增量，回调在下一次游戏线程任务中执行。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    bool SaveLogAsync(const FOnStateLogAsyncComplete& OnComplete);
+
+    /**
+     * @brief LoadLog 的异步版本：经 ISaveGameSystem 在工作线程读取并反序列化同一 SaveGame 槽位，
+     *        完成后在游戏线程替换日志与检查点、回放 Journal，重建全部索引与快照并通知订阅者
+     * @param OnComplete 完成回调（游戏线程）
+     * @return 已开始返回 true；已有异步存档 / 读档进行中时返回 false
+     * @note 读取期间记录、且完成时仍未被卸载的操作会在读取结果之上重新记录（Journal 模式下重新追加到日志文件），
+     *       不会因替换日志而丢失；读取期间的其它修改（卸载、压缩等）被读取结果覆盖（与 LoadLog 语义一致）。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    bool LoadLogAsync(const FOnStateLogAsyncComplete& OnComplete);
+
+    /**
+     * @brief 把完整日志写入供 LoadLogMapped 映射读取的文件：游戏线程只拷贝日志与检查点，序列化、压缩与写盘在工作线程执行
+     * @param OnComplete 完成回调（游戏线程）
+     * @return 已开始返回 true；已有异步存档 / 读档进行中时返回 false
+     * @note 内存映射需要直接访问文件（Saved/SaveGames/<槽位>.sylog），只适用于有可写文件系统的平台；
+     *       该文件与 SaveGame 槽位相互独立，只由 LoadLogMapped 读取。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    bool SaveLogMappedAsync(const FOnStateLogAsyncComplete& OnComplete);
+
+    /** 是否有进行中的异步存档 / 读档 */
+    UFUNCTION(BlueprintPure, Category="State Management|Persistence")
+    bool IsAsyncPersistenceInProgress() const { return bAsyncPersistenceInProgress; }
+
+    /**
+     * @brief 以内存映射方式读取 SaveLogMappedAsync 写入的日志：只解析文件目录，各目标的记录在首次访问时才解码
+     * @return 读取成功返回 true；已有异步存档 / 读档进行中或文件不存在时返回 false
+     * @note 已有快照、订阅者或层级快照的目标立即解码并通知；其余目标在 GetSnapshot、订阅、记录新操作等
+     *       首次访问时解码。需要完整日志的接口（按来源卸载、查询、存档、压缩等）会先解码全部目标。
+     *       旧版本文件或平台不支持映射时退化为完整读取。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    bool LoadLogMapped();
+
+    /** 内存映射读档后尚未解码的目标数量 */
+    UFUNCTION(BlueprintPure, Category="State Management|Persistence")
+    int32 GetNumLazyTargets() const { return LazyTargets.Num(); }
+
+    /** 最近一次读档后重建索引与快照的耗时（毫秒） */
+    UFUNCTION(BlueprintPure, Category="State Management|Persistence")
+    float GetLastRebuildTimeMs() const { return LastRebuildTimeMs; }
+
+    /**
+     * @brief 设置持久化方式
+     * @param NewMode 新方式。切换为 Journal 时会先写入一次完整快照，之后的变化以增量追加。
+     * @note 离开 Journal 模式（以及子系统反初始化）时不会自动存档，尚未 SaveLog 的增量被丢弃。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    void SetPersistenceMode(ESyStatePersistenceMode NewMode);
+
+    /** 获取当前持久化方式 */
+    UFUNCTION(BlueprintPure, Category="State Management|Persistence")
+    ESyStatePersistenceMode GetPersistenceMode() const { return PersistenceMode; }
+
+    /**
+     * @brief 设置日志文件合并阈值：FlushJournal 后日志文件超过此大小时自动合并为快照
+     * @param NewThresholdBytes 阈值（字节）
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    void SetJournalCompactionThreshold(int64 NewThresholdBytes) { JournalCompactionThresholdBytes = FMath::Max<int64>(NewThresholdBytes, 0); }
+
+    /**
+     * @brief 把缓冲的日志条目追加写入日志文件（Journal 模式下 SaveLog 的实现）
+     * @return 写入成功返回 true；非 Journal 模式返回 false
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    bool FlushJournal();
+
+    /**
+     * @brief 把当前完整日志写入 SaveGame 快照并清空日志文件
+     * @return 成功返回 true；非 Journal 模式返回 false
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Persistence")
+    bool CompactJournal();
+
+    // --- Compaction ---
+
+    /**
+     * @brief 同步压缩整个日志：被同一目标后续记录完全覆盖的参数值折叠进该目标的检查点。
+     *        列表类型参数（追加聚合）不会被折叠；参数被全部折叠的记录保留为存根，仍可按操作ID / 来源卸载。
+     * @return 本次压缩的统计结果
+     * @note 压缩不改变任何目标的聚合结果，也不派发通知。
+     *       每个贡献者的被覆盖值都按时间顺序保留在检查点中：卸载覆盖它们的记录时，
+     *       回退到仍存在的最新贡献者的值，与未压缩时一致。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Compaction")
+    FSyStateCompactionStats CompactLog();
+
+    /**
+     * @brief 开始增量压缩：在派发 Tick 中分帧处理，每帧最多检查约 RecordsPerFrame 条记录（以目标为单位）。
+     *        完成时广播 OnLogCompacted。没有可用的 Tick 时退化为同步压缩。
+     * @param RecordsPerFrame 每帧记录预算
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Compaction")
+    void StartIncrementalCompaction(int32 RecordsPerFrame = 256);
+
+    /** 是否有进行中的增量压缩 */
+    UFUNCTION(BlueprintPure, Category="State Management|Compaction")
+    bool IsCompacting() const { return PendingCompactionTargets.Num() > 0; }
+
+    /** 最近一次完成的压缩统计 */
+    UFUNCTION(BlueprintPure, Category="State Management|Compaction")
+    const FSyStateCompactionStats& GetLastCompactionStats() const { return LastCompactionStats; }
+
+    /**
+     * @brief 获取目标的检查点（C++ 使用）
+     * @param TargetKey 目标路由键
+     * @return 检查点中的折叠值；该目标没有检查点时返回 nullptr
+     * @note 内存映射读档后目标尚未解码时先解码；解码其它目标或压缩后返回的指针失效。
+     */
+    const TArray<FSyStateCheckpointEntry>* FindCheckpoint(const FSyStateTargetKey& TargetKey)
+    {
+        MaterializeTarget(TargetKey);
+        return Checkpoints.Find(TargetKey);
+    }
+
+    /** 日志压缩完成时广播 */
+    UPROPERTY(BlueprintAssignable, Category="State Management|Events")
+    FOnStateLogCompacted OnLogCompacted;
+
+    // --- Expiry ---
+
+    /**
+     * @brief 卸载所有已到期的操作（设置了 FSyOperation::Expiry 的操作）
+     * @return 本次卸载的操作数量
+     * @note 派发 Tick 在有待到期操作时每帧自动调用；所有到期操作在同一个批处理中卸载，
+     *       每个受影响目标只收到一次合并通知。
+     */
+    UFUNCTION(BlueprintCallable, Category="State Management|Expiry")
+    int32 ExpireDueOperations();
+
+    /** 尚未到期的带有效期操作数量 */
+    UFUNCTION(BlueprintPure, Category="State Management|Expiry")
+    int32 GetNumScheduledExpiries() const { return ExpiryDeadlines.Num(); }
+
     // TODO: [拓展] 查询优化接口
     // TODO: [拓展] 网络同步支持
 
@@ -151,27 +605,128 @@ private:
     /** 存储所有状态修改记录的日志 (运行时 + 从存档加载) */
     UPROPERTY(Transient)
     TArray<FSyStateModificationRecord> ModificationLog;
+
+    /** 日志中记录的修改载荷池：内容相同的修改只保存一份 */
+    FSyStatePayloadPool PayloadPool;
     
     // ===== 性能优化：索引和缓存 =====
     
-    /** 按目标类型索引的记录 - 加速查询 
-     *  注意：不能使用 UPROPERTY，因为 UE 不支持嵌套容器 TMap<Tag, TArray<int32>>
+    /** 按目标（类型 / 别名 / 实体ID）索引的记录 - 加速查询 
+     *  注意：不能使用 UPROPERTY，因为 UE 不支持嵌套容器 TMap<Key, TArray<int32>>
      */
-    TMap<FGameplayTag, TArray<int32>> TargetTypeIndex;
+    TMap<FSyStateTargetKey, TArray<int32>> TargetIndex;
     
     /** 按操作ID索引的记录 - 加速卸载操作 */
     TMap<FGuid, int32> OperationIdIndex;
+
+    /** 倒排索引：状态标签 -> 修改了该标签的记录（按记录先后顺序） */
+    TMap<FGameplayTag, TArray<int32>> StateTagIndex;
+
+    /** 倒排索引：来源类型标签 -> 记录 */
+    TMap<FGameplayTag, TArray<int32>> SourceTagIndex;
+
+    /** 倒排索引：来源实体ID -> 记录 */
+    TMap<FGuid, TArray<int32>> SourceEntityIndex;
     
-    /** 聚合结果缓存 - 避免重复计算 
+    /** 已发布的聚合快照 - 所有订阅同一目标的组件共享同一份只读数据
      *  注意：不能使用 UPROPERTY，因为缓存是临时数据且包含复杂类型
      */
-    TMap<FGameplayTag, FSyStateParameterSet> AggregatedCache;
-    
-    /** 缓存版本号 - 用于缓存失效 */
-    TMap<FGameplayTag, int32> CacheVersions;
+    TMap<FSyStateTargetKey, FSyStateSnapshotPtr> SnapshotCache;
+
+    /** 批处理期间正在构建的快照（尚未发布，可原地修改），提交时发布到 SnapshotCache */
+    TMap<FSyStateTargetKey, TSharedPtr<FSyStateSnapshot>> WorkingSnapshots;
     
-    /** 全局版本号 - 每次记录操作时递增 */
+    /** 层级有效快照缓存：类型标签 -> 祖先链合并后的快照（读取时按需创建，祖先变化时在派发前重建） */
+    mutable TMap<FGameplayTag, FSyStateSnapshotPtr> EffectiveTypeSnapshotCache;
+
+    /** 类型标签的祖先链缓存（根在前，自身在最后） */
+    mutable TMap<FGameplayTag, TArray<FGameplayTag>> TypeAncestryCache;
+
+    /** 全局版本号 - 每生成一个新快照时递增，作为快照版本号 */
     int32 GlobalVersion = 0;
+
+    /** 单个目标的快照历史 */
+    struct FSnapshotHistory
+    {
+        /** 已发布的快照（旧 -> 新，最后一个为当前快照） */
+        TArray<FSyStateSnapshotPtr> Snapshots;
+
+        /** 早于此版本的快照已被淘汰 */
+        int32 EvictedBeforeVersion = 0;
+    };
+
+    /** 各目标的快照历史 */
+    TMap<FSyStateTargetKey, FSnapshotHistory> SnapshotHistory;
+
+    /** 每个目标保留的历史快照数量 */
+    int32 MaxSnapshotHistory = 16;
+
+    /** 发布目标的新快照并记入历史 */
+    void PublishSnapshot(const FSyStateTargetKey& TargetKey, FSyStateSnapshotPtr Snapshot);
+
+    // ===== 日志压缩 =====
+
+    /** 各目标的检查点：聚合时先于该目标的记录应用 */
+    TMap<FSyStateTargetKey, TArray<FSyStateCheckpointEntry>> Checkpoints;
+
+    /** 增量压缩尚未处理的目标 */
+    TArray<FSyStateTargetKey> PendingCompactionTargets;
+
+    /** 增量压缩每帧的记录预算 */
+    int32 CompactionRecordsPerFrame = 256;
+
+    /** 进行中的增量压缩统计 */
+    FSyStateCompactionStats ActiveCompactionStats;
+
+    /** 最近一次完成的压缩统计 */
+    FSyStateCompactionStats LastCompactionStats;
+
+    // ===== 操作有效期 =====
+
+    /** 到期队列条目 */
+    struct FExpiryEntry
+    {
+        double Deadline = 0.0;
+        FGuid OperationId;
+
+        bool operator<(const FExpiryEntry& Other) const { return Deadline < Other.Deadline; }
+    };
+
+    /** 按游戏时间到期的操作（最小堆，时间基准为 ExpiryGameClockSeconds） */
+    TArray<FExpiryEntry> GameTimeExpiryHeap;
+
+    /** 按现实时间到期的操作（最小堆，时间基准为 UTC 秒） */
+    TArray<FExpiryEntry> RealTimeExpiryHeap;
+
+    /** 操作ID -> 当前有效的到期时间；卸载时移除，堆中残留的条目在出堆时跳过 */
+    TMap<FGuid, double> ExpiryDeadlines;
+
+    /** 累计的游戏时间（秒），跨世界切换保持连续，随存档保存 */
+    double ExpiryGameClockSeconds = 0.0;
+
+    /** 上次采样时 Tick 所在世界的游戏时间 */
+    double LastExpiryWorldTimeSeconds = 0.0;
+
+    /** 为带有效期的记录登记到期时间 */
+    void ScheduleExpiry(const FSyStateModificationRecord& Record);
+
+    /** 清空所有到期队列 */
+    void ResetExpiries();
+
+    /** 按 Tick 所在世界的游戏时间推进 ExpiryGameClockSeconds */
+    void AdvanceExpiryGameClock();
+
+    /**
+     * @brief 读档后恢复游戏时钟：取保存时的时钟与日志中最新记录时钟的较大值，并从当前世界时间继续计时
+     * @note 在重建索引（重新登记到期时刻）之前调用。
+     */
+    void RestoreExpiryGameClock(double SavedClockSeconds);
+
+    /** 弹出堆中所有不晚于 Now 的有效条目 */
+    void PopDueExpiries(TArray<FExpiryEntry>& Heap, double Now, TArray<FGuid>& OutOperationIds);
+
+    /** UTC 时间转换为现实时间到期队列使用的秒数 */
+    static double ToRealTimeSeconds(const FDateTime& Time);
     
     // ===== 智能订阅数据结构 =====
     
@@ -179,19 +734,188 @@ private:
     struct FSubscriberInfo
     {
         TWeakObjectPtr<UObject> Subscriber;
-        FOnStateModificationChangedNative Delegate;  // 使用普通委托
+        FOnStateModificationChangedNative Delegate;  // 使用普通委托（按记录）
+        FOnTargetStateChangedNative ChangeDelegate;  // 合并变化通知
         
         FSubscriberInfo() = default;
         FSubscriberInfo(UObject* InSubscriber, FOnStateModificationChangedNative InDelegate)
             : Subscriber(InSubscriber)
             , Delegate(InDelegate)
         {}
+        FSubscriberInfo(UObject* InSubscriber, FOnTargetStateChangedNative InChangeDelegate)
+            : Subscriber(InSubscriber)
+            , ChangeDelegate(InChangeDelegate)
+        {}
         
-        bool IsValid() const { return Subscriber.IsValid() && Delegate.IsBound(); }
+        bool IsValid() const { return Subscriber.IsValid() && (Delegate.IsBound() || ChangeDelegate.IsBound()); }
     };
     
-    /** 按目标类型分组的订阅者 - 精准广播 */
-    TMap<FGameplayTag, TArray<FSubscriberInfo>> TargetTypeSubscribers;
+    /** 校验并添加订阅者（同一对象对同一目标只保留一个订阅） */
+    void AddSubscriber(const FSyStateTargetKey& TargetKey, FSubscriberInfo&& Info);
+
+    /** 按目标（类型 / 别名 / 实体ID）分组的订阅者 - 精准广播 */
+    TMap<FSyStateTargetKey, TArray<FSubscriberInfo>> TargetSubscribers;
+
+    // ===== 批处理数据 =====
+
+    /** 批处理嵌套深度，大于 0 时延迟快照重算与通知 */
+    int32 BatchDepth = 0;
+
+    /** 需要在提交时整体重算快照的目标类型（卸载会使增量快照失效） */
+    TSet<FSyStateTargetKey> DirtySnapshotTargets;
+
+    /** 待通知的目标 -> 合并后的变化（每个目标只通知一次） */
+    TMap<FSyStateTargetKey, FSyTargetStateChange> PendingTargetNotifications;
+
+    /** 待全局广播的记录（按发生顺序） */
+    TArray<FSyStateModificationRecord> PendingGlobalBroadcasts;
+
+    // ===== 延迟通知 =====
+
+    /** 通知派发模式 */
+    ESyStateNotificationMode NotificationMode = ESyStateNotificationMode::Immediate;
+
+    /** 延迟模式下派发通知的 Tick 函数（注册到当前游戏世界的 PersistentLevel） */
+    FSyStateManagerFlushTickFunction FlushTickFunction;
+
+    /** Tick 函数当前注册所在的世界 */
+    TWeakObjectPtr<UWorld> FlushTickWorld;
+
+    FDelegateHandle PostWorldInitHandle;
+    FDelegateHandle WorldCleanupHandle;
+
+    // ===== 持久化 =====
+
+    /** 持久化方式 */
+    ESyStatePersistenceMode PersistenceMode = ESyStatePersistenceMode::SaveGame;
+
+    /** Journal 模式下的追加式日志文件 */
+    TUniquePtr<FSyStateJournal> Journal;
+
+    /** 日志文件超过此大小时在 FlushJournal 后合并为快照 */
+    int64 JournalCompactionThresholdBytes = 8 * 1024 * 1024;
+
+    /** 是否有进行中的异步存档 / 读档 */
+    bool bAsyncPersistenceInProgress = false;
+
+    /** 进行中的异步任务（反初始化时等待其完成，避免存档写到一半） */
+    TFuture<void> PendingAsyncTask;
+
+    /** 是否有进行中的 LoadLogAsync */
+    bool bAsyncLoadInProgress = false;
+
+    /** LoadLogAsync 进行中记录的操作，读档替换日志后重新记录 */
+    TArray<FSyOperation> OperationsRecordedDuringAsyncLoad;
+
+    /** 把检查点转换为存档格式 */
+    void BuildSavedCheckpoints(TArray<FSyStateTargetCheckpoint>& OutCheckpoints) const;
+
+    /** 从存档格式恢复检查点 */
+    void RestoreCheckpoints(const TArray<FSyStateTargetCheckpoint>& SavedCheckpoints);
+
+    /**
+     * @brief 移除这些操作折叠进检查点的值（与 RemoveRecordAt 的检查点清理一致，用于不经过它的整体卸载，如 Journal 回放）
+     * @param OperationIds 已卸载的操作
+     */
+    void RemoveCheckpointContributions(const TArray<FGuid>& OperationIds);
+
+    /**
+     * @brief 用读取到的数据整体替换日志与检查点，并重建索引与快照
+     * @param Data 读取到的数据（被移走）
+     */
+    void ApplyLoadedLog(FSyStateLogFileData&& Data);
+
+    /**
+     * @brief 按当前日志重建全部索引，并行重算所有目标的快照，然后通知订阅者
+     * @note 日志被整体替换（LoadLog / LoadLogAsync / LoadLogMapped）后调用。
+     */
+    void RebuildIndicesAndSnapshots();
+
+    /** 最近一次重建耗时（毫秒） */
+    float LastRebuildTimeMs = 0.0f;
+
+    /** 供内存映射读取的日志文件路径 */
+    static FString GetLogFilePath();
+
+    // ===== 内存映射读档 =====
+
+    /** LoadLogMapped 映射的日志文件（仍有未解码目标时保持映射） */
+    TUniquePtr<FSyStateMappedLogFile> MappedLogFile;
+
+    /** 尚未解码的目标 -> 在映射文件目录中的下标 */
+    TMap<FSyStateTargetKey, int32> LazyTargets;
+
+    /** 已解码的文件记录（RecordId）-> 写入时在日志中的位置，全部目标解码后据此恢复全局顺序 */
+    TMap<FGuid, int32> MappedRecordSequence;
+
+    /**
+     * @brief 从映射文件解码一个目标：追加记录、更新索引、恢复检查点并重算快照（不写入 Journal，不派发通知）
+     * @param TargetKey 目标路由键
+     * @return 该目标原本尚未解码时返回 true
+     * @note 会追加日志并改写索引与快照：只在非 const 接口的入口处调用，不要在遍历这些容器时调用。
+     *       最后一个目标解码后把日志恢复为写入时的全局顺序（见 RestoreMappedRecordOrder）。
+     */
+    bool MaterializeTarget(const FSyStateTargetKey& TargetKey);
+
+    /** 解码全部尚未解码的目标（需要完整日志的接口使用） */
+    void MaterializeAllTargets();
+
+    /**
+     * @brief 保持 const 签名的读取接口（GetAggregatedModifications / GetAllModifications_Simple / GetAllModificationsExpanded）使用：解码是其内部细节
+     * @note 只在这些接口的入口、取得任何容器引用之前调用。
+     */
+    void MaterializeTargetForConstRead(const FSyStateTargetKey& TargetKey) const
+    {
+        const_cast<USyStateManagerSubsystem*>(this)->MaterializeTarget(TargetKey);
+    }
+
+    void MaterializeAllTargetsForConstRead() const
+    {
+        const_cast<USyStateManagerSubsystem*>(this)->MaterializeAllTargets();
+    }
+
+    /**
+     * @brief 按目标解码的记录是分组追加的：按写入时的位置重排日志并更新各索引中的位置
+     * @note 读档后新记录的操作排在全部文件记录之后，相互之间保持原有顺序；各目标记录列表的顺序不变。
+     */
+    void RestoreMappedRecordOrder();
+
+    /** 丢弃尚未解码的目标并释放文件映射 */
+    void ReleaseMappedLog();
+
+    /** 构建包含完整日志与检查点的存档对象 */
+    USyStateManagerSaveGame* BuildSaveGameSnapshot();
+
+    /** 创建存档对象并写入检查点、游戏时钟与版本，不含日志记录（SaveLogAsync 在工作线程填充记录） */
+    USyStateManagerSaveGame* CreateSaveGameObject();
+
+    /** 把记录内联载荷后写入存档数组（不访问子系统，可在工作线程调用） */
+    static void InlineRecordsForSave(const TArray<FSyStateModificationRecord>& Records, TArray<FSyStateModificationRecord>& OutSavedRecords);
+
+    /** 把完整日志与检查点写入 SaveGame 槽位 */
+    bool WriteSaveGameSnapshot();
+
+    /**
+     * @brief 用读取到的存档对象替换日志与检查点（不重建索引）
+     * @param OutExpiryGameClockSeconds 存档保存时的有效期游戏时钟（成功时填充）
+     */
+    bool ApplySaveGameSnapshot(USaveGame* LoadedSaveGame, double& OutExpiryGameClockSeconds);
+
+    /**
+     * @brief 读档的公共部分（LoadLog / LoadLogAsync 共用）：应用存档对象、回放 Journal，然后重建索引与快照
+     * @param LoadedSaveGame 读取到的存档对象；槽位不存在或读取失败时为 nullptr（日志被清空）
+     * @return 读取到存档或回放了 Journal 时返回 true
+     */
+    bool FinishLoadLog(USaveGame* LoadedSaveGame);
+
+    /**
+     * @brief LoadLogAsync 在游戏线程的收尾：FinishLoadLog 后重新记录读取期间记录、且仍未被卸载的操作
+     * @param LoadedSaveGame 工作线程读取到的存档对象；槽位不存在或读取失败时为 nullptr
+     */
+    bool FinishLoadLogAsync(USaveGame* LoadedSaveGame);
+
+    /** 日志文件路径（与 SaveGame 槽位同目录） */
+    static FString GetJournalFilePath();
 
     /** 定义存档槽位名称 */
     inline static const FString SaveSlotName = TEXT("SyStateManagerLog");
@@ -199,10 +923,65 @@ private:
     inline static const int32 UserIndex = 0;
 
     /**
-     * @brief 添加记录到日志并广播 OnStateModificationChanged 事件
-     * @param Record 要添加的记录
+     * @brief 记录操作的内部实现：写入日志、更新索引与快照，并登记待通知目标（不直接广播）
+     * @param Operation 要记录的操作
+     * @return 如果记录成功，返回 true
+     */
+    bool RecordOperationInternal(const FSyOperation& Operation);
+
+    /**
+     * @brief 卸载操作的内部实现：移除记录、修正索引、标记快照失效并登记待通知目标（不直接广播）
+     * @param OperationIdToUnload 要卸载的操作 ID
+     * @return 如果找到并移除了记录，返回 true
+     */
+    bool UnloadOperationInternal(const FGuid& OperationIdToUnload);
+
+    /**
+     * @brief 从日志中移除指定位置的记录，并修正因 RemoveAtSwap 被移动的记录的索引
+     * @param Index 记录在 ModificationLog 中的位置
+     * @return 被移除的记录
      */
-    void AddRecordAndBroadcast(const FSyStateModificationRecord& Record);
+    FSyStateModificationRecord RemoveRecordAt(int32 Index);
+
+    /**
+     * @brief 维护查询用倒排索引（状态标签 / 来源标签 / 来源实体）
+     * @param Record 记录
+     * @param OldIndex 记录原位置，INDEX_NONE 表示新增
+     * @param NewIndex 记录新位置，INDEX_NONE 表示移除
+     */
+    void UpdateQueryIndices(const FSyStateModificationRecord& Record, int32 OldIndex, int32 NewIndex);
+
+    /**
+     * @brief 登记一个发生变化的记录，等待批处理提交时统一通知
+     * @param Record 发生变化的记录
+     */
+    void QueueChangeNotification(const FSyStateModificationRecord& Record);
+
+    /**
+     * @brief 重算失效快照并派发所有待处理通知（最外层 CommitBatch 或延迟模式的帧末 Tick 中调用）
+     */
+    void FlushPendingChanges();
+
+    /** 是否存在待派发的变化 */
+    bool HasPendingChanges() const;
+
+    /**
+     * @brief 延迟模式下请求在本帧的 Tick 中派发
+     * @return 如果已安排延迟派发返回 true；没有可用的 Tick 函数时返回 false（调用方应立即派发）
+     */
+    bool ScheduleDeferredFlush();
+
+    /** 在属于本 GameInstance 的游戏世界上注册 / 注销派发 Tick 函数 */
+    void HandlePostWorldInitialization(UWorld* World, const UWorld::InitializationValues IVS);
+    void HandleWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+    void RegisterFlushTickFunction(UWorld* World);
+    void UnregisterFlushTickFunction();
+
+    /** 派发 Tick：派发待处理通知，并推进增量压缩 */
+    void ExecuteFlushTick();
+
+    friend struct FSyStateManagerFlushTickFunction;
+
 
     /**
      * @brief 对传入的操作进行基础验证 (可选)
@@ -221,17 +1000,97 @@ private:
         TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const;
 
     /**
-     * @brief 重新计算指定目标类型的聚合快照
-     * @param TargetTag 目标类型标签
-     * @note 用于卸载操作后刷新快照
+     * @brief 将目标的检查点作为聚合起点写入输出Map（内部辅助方法）
+     * @param TargetKey 目标路由键
+     * @param OutAggregatedMap 输出的聚合Map
+     */
+    void AggregateCheckpoint(
+        const FSyStateTargetKey& TargetKey,
+        TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const;
+
+    /**
+     * @brief 压缩单个目标的记录：从新到旧扫描，被更新记录覆盖的非列表参数折叠进检查点
+     * @param TargetKey 目标路由键
+     * @param Stats 累加统计结果
+     */
+    void CompactTarget(const FSyStateTargetKey& TargetKey, FSyStateCompactionStats& Stats);
+
+    /**
+     * @brief 推进一帧增量压缩
+     * @return 仍有未处理的目标时返回 true
+     */
+    bool StepIncrementalCompaction();
+
+    /**
+     * @brief 结束一次压缩：记录统计、输出日志并广播 OnLogCompacted
+     * @param Stats 本次压缩的统计结果
+     */
+    void FinishCompaction(const FSyStateCompactionStats& Stats);
+
+    /**
+     * @brief 重新计算指定目标的聚合快照
+     * @param TargetKey 目标路由键
+     * @note 用于卸载操作后刷新快照；内容未变化的标签复用旧快照中的条目
+     */
+    void RecalculateSnapshotForTarget(const FSyStateTargetKey& TargetKey);
+
+    /**
+     * @brief 聚合目标的检查点与全部记录（只读，可在工作线程并行调用）
+     * @param TargetKey 目标路由键
+     * @param OutAggregatedMap 输出的聚合Map
+     */
+    void AggregateTargetParams(const FSyStateTargetKey& TargetKey, TMap<FGameplayTag, TArray<FInstancedStruct>>& OutAggregatedMap) const;
+
+    /**
+     * @brief 用聚合结果生成并发布目标的新快照（游戏线程）
+     * @param TargetKey 目标路由键
+     * @param AggregatedMap 聚合结果（被移走）
      */
-    void RecalculateSnapshotForTarget(const FGameplayTag& TargetTag);
+    void PublishRecalculatedSnapshot(const FSyStateTargetKey& TargetKey, TMap<FGameplayTag, TArray<FInstancedStruct>>&& AggregatedMap);
+
+    /** 获取类型标签的祖先链（根在前，自身在最后） */
+    const TArray<FGameplayTag>& GetTypeAncestry(const FGameplayTag& TypeTag) const;
+
+    /** 已发布的快照（不解码，遍历与重建时使用） */
+    FSyStateSnapshotPtr FindSnapshot(const FSyStateTargetKey& TargetKey) const
+    {
+        const FSyStateSnapshotPtr* Snapshot = SnapshotCache.Find(TargetKey);
+        return Snapshot ? *Snapshot : FSyStateSnapshotPtr();
+    }
+
+    /**
+     * @brief 合并祖先链上各类型的快照，尽量复用上一版本有效快照中未变化的条目
+     * @param TypeTag 目标类型标签
+     * @param Previous 上一版本的有效快照（可为空）
+     * @return 新的有效快照；内容未变化时返回 Previous
+     * @note 不解码：调用方保证祖先链已解码（有效快照缓存中的类型总是满足）。
+     */
+    FSyStateSnapshotPtr BuildEffectiveTypeSnapshot(const FGameplayTag& TypeTag, const FSyStateSnapshotPtr& Previous) const;
+
+    /**
+     * @brief 重建祖先链包含任一变化类型的已缓存有效快照
+     * @param ChangedTypeTags 本次派发中快照发生变化的类型标签
+     */
+    void RefreshEffectiveTypeSnapshots(const TSet<FGameplayTag>& ChangedTypeTags);
+
+    /**
+     * @brief 为已订阅的子类型补充通知：父类型变化时其所有后代类型的订阅者也需要同步
+     * @param Notifications 本次派发的通知表（输入输出）
+     */
+    void AddDescendantTypeNotifications(TMap<FSyStateTargetKey, FSyTargetStateChange>& Notifications) const;
+
+    /**
+     * @brief 获取指定目标本批次的工作快照（首次访问时从已发布快照浅拷贝条目表）
+     * @param TargetKey 目标路由键
+     * @return 可修改的工作快照
+     */
+    FSyStateSnapshot& GetWorkingSnapshot(const FSyStateTargetKey& TargetKey);
     
     /**
-     * @brief 精准广播状态修改事件给相关订阅者
-     * @param Record 状态修改记录
+     * @brief 精准广播合并后的目标变化给相关订阅者
+     * @param Change 目标在本派发周期内的合并变化
      */
-    void BroadcastToSubscribers(const FSyStateModificationRecord& Record);
+    void BroadcastToSubscribers(const FSyTargetStateChange& Change);
     
     /**
      * @brief 清理无效的订阅者（在订阅列表中定期调用）
@@ -239,6 +1098,41 @@ private:
     void CleanupInvalidSubscribers();
 
     // TODO: [拓展] 日志管理
-    // - 日志大小限制与清理策略
+    // - 日志大小限制（可据此自动触发 StartIncrementalCompaction）
     // - 考虑更频繁或更智能的保存时机（例如，定期、特定事件触发）
 };
+
+/**
+ * @brief 批处理作用域：构造时 BeginBatch，析构时 CommitBatch。
+ *
+ * 用法:
+ * {
+ *     FSyStateManagerBatchScope BatchScope(StateManager);
+ *     StateManager->RecordOperation(OpA);
+ *     StateManager->RecordOperation(OpB);
+ * } // 此处每个受影响目标只通知一次
+ */
+struct FSyStateManagerBatchScope
+{
+    explicit FSyStateManagerBatchScope(USyStateManagerSubsystem* InStateManager)
+        : StateManager(InStateManager)
+    {
+        if (StateManager)
+        {
+            StateManager->BeginBatch();
+        }
+    }
+
+    ~FSyStateManagerBatchScope()
+    {
+        if (StateManager)
+        {
+            StateManager->CommitBatch();
+        }
+    }
+
+    UE_NONCOPYABLE(FSyStateManagerBatchScope);
+
+private:
+    USyStateManagerSubsystem* StateManager;
+};
@@ -0,0 +1,141 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineBaseTypes.h"
+#include "UObject/ObjectKey.h"
+#include "State/SyStateComponent.h"
+#include "SyStateUpdateSubsystem.generated.h"
+
+class USyStateUpdateSubsystem;
+
+/**
+ * @brief 每帧执行一次批量状态同步的 Tick 函数
+ */
+struct FSyStateUpdateTickFunction : public FTickFunction
+{
+    /** 所属的子系统 */
+    USyStateUpdateSubsystem* Owner = nullptr;
+
+    //~ Begin FTickFunction Interface
+    virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+    virtual FString DiagnosticMessage() override;
+    virtual FName DiagnosticContext(bool bDetailed) override;
+    //~ End FTickFunction Interface
+};
+
+/**
+ * USyStateUpdateSubsystem - 世界级批量状态同步
+ *
+ * 已注册的 USyStateComponent 收到 StateManager 的延迟通知后只标记待同步，
+ * 本子系统在帧末（TG_LastDemotable，晚于 StateManager 的派发 Tick）统一处理：
+ * 1. 游戏线程：取各实体的最新快照并比较差异
+ * 2. 应用差异、重算有效状态、取出变化：紧凑存储的实体互不相关，ParallelFor 并行处理；
+ *    元数据对象存储的实体会创建 UObject，在游戏线程依次处理
+ * 3. 游戏线程：按实体派发变化事件
+ * 每个实体的同步数据在连续数组中存放，注册 / 注销为 O(1)。
+ */
+UCLASS()
+class SYCORE_API USyStateUpdateSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    //~ Begin USubsystem Interface
+    virtual void Deinitialize() override;
+    //~ End USubsystem Interface
+
+    //~ Begin UWorldSubsystem Interface
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    //~ End UWorldSubsystem Interface
+
+    /** 注册状态组件（由 USyStateComponent 初始化完成时调用） */
+    void RegisterComponent(USyStateComponent* Component);
+
+    /** 注销状态组件（由 USyStateComponent::EndPlay 调用） */
+    void UnregisterComponent(USyStateComponent* Component);
+
+    /**
+     * @brief 标记组件需要在本帧的批量同步中处理
+     * @return 组件未注册或 Tick 不可用时返回 false，调用方应立即同步
+     */
+    bool RequestUpdate(USyStateComponent* Component);
+
+    /** 立即处理全部待同步的组件（例如需要在本帧内读取同步结果时） */
+    UFUNCTION(BlueprintCallable, Category = "SyState|Update")
+    void FlushPendingUpdates();
+
+    /** 已注册的组件数量 */
+    UFUNCTION(BlueprintPure, Category = "SyState|Update")
+    int32 GetNumRegisteredComponents() const { return EntryIndices.Num() + DeferredRegistrations.Num(); }
+
+    /** 待同步的组件数量 */
+    UFUNCTION(BlueprintPure, Category = "SyState|Update")
+    int32 GetNumPendingUpdates() const { return PendingIndices.Num(); }
+
+    /** 并行处理的最小批量：待并行处理的实体少于此数时在游戏线程直接处理 */
+    UPROPERTY(BlueprintReadWrite, Category = "SyState|Update")
+    int32 MinParallelBatchSize = 16;
+
+protected:
+    //~ Begin UWorldSubsystem Interface
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+    //~ End UWorldSubsystem Interface
+
+private:
+    /** 一个实体的同步数据 */
+    struct FEntry
+    {
+        /** 状态组件（弱引用：组件未经注销即被销毁时失效，处理时跳过并移除；批量处理中注销时置空） */
+        TWeakObjectPtr<USyStateComponent> Component;
+
+        /** EntryIndices 中的键（组件失效后仍可用于移除） */
+        TObjectKey<USyStateComponent> Key;
+
+        /** 是否已在待同步列表中 */
+        bool bPending = false;
+
+        /** 本次同步的输入 */
+        FSyStateSyncRequest Request;
+
+        /** 本次同步产生的有效状态变化 */
+        FSyEffectiveStateChange Change;
+        bool bHasChange = false;
+    };
+
+    /** 实体同步数据（连续存放，注销时与末尾交换） */
+    TArray<FEntry> Entries;
+
+    /** 组件 -> Entries 下标 */
+    TMap<TObjectKey<USyStateComponent>, int32> EntryIndices;
+
+    /** 待同步的 Entries 下标 */
+    TArray<int32> PendingIndices;
+
+    /** 批量处理中注册的组件（处理结束后再加入 Entries） */
+    TArray<TWeakObjectPtr<USyStateComponent>> DeferredRegistrations;
+
+    /** 批量处理中注销或已失效的条目数量（处理结束后统一移除） */
+    int32 NumRemovedEntries = 0;
+
+    /** 正在批量处理（此时 Entries 不增不减，条目引用保持有效） */
+    bool bIsUpdating = false;
+
+    FSyStateUpdateTickFunction UpdateTickFunction;
+
+    void RegisterTickFunction(UWorld& InWorld);
+    void UnregisterTickFunction();
+
+    /** 移除条目并修正被移动条目的下标 */
+    void RemoveEntryAt(int32 EntryIndex);
+
+    /** 加入 Entries（调用方保证未在批量处理中） */
+    void AddEntry(USyStateComponent* Component);
+
+    /** 移除批量处理中注销或已失效的条目 */
+    void RemoveUnregisteredEntries();
+
+    friend struct FSyStateUpdateTickFunction;
+};
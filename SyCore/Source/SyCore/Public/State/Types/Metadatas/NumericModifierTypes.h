@@ -0,0 +1,157 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Foundation/SyInstancedStruct.h"
+#include "StructUtils/InstancedStruct.h"
+#include "NumericModifierTypes.generated.h"
+
+/**
+ * @brief 数值修饰的运算方式
+ * 聚合顺序固定，与记录先后无关：Override -> Add -> Multiply -> Max(下限) -> Min(上限)
+ */
+UENUM(BlueprintType)
+enum class ESyModifierOp : uint8
+{
+    /** 设置基础值（多个时以最后聚合的为准） */
+    Override,
+
+    /** 加法（用于 伤害 / 治疗） */
+    Add,
+
+    /** 乘法（用于 百分比加成） */
+    Multiply,
+
+    /** 上限：结果不超过 Value */
+    Min,
+
+    /** 下限：结果不低于 Value */
+    Max,
+
+    /** 限制在 [Value, ClampMax] 之间 */
+    Clamp
+};
+
+/**
+ * @brief 数值修饰作用的值类型
+ */
+UENUM(BlueprintType)
+enum class ESyNumericValueType : uint8
+{
+    /** 作用于 FSyFloatValue */
+    Float,
+
+    /** 作用于 FSyIntValue（结果四舍五入） */
+    Int
+};
+
+/**
+ * @brief 数值修饰参数
+ * 作为操作的状态参数使用。同一状态标签上的修饰不会互相覆盖，而是累积到 FSyNumericModifierStack，
+ * 聚合结果同时写出对应的 FSyFloatValue / FSyIntValue，元数据按原有方式读取。
+ */
+USTRUCT(BlueprintType)
+struct SYCORE_API FSyNumericModifier : public FSyBaseInstancedStruct
+{
+    GENERATED_BODY()
+
+    /** 运算方式 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Value")
+    ESyModifierOp Op = ESyModifierOp::Add;
+
+    /** 作用的值类型 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Value")
+    ESyNumericValueType ValueType = ESyNumericValueType::Float;
+
+    /** 操作数（Clamp 时为下限） */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Value")
+    float Value = 0.0f;
+
+    /** Clamp 的上限 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Value", meta=(EditCondition="Op == ESyModifierOp::Clamp", EditConditionHides))
+    float ClampMax = 0.0f;
+
+    FSyNumericModifier() = default;
+    FSyNumericModifier(ESyModifierOp InOp, float InValue, ESyNumericValueType InValueType = ESyNumericValueType::Float)
+        : Op(InOp), ValueType(InValueType), Value(InValue) {}
+};
+
+/**
+ * @brief 一个状态标签上累积的数值修饰（聚合结果的一部分）
+ * 各运算的操作数按通道存放在连续的 float 数组中，求值是对每个通道的向量化归约
+ * （求和 / 求积 / 最大 / 最小），卸载后重算不需要逐个合并 FInstancedStruct。
+ */
+USTRUCT(BlueprintType)
+struct SYCORE_API FSyNumericModifierStack : public FSyBaseInstancedStruct
+{
+    GENERATED_BODY()
+
+    /** 作用的值类型 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    ESyNumericValueType ValueType = ESyNumericValueType::Float;
+
+    /** 是否有基础值（Override 修饰或覆盖写入的数值）；没有时由读取方提供（如组件的 Default 层） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    bool bHasBase = false;
+
+    /** 基础值 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    float BaseValue = 0.0f;
+
+    /** Add 通道 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    TArray<float> Addends;
+
+    /** Multiply 通道 */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    TArray<float> Multipliers;
+
+    /** 下限通道（Max / Clamp） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    TArray<float> LowerBounds;
+
+    /** 上限通道（Min / Clamp） */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Value")
+    TArray<float> UpperBounds;
+
+    /** 追加一个修饰 */
+    void AddModifier(const FSyNumericModifier& Modifier);
+
+    /** 追加另一个修饰栈（另一栈有基础值时覆盖本栈的基础值） */
+    void Append(const FSyNumericModifierStack& Other);
+
+    /** 设置基础值 */
+    void SetBase(float InBaseValue)
+    {
+        bHasBase = true;
+        BaseValue = InBaseValue;
+    }
+
+    /**
+     * @brief 求值：(基础值 + ΣAdd) × ΠMultiply，再依次应用下限与上限（下限大于上限时以上限为准）
+     * @param FallbackBase 没有基础值时使用的基础值
+     */
+    float Evaluate(float FallbackBase = 0.0f) const;
+
+    /** 值类型对应的数值结构体（FSyFloatValue / FSyIntValue） */
+    const UScriptStruct* GetValueStruct() const { return GetValueStruct(ValueType); }
+    static const UScriptStruct* GetValueStruct(ESyNumericValueType InValueType);
+
+    /**
+     * @brief 聚合时处理数值相关的参数（由 USyStateManagerSubsystem::MergeStateParams 调用）
+     * @param ExistingParams 已聚合的参数
+     * @param SourceStruct 要合并的参数
+     * @param SourceParams SourceStruct 所在的参数数组（其中修饰栈的求值输出不会被当作基础值）
+     * @return 已处理返回 true；不是数值修饰相关的参数返回 false，由调用方按原有规则合并
+     */
+    static bool MergeParam(TArray<FInstancedStruct>& ExistingParams, const FInstancedStruct& SourceStruct, const TArray<FInstancedStruct>& SourceParams);
+
+    /** 参数中是否有缺少基础值的修饰栈 */
+    static bool HasUnbasedStack(const TArray<FInstancedStruct>& Params);
+
+    /**
+     * @brief 以 FallbackValues 中的数值为基础，重新写出缺少基础值的修饰栈的结果
+     * @param Params 要更新的参数
+     * @param FallbackValues 提供基础值的数值参数（FSyFloatValue / FSyIntValue）
+     */
+    static void ResolveWithFallback(TArray<FInstancedStruct>& Params, const TArray<FInstancedStruct>& FallbackValues);
+};
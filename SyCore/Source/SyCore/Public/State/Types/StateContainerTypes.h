@@ -6,10 +6,14 @@
 #include "GameplayTagContainer.h"
 #include "O_TagMetadata.h" // Needed for UO_TagMetadata
 #include "State/Types/StateParameterTypes.h" // Needed for FSyStateParams and FSyStateParameterSet
+#include "State/StateValueArena.h"
+#include "UObject/ObjectKey.h"
 #include "StateContainerTypes.generated.h"
 
 // Forward Declarations
 struct FSyStateParameterSet; // Forward declare the renamed struct
+struct FSySharedStateLayer;
+class USyStateMetadataBase;
 
 /**
  * ESyStateLayer - 状态层级枚举
@@ -93,6 +97,25 @@ struct SYCORE_API FSyStateCategories
 	/** 默认构造函数 */
 	FSyStateCategories() = default;
 
+	/** 拷贝只共享元数据对象，不继承其所有权：拷贝出的集合不会把这些对象归还到池中 */
+	FSyStateCategories(const FSyStateCategories& Other)
+		: StateData(Other.StateData)
+	{
+	}
+
+	FSyStateCategories& operator=(const FSyStateCategories& Other)
+	{
+		if (this != &Other)
+		{
+			StateData = Other.StateData;
+			AcquiredMetadata.Reset();
+		}
+		return *this;
+	}
+
+	FSyStateCategories(FSyStateCategories&&) = default;
+	FSyStateCategories& operator=(FSyStateCategories&&) = default;
+
 	/** 状态数据映射：状态标签 -> TagMetadata对象数组 */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "SyStateCore|EntityState")
 	TMap<FGameplayTag, FSyStateMetadatas> StateData;
@@ -162,8 +185,22 @@ struct SYCORE_API FSyStateCategories
 	void Empty()
 	{
 		StateData.Empty();
+		AcquiredMetadata.Reset();
+		bMetadataHandedOut = false;
 	}
 
+	/** 清除指定标签，并把本集合从池中取出的元数据对象归还到 FSyStateMetadataPool */
+	void ReleaseStateMetadata(const FGameplayTag& StateTag);
+
+	/** 清除所有状态数据，并把本集合从池中取出的元数据对象归还到 FSyStateMetadataPool */
+	void ReleaseAllMetadata();
+
+	/**
+	 * 标记本集合的元数据对象已交给可能长期持有指针的调用方（如蓝图）：
+	 * 此后移除的对象直接交给 GC，不再回到池中被其它实体复用。清空集合后重新计算。
+	 */
+	void MarkMetadataHandedOut() const { bMetadataHandedOut = true; }
+
 	/** 批量应用初始化数据 */
     void ApplyInitData(const FSyStateParameterSet& InitData);
 
@@ -176,7 +213,12 @@ struct SYCORE_API FSyStateCategories
     /** 获取内部数据Map的常量引用 (供 GetEffectiveStateCategories 使用) */
 	const TMap<FGameplayTag, FSyStateMetadatas>& GetStateDataMap() const { return StateData; }
 
-	/** 添加或更新指定Tag下的元数据 */
+	/**
+	 * @brief 用一组参数更新指定Tag下的元数据，尽量复用已有的元数据对象。
+	 *        参数中不存在的元数据类型会被移除（与 UpdateFromParameterMap 的单标签语义一致）。
+	 * @param StateTag 状态标签
+	 * @param NewParams 该标签的完整参数
+	 */
 	void AddOrUpdateMetadataParam(const FGameplayTag& StateTag, const TArray<FInstancedStruct>& NewParams);
 
 	/**
@@ -189,6 +231,8 @@ struct SYCORE_API FSyStateCategories
 
 	/**
 	 * @brief 自定义序列化函数，确保 UObject 元数据正确序列化
+	 *        以带版本的紧凑格式写出：元数据类与值类型各写一次路径（类型表），条目按下标引用，
+	 *        值结构体按属性分段写出（属性结构记在类型表中，布局变化后按属性名读取）；读取时兼容旧的逐对象类路径格式
 	 */
 	bool Serialize(FArchive& Ar);
 
@@ -196,6 +240,19 @@ struct SYCORE_API FSyStateCategories
 	 * @brief 序列化后处理，用于重建对象引用
 	 */
 	void PostSerialize(const FArchive& Ar);
+
+private:
+	/** 从池中取出元数据对象并记为本集合所有 */
+	USyStateMetadataBase* AcquireMetadata(UClass* MetadataClass);
+
+	/** 归还元数据对象：只有本集合取出的对象会回到池中，外部传入或共享的对象保持原样 */
+	void ReleaseMetadata(UO_TagMetadata* Metadata);
+
+	/** 本集合从池中取出（或读档时创建）的元数据对象 */
+	TSet<TObjectKey<UO_TagMetadata>> AcquiredMetadata;
+
+	/** 元数据对象已交给外部持有，移除时不归还到池中 */
+	mutable bool bMetadataHandedOut = false;
 };
 
 // 添加序列化支持
@@ -209,6 +266,40 @@ struct TStructOpsTypeTraits<FSyStateCategories> : public TStructOpsTypeTraitsBas
 	};
 };
 
+/**
+ * FSyEffectiveStateChange - 一次有效状态变化
+ *
+ * 只包含有效值可能改变的标签：被更高层遮盖的低层修改不计入。
+ */
+struct SYCORE_API FSyEffectiveStateChange
+{
+	/** 有效值可能改变的状态标签 */
+	FGameplayTagContainer ChangedTags;
+
+	/** 发生修改的层级（按 ESyStateLayer 的位掩码） */
+	uint8 ChangedLayers = 0;
+
+	/** 全部标签都可能改变（初始化广播、层级被整体替换等），此时 ChangedTags 为空 */
+	bool bAllTags = false;
+
+	/** 该标签的有效值是否可能改变 */
+	bool AffectsTag(const FGameplayTag& StateTag) const
+	{
+		return bAllTags || ChangedTags.HasTagExact(StateTag);
+	}
+
+	/** 该层级是否被修改 */
+	bool HasLayer(ESyStateLayer Layer) const
+	{
+		return (ChangedLayers & (1 << static_cast<uint8>(Layer))) != 0;
+	}
+
+	bool IsEmpty() const
+	{
+		return !bAllTags && ChangedTags.IsEmpty();
+	}
+};
+
 /**
  * FSyLayeredStateContainer - 分层状态容器
  *
@@ -223,20 +314,42 @@ struct SYCORE_API FSyLayeredStateContainer
 	/** 默认构造函数 */
 	FSyLayeredStateContainer() = default;
 
+	/**
+	 * @brief 切换运行时存储方式（会清空全部层级）
+	 * @param bEnable 为 true 时各层的值以紧凑值结构体保存在 FSyStateValueArena 中，不创建元数据 UObject；
+	 *        元数据对象只在通过 GetLayer / GetEffectiveState / FindEffectiveMetadatas 读取时按需生成
+	 * @note 紧凑存储的层级数据只存在于运行时，不随 SaveGame 序列化（由初始化数据与 StateManager 重建）
+	 */
+	void SetPackedValueStorage(bool bEnable);
+
+	/** 是否使用紧凑值存储 */
+	bool UsesPackedValueStorage() const { return bPackedValues; }
+
 	/**
 	 * @brief 获取指定层级的状态容器
 	 * @param Layer 状态层级
 	 * @return 该层级的状态容器引用
+	 * @note 调用方可能任意修改该层，有效状态缓存会整体重建；只修改个别标签请使用 ApplyTagParamsToLayer / RemoveTagFromLayer
+	 *       紧凑存储模式下不支持，请使用 ApplyTagParamsToLayer / RemoveTagFromLayer / SetLayer
 	 */
 	FSyStateCategories& GetLayer(ESyStateLayer Layer);
 
 	/**
 	 * @brief 获取指定层级的状态容器（只读）
 	 * @param Layer 状态层级
-	 * @return 该层级的状态容器常量引用
+	 * @return 该层级的状态容器常量引用；紧凑存储模式下为按需生成的元数据视图
 	 */
 	const FSyStateCategories& GetLayer(ESyStateLayer Layer) const;
 
+	/**
+	 * @brief 取出指定层级中某个状态标签的全部值（两种存储方式均可用）
+	 * @param Layer 状态层级
+	 * @param StateTag 状态标签
+	 * @param OutValues 追加的值
+	 * @return 该层包含此标签时返回 true
+	 */
+	bool GetLayerTagValues(ESyStateLayer Layer, const FGameplayTag& StateTag, TArray<FInstancedStruct>& OutValues) const;
+
 	/**
 	 * @brief 设置指定层级的完整状态
 	 * @param Layer 状态层级
@@ -252,9 +365,58 @@ struct SYCORE_API FSyLayeredStateContainer
 
 	/**
 	 * @brief 获取合并后的有效状态（按优先级从低到高合并）
-	 * @return 所有层级合并后的最终状态
+	 * @return 缓存的最终状态的常量引用，容器下次被修改前有效
+	 * @note 各层的修改只标记涉及的状态标签，读取时只重算这些标签；只读取少数标签时使用 FindEffectiveMetadatas
 	 */
-	FSyStateCategories GetEffectiveState() const;
+	const FSyStateCategories& GetEffectiveState() const;
+
+	/**
+	 * @brief 标记各层与有效状态中的元数据对象已交给蓝图等外部调用方，之后移除的对象不再入池复用
+	 * @note 由返回整个状态集合的蓝图接口调用；只按标签读取值的接口不需要
+	 */
+	void MarkMetadataHandedOut() const;
+
+	/**
+	 * @brief 查找单个状态标签最终生效的元数据（从 Override 层向 Default 层查找，第一个包含该标签的层胜出）
+	 * @param StateTag 状态标签
+	 * @return 胜出层中该标签的元数据数组，没有任何层包含该标签时返回 nullptr
+	 */
+	const FSyStateMetadatas* FindEffectiveMetadatas(const FGameplayTag& StateTag) const;
+
+	/**
+	 * @brief 查找单个状态标签最终生效的第一个指定类型的元数据
+	 * @param StateTag 状态标签
+	 * @return 找到的元数据对象，找不到返回 nullptr
+	 */
+	template<typename T>
+	T* FindEffectiveStateMetadata(const FGameplayTag& StateTag) const;
+
+	/**
+	 * @brief 查找单个状态标签最终生效的指定类型的值（紧凑存储模式下不拷贝、不生成元数据对象）
+	 * @param StateTag 状态标签
+	 * @param ValueType 值类型（如 FSyBoolValue）
+	 * @param OutValue 找到时填充
+	 * @return 胜出层中有该类型的值时返回 true
+	 */
+	bool GetEffectiveValue(const FGameplayTag& StateTag, const UScriptStruct* ValueType, FInstancedStruct& OutValue) const;
+
+	template<typename T>
+	bool GetEffectiveValue(const FGameplayTag& StateTag, T& OutValue) const;
+
+	/**
+	 * @brief 取出单个状态标签最终生效的第一个有效值
+	 * @return 找到时返回 true
+	 */
+	bool GetFirstEffectiveValue(const FGameplayTag& StateTag, FInstancedStruct& OutValue) const;
+
+	/**
+	 * @brief 紧凑存储模式下，单个状态标签最终生效的指定类型的值的地址
+	 * @return 值的地址，容器版本号变化前有效；非紧凑存储或找不到时返回 nullptr
+	 */
+	const void* FindEffectivePackedValue(const FGameplayTag& StateTag, const UScriptStruct* ValueType) const;
+
+	/** 版本号：任何层级的任何修改都会递增，用于 FSyStateValueHandle 等缓存的失效判断 */
+	uint32 GetVersion() const { return Version; }
 
 	/**
 	 * @brief 检查指定层级是否有数据
@@ -275,6 +437,33 @@ struct SYCORE_API FSyLayeredStateContainer
 	 */
 	void ApplyParameterSetToLayer(ESyStateLayer Layer, const FSyStateParameterSet& ParamSet);
 
+	/**
+	 * @brief 以共享方式设置 Default 层（语义与 ApplyParameterSetToLayer 相同）
+	 *        内容相同的参数集在所有容器间共享同一份只读层（FSySharedStateLayerCache），
+	 *        直到本容器写入 Default 层时才拷贝出私有的一份（写时复制）。
+	 * @param ParamSet 要应用的参数集
+	 * @note 共享层的元数据对象被多个实体引用，不要直接修改 FindEffectiveStateMetadata 等返回的对象
+	 */
+	void SetSharedDefaultLayer(const FSyStateParameterSet& ParamSet);
+
+	/** Default 层当前是否为共享层 */
+	bool IsDefaultLayerShared() const { return SharedDefaultLayer.IsValid(); }
+
+	/**
+	 * @brief 只更新指定层级中单个状态标签的参数（其余标签保持不变）
+	 * @param Layer 目标层级
+	 * @param StateTag 状态标签
+	 * @param Params 该标签的完整参数
+	 */
+	void ApplyTagParamsToLayer(ESyStateLayer Layer, const FGameplayTag& StateTag, const TArray<FInstancedStruct>& Params);
+
+	/**
+	 * @brief 从指定层级移除单个状态标签
+	 * @param Layer 目标层级
+	 * @param StateTag 状态标签
+	 */
+	void RemoveTagFromLayer(ESyStateLayer Layer, const FGameplayTag& StateTag);
+
 	/**
 	 * @brief 从特定层级查找状态元数据
 	 * @param Layer 状态层级
@@ -284,31 +473,152 @@ struct SYCORE_API FSyLayeredStateContainer
 	template<typename T>
 	T* FindStateMetadataInLayer(ESyStateLayer Layer, const FGameplayTag& StateTag) const;
 
+	/**
+	 * @brief 取出上次调用以来累积的有效状态变化，并清空累积
+	 * @param OutChange 变化的标签与层级；只修改被更高层遮盖的标签不计入
+	 * @return 有变化时返回 true
+	 */
+	bool ConsumeEffectiveChanges(FSyEffectiveStateChange& OutChange);
+
+	/** 序列化后处理：层级数据被整体替换，有效状态缓存需要重建 */
+	void PostSerialize(const FArchive& Ar);
+
+	/** 报告紧凑存储中的值与按需生成的元数据对象（由持有者的 AddReferencedObjects 调用） */
+	void AddReferencedObjects(FReferenceCollector& Collector);
+
 private:
-	/** 各层级的状态容器 */
+	/** 各层级的状态容器（按 ESyStateLayer 索引）；紧凑存储模式下为按需生成的元数据视图 */
 	UPROPERTY(VisibleAnywhere, Category = "SyStateCore|LayeredState")
-	TMap<ESyStateLayer, FSyStateCategories> StateLayers;
+	FSyStateCategories StateLayers[(int32)ESyStateLayer::MAX];
+
+	/** 是否使用紧凑值存储 */
+	bool bPackedValues = false;
+
+	/** 紧凑存储模式下各层级的值（按 ESyStateLayer 索引） */
+	FSyStateValueArena LayerValues[(int32)ESyStateLayer::MAX];
+
+	/** 紧凑存储模式下各层级的元数据视图是否需要重建 */
+	mutable bool bLayerViewDirty[(int32)ESyStateLayer::MAX] = {};
 
 	/** 缓存的有效状态（用于性能优化） */
 	mutable FSyStateCategories CachedEffectiveState;
 
-	/** 缓存版本号（用于失效检测） */
-	mutable int32 CacheVersion = 0;
+	/** 有效状态需要重算的状态标签 */
+	mutable TSet<FGameplayTag> DirtyTags;
+
+	/** 有效状态需要整体重建（层级被整体替换或可能被任意修改） */
+	mutable bool bCacheFullyDirty = true;
+
+	/** 尚未取出的变化：状态标签 -> 修改过该标签的层级位掩码 */
+	TMap<FGameplayTag, uint8> PendingChangedTags;
+
+	/** 尚未取出的变化涉及的层级位掩码 */
+	uint8 PendingChangedLayers = 0;
+
+	/** 尚未取出的变化涉及全部标签 */
+	bool bPendingAllTags = false;
+
+	/** 修改版本号 */
+	uint32 Version = 0;
+
+	/** 共享的 Default 层（有效时 Default 层的私有存储为空） */
+	TSharedPtr<const FSySharedStateLayer> SharedDefaultLayer;
+
+	/** 层级下标（越界时断言） */
+	static int32 ToLayerIndex(ESyStateLayer Layer)
+	{
+		const int32 LayerIndex = static_cast<int32>(Layer);
+		check(LayerIndex >= 0 && LayerIndex < static_cast<int32>(ESyStateLayer::MAX));
+		return LayerIndex;
+	}
+
+	/** 该层级当前是否为共享层 */
+	bool IsLayerShared(int32 LayerIndex) const
+	{
+		return LayerIndex == (int32)ESyStateLayer::Default && SharedDefaultLayer.IsValid();
+	}
+
+	/** 读取层级的元数据对象（共享层或私有存储） */
+	const FSyStateCategories& GetLayerState(int32 LayerIndex) const;
 
-	/** 当前版本号（每次修改递增） */
-	int32 CurrentVersion = 0;
+	/** 读取层级的紧凑值（共享层或私有存储） */
+	const FSyStateValueArena& GetLayerValues(int32 LayerIndex) const;
 
-	/** 使缓存失效 */
-	void InvalidateCache();
+	/** 写入共享层前拷贝出私有的一份 */
+	void MakeLayerPrivate(ESyStateLayer Layer);
+
+	/** 标记某层中一个状态标签的有效状态需要重算 */
+	void MarkTagDirty(ESyStateLayer Layer, const FGameplayTag& StateTag);
+
+	/** 标记某层当前包含的全部状态标签需要重算 */
+	void MarkLayerTagsDirty(ESyStateLayer Layer, const FSyStateCategories& LayerState);
+
+	/** 使整个缓存失效（Layer 为 MAX 时表示所有层） */
+	void InvalidateCache(ESyStateLayer Layer = ESyStateLayer::MAX);
+
+	/** 指定层级是否包含该标签（两种存储方式均可用） */
+	bool LayerContainsTag(int32 LayerIndex, const FGameplayTag& StateTag) const;
+
+	/** 从高到低第一个包含该标签的层级，没有时返回 INDEX_NONE */
+	int32 FindWinningLayer(const FGameplayTag& StateTag) const;
+
+	/** 紧凑存储：按标签的结构描述筛选并写入值（与 AddOrUpdateMetadataParam 保留的值一致） */
+	static void SetPackedTagValues(FSyStateValueArena& Values, const FGameplayTag& StateTag, const TArray<FInstancedStruct>& Params);
+
+	/** 紧凑存储：标记某层全部标签需要重算 */
+	void MarkPackedLayerTagsDirty(ESyStateLayer Layer);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSyLayeredStateContainer> : public TStructOpsTypeTraitsBase2<FSyLayeredStateContainer>
+{
+	enum
+	{
+		WithPostSerialize = true,
+	};
 };
 
 // 模板实现
 template<typename T>
-T* FSyLayeredStateContainer::FindStateMetadataInLayer(ESyStateLayer Layer, const FGameplayTag& StateTag) const
+T* FSyLayeredStateContainer::FindEffectiveStateMetadata(const FGameplayTag& StateTag) const
 {
-	if (const FSyStateCategories* LayerState = StateLayers.Find(Layer))
+	if (const FSyStateMetadatas* Metadatas = FindEffectiveMetadatas(StateTag))
 	{
-		return LayerState->FindFirstStateMetadata<T>(StateTag);
+		for (const TObjectPtr<UO_TagMetadata>& Metadata : Metadatas->MetadataArray)
+		{
+			if (T* TypedMetadata = Cast<T>(Metadata))
+			{
+				return TypedMetadata;
+			}
+		}
 	}
 	return nullptr;
 }
+
+template<typename T>
+T* FSyLayeredStateContainer::FindStateMetadataInLayer(ESyStateLayer Layer, const FGameplayTag& StateTag) const
+{
+	return GetLayer(Layer).FindFirstStateMetadata<T>(StateTag);
+}
+
+template<typename T>
+bool FSyLayeredStateContainer::GetEffectiveValue(const FGameplayTag& StateTag, T& OutValue) const
+{
+	if (bPackedValues)
+	{
+		if (const T* Value = static_cast<const T*>(FindEffectivePackedValue(StateTag, T::StaticStruct())))
+		{
+			OutValue = *Value;
+			return true;
+		}
+		return false;
+	}
+
+	FInstancedStruct Value;
+	if (GetEffectiveValue(StateTag, T::StaticStruct(), Value))
+	{
+		OutValue = Value.Get<T>();
+		return true;
+	}
+	return false;
+}
@@ -84,6 +84,12 @@ public:
         return Result;
     }
 
+    /**
+     * 归还到对象池前重置：清空状态标签，值恢复为类默认对象的值。
+     * 带有额外运行时状态的子类应重载并调用父类实现。
+     */
+    virtual void ResetForReuse();
+
     /** 设置特定类型的值（C++ 使用） */
     template<typename T>
     void SetValue(const T& InValue)
@@ -31,8 +31,9 @@ void USyInteractionComponent::OnSyComponentInitialized()
     
     if (CachedStateComponent)
     {
-        // 1. 绑定状态变化监听（监听后续变化）
-        CachedStateComponent->OnEffectiveStateChanged.AddUObject(this, &USyInteractionComponent::HandleStateChanged);
+        // 1. 绑定状态变化监听（只监听 State.Interact.Interactable 的后续变化）
+        CachedStateComponent->OnStateTagChanged(FGameplayTag::RequestGameplayTag(TEXT("State.Interact.Interactable")))
+            .AddWeakLambda(this, [this](const FGameplayTag&) { HandleStateChanged(); });
         
         // 2. ✅ 主动处理初始状态（因为 StateComponent 的广播已经在 Core 阶段完成）
         HandleStateChanged();
@@ -49,7 +50,7 @@ void USyInteractionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
     if (CachedStateComponent)
     {
-        CachedStateComponent->OnEffectiveStateChanged.RemoveAll(this);
+        CachedStateComponent->RemoveStateTagListeners(this);
     }
 
     Super::EndPlay(EndPlayReason);
@@ -94,27 +95,10 @@ void USyInteractionComponent::HandleStateChanged()
     }
 
     const FGameplayTag InteractableTag = FGameplayTag::RequestGameplayTag(TEXT("State.Interact.Interactable"));
-    const FSyStateCategories& CurrentState = CachedStateComponent->GetEffectiveStateCategories();
-    
-    if (USyStateMetadataBase* Metadata = CurrentState.FindFirstStateMetadata<USyStateMetadataBase>(InteractableTag))
+    FSyBoolValue bIsInteractable = false;
+    if (CachedStateComponent->GetEffectiveStateValue(InteractableTag, bIsInteractable) && bIsInteractable.Value)
     {
-        FSyBoolValue bIsInteractable = false;
-        if (Metadata->TryGetValue(bIsInteractable))
-        {
-            if (bIsInteractable.Value)
-            {
-                Enable();
-            }
-            else
-            {
-                Disable();
-            }
-        }
-        else
-        {
-            UE_LOG(LogSyInteraction, Warning, TEXT("Actor %s: State.Interactable metadata found but is not FSyBoolValue."), *GetNameSafe(GetOwner()));
-            Disable();
-        }
+        Enable();
     }
     else
     {
@@ -137,8 +121,7 @@ void USyInteractionComponent::HandleInteractionRequest()
     // 进入交互后临时关闭，肯定有更合适的处理方式
     Disable();
 
-    const FSyStateCategories& CurrentState = CachedStateComponent->GetEffectiveStateCategories();
-    const USyInteractionListMetadata* ListMetadata = CurrentState.FindFirstStateMetadata<USyInteractionListMetadata>(InteractionListMetadataTag);
+    const USyInteractionListMetadata* ListMetadata = CachedStateComponent->FindEffectiveStateMetadata<USyInteractionListMetadata>(InteractionListMetadataTag);
 
     if (!ListMetadata)
     {
@@ -24,8 +24,9 @@ void USySpawnComponent::OnSyComponentInitialized()
     
     if (StateComponent)
     {
-        // 1. 绑定状态变化监听（监听后续变化）
-        StateComponent->OnEffectiveStateChanged.AddUObject(this, &USySpawnComponent::HandleStateChanged);
+        // 1. 绑定状态变化监听（只监听 State.Spawner.Enable 的后续变化）
+        StateComponent->OnStateTagChanged(FGameplayTag::RequestGameplayTag(TEXT("State.Spawner.Enable")))
+            .AddWeakLambda(this, [this](const FGameplayTag&) { HandleStateChanged(); });
         
         // 2. ✅ 主动处理初始状态（因为 StateComponent 的广播已经在 Core 阶段完成）
         HandleStateChanged();
@@ -43,7 +44,7 @@ void USySpawnComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
     // 解绑状态变化事件
     if (StateComponent)
     {
-        StateComponent->OnEffectiveStateChanged.RemoveAll(this);
+        StateComponent->RemoveStateTagListeners(this);
     }
 
     Super::EndPlay(EndPlayReason);
@@ -73,18 +74,15 @@ void USySpawnComponent::HandleStateChanged()
 
     // 检查"State.Spawner.Enable"标签的状态
     const FGameplayTag SpawnerEnableTag = FGameplayTag::RequestGameplayTag(TEXT("State.Spawner.Enable"));
-    const FSyStateCategories& CurrentState = StateComponent->GetEffectiveStateCategories();
-    
-    // 查找Spawner.Enable标签的第一个元数据
-    if (USyStateMetadataBase* Metadata = CurrentState.FindFirstStateMetadata<USyStateMetadataBase>(SpawnerEnableTag))
+    // 读取Spawner.Enable标签胜出的值（只查找该标签，不合并全部状态）
+    FInstancedStruct SpawnerEnableValue;
+    if (StateComponent->GetEffectiveStateParam(SpawnerEnableTag, SpawnerEnableValue))
     {
         // 尝试获取布尔值
-        FSyBoolValue bIsSpawnerEnabled = false;
-        
-        if (Metadata->TryGetValue(bIsSpawnerEnabled))
+        if (const FSyBoolValue* bIsSpawnerEnabled = SpawnerEnableValue.GetPtr<FSyBoolValue>())
         {
             // 根据状态更新生成能力
-            if (bIsSpawnerEnabled.Value)
+            if (bIsSpawnerEnabled->Value)
             {
                 // 如果生成器被启用，且当前没有生成的实体，则尝试生成
                 if (!SpawnedActor.IsValid())